@@ -30,336 +30,2839 @@
 #include <modules/tnm067lab2/processors/marchingtetrahedra.h>
 #include <inviwo/core/datastructures/geometry/basicmesh.h>
 #include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+#include <inviwo/core/util/glm.h>
 #include <inviwo/core/util/indexmapper.h>
 #include <inviwo/core/util/assertion.h>
+#include <inviwo/core/util/colorconversion.h>
+#include <inviwo/core/util/exception.h>
+#include <modules/tnm067lab2/utils/concurrentedgemap.h>
+#include <modules/tnm067lab2/utils/extractionstats.h>
+#include <modules/tnm067lab2/utils/isoclassifier.h>
+#include <modules/tnm067lab2/utils/isooctree.h>
+#include <modules/tnm067lab2/utils/mappedfile.h>
+#include <modules/tnm067lab2/utils/meshcache.h>
+#include <modules/tnm067lab2/utils/parallelfor.h>
+#include <modules/tnm067lab2/utils/marchingcubescases.h>
+#include <inviwo/core/common/inviwoapplication.h>
 #include <inviwo/core/network/networklock.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <initializer_list>
+#include <iterator>
+#include <sstream>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <utility>
+
 namespace inviwo {
 
-size_t MarchingTetrahedra::HashFunc::max = 1;
+namespace {
+
+namespace detail {
+
+constexpr size_t tetrahedraIds[6][4] = {{0, 1, 2, 5}, {1, 3, 2, 5}, {3, 2, 5, 7},
+                                        {0, 2, 4, 5}, {6, 4, 2, 5}, {6, 7, 5, 2}};
+
+/**
+ * The triangles of one tetrahedra case. Edges are given as pairs of tetrahedra corners and
+ * triangles as indices into edges. All six tetrahedra in tetrahedraIds have the same orientation,
+ * so a single table serves all of them; triangles are wound so that their face normals point
+ * towards lower values. Case 15 - i is case i with the winding reversed.
+ */
+struct TetrahedraCase {
+    int edgeCount;
+    int edges[4][2];
+    int triangleCount;
+    int triangles[2][3];
+};
+
+// clang-format off
+constexpr TetrahedraCase tetrahedraCases[16] = {
+    {0, {},                               0, {}},
+    {3, {{0, 1}, {0, 2}, {0, 3}},         1, {{0, 2, 1}}},
+    {3, {{0, 1}, {1, 2}, {1, 3}},         1, {{0, 1, 2}}},
+    {4, {{0, 2}, {0, 3}, {1, 2}, {1, 3}}, 2, {{1, 2, 3}, {0, 2, 1}}},
+    {3, {{0, 2}, {1, 2}, {2, 3}},         1, {{0, 2, 1}}},
+    {4, {{0, 1}, {0, 3}, {1, 2}, {2, 3}}, 2, {{0, 1, 2}, {1, 3, 2}}},
+    {4, {{0, 1}, {1, 3}, {0, 2}, {2, 3}}, 2, {{0, 2, 1}, {2, 3, 1}}},
+    {3, {{0, 3}, {1, 3}, {2, 3}},         1, {{0, 2, 1}}},
+    {3, {{0, 3}, {1, 3}, {2, 3}},         1, {{0, 1, 2}}},
+    {4, {{0, 1}, {1, 3}, {0, 2}, {2, 3}}, 2, {{0, 1, 2}, {2, 1, 3}}},
+    {4, {{0, 1}, {0, 3}, {1, 2}, {2, 3}}, 2, {{0, 2, 1}, {1, 2, 3}}},
+    {3, {{0, 2}, {1, 2}, {2, 3}},         1, {{0, 1, 2}}},
+    {4, {{0, 2}, {0, 3}, {1, 2}, {1, 3}}, 2, {{1, 3, 2}, {0, 1, 2}}},
+    {3, {{0, 1}, {1, 2}, {1, 3}},         1, {{0, 2, 1}}},
+    {3, {{0, 1}, {0, 2}, {0, 3}},         1, {{0, 1, 2}}},
+    {0, {},                               0, {}},
+};
+// clang-format on
+
+/**
+ * Parses a list of iso values separated by spaces, commas or semicolons.
+ */
+std::vector<float> parseIsoValues(std::string str) {
+    std::replace_if(str.begin(), str.end(), [](char c) { return c == ',' || c == ';'; }, ' ');
+    std::istringstream stream(str);
+    std::vector<float> isos;
+    float iso;
+    while (stream >> iso) {
+        isos.push_back(iso);
+    }
+    return isos;
+}
+
+/**
+ * Spatial positions in [0, 1] of the voxel planes along each axis.
+ */
+void voxelCoords(const size3_t& dims, std::vector<float> (&coords)[3]) {
+    for (size_t axis = 0; axis < 3; ++axis) {
+        coords[axis].resize(dims[axis]);
+        for (size_t i = 0; i < dims[axis]; ++i) {
+            coords[axis][i] = static_cast<float>(i / (dims[axis] - 1.0));
+        }
+    }
+}
+
+/**
+ * Memory allocated for the buffers of the mesh, which can be more than their contents take.
+ */
+size_t getSizeInBytes(const BasicMesh& mesh) {
+    size_t size =
+        mesh.getVertices()->getRAMRepresentation()->getDataContainer().capacity() * sizeof(vec3) +
+        mesh.getNormals()->getRAMRepresentation()->getDataContainer().capacity() * sizeof(vec3) +
+        mesh.getTexCoords()->getRAMRepresentation()->getDataContainer().capacity() *
+            sizeof(vec3) +
+        mesh.getColors()->getRAMRepresentation()->getDataContainer().capacity() * sizeof(vec4);
+    for (size_t i = 0; i < mesh.getNumberOfIndicies(); ++i) {
+        size += mesh.getIndices(i)->getRAMRepresentation()->getDataContainer().capacity() *
+                sizeof(std::uint32_t);
+    }
+    return size;
+}
+
+/**
+ * Gradient at the voxel, from central differences or one-sided ones at the border, in the
+ * [0, 1] space of the vertex positions given by coords. value(voxel) reads the volume.
+ */
+template <typename Value>
+vec3 gradient(const size3_t& voxel, const size3_t& dims, const std::vector<float> (&coords)[3],
+              Value value) {
+    vec3 g(0.0f);
+    for (size_t axis = 0; axis < 3; ++axis) {
+        size3_t lower(voxel);
+        size3_t upper(voxel);
+        if (lower[axis] > 0) --lower[axis];
+        if (upper[axis] + 1 < dims[axis]) ++upper[axis];
+        if (lower[axis] == upper[axis]) continue;
+        g[axis] = (value(upper) - value(lower)) /
+                  (coords[axis][upper[axis]] - coords[axis][lower[axis]]);
+    }
+    return g;
+}
+
+/**
+ * Whether the edge lies in the first plane of a slab starting at zBegin. The cells of the slab
+ * below share those edges, and create their vertices first.
+ */
+bool onSeam(const EdgeIndexCache::Key& key, size_t zBegin) {
+    return zBegin > 0 && key.plane == zBegin && EdgeIndexCache::inPlane(key);
+}
+
+/**
+ * Takes the place of a MeshHelper in the first pass of Allocation::CountThenFill. Counts the
+ * triangles of a slab and the vertices it creates, without computing any of them. Vertices on
+ * the seam to the slab below are counted there.
+ */
+class MeshCounter {
+public:
+    MeshCounter(size3_t dims, size_t zBegin)
+        : edgeCache_(dims), zBegin_(zBegin), vertexCount_(0), triangleCount_(0) {}
+
+    template <typename Create>
+    std::uint32_t addVertex(const size3_t& cell, size_t edge, Create) {
+        const auto key = edgeCache_.key(cell, edge);
+        auto& index = edgeCache_[key];
+        if (index == EdgeIndexCache::invalid) {
+            index = 0;
+            if (!onSeam(key, zBegin_)) ++vertexCount_;
+        }
+        return index;
+    }
+
+    void addTriangle(size_t, size_t, size_t) { ++triangleCount_; }
+
+    MarchingTetrahedra::Normals getNormalMode() const {
+        return MarchingTetrahedra::Normals::FaceAccumulated;
+    }
+
+    size_t getVertexCount() const { return vertexCount_; }
+    size_t getTriangleCount() const { return triangleCount_; }
+    size_t getSizeInBytes() const { return edgeCache_.getSizeInBytes(); }
+
+private:
+    EdgeIndexCache edgeCache_;
+    size_t zBegin_;
+    size_t vertexCount_;
+    size_t triangleCount_;
+};
+
+/**
+ * Takes the place of a MeshHelper in the second pass of Allocation::CountThenFill, writing the
+ * vertices and triangles of a slab straight into the buffers of the mesh. The vertices are
+ * numbered from firstVertex in the order they are created, as a MeshHelper would do. Vertices
+ * on the seam to the slab below get placeholder indices from firstPlaceholder on until
+ * resolveSeam is called.
+ */
+class MeshWriter {
+public:
+    struct Buffers {
+        vec3* positions;
+        vec3* normals;
+        vec3* texCoords;
+        vec4* colors;
+    };
+
+    MeshWriter(size3_t dims, size_t zBegin, MarchingTetrahedra::Normals normals, vec4 color,
+               Buffers buffers, std::uint32_t firstVertex, std::uint32_t* indices,
+               std::uint32_t firstPlaceholder)
+        : edgeCache_(dims)
+        , zBegin_(zBegin)
+        , normals_(normals)
+        , color_(color)
+        , buffers_(buffers)
+        , nextVertex_(firstVertex)
+        , indicesBegin_(indices)
+        , indices_(indices)
+        , firstPlaceholder_(firstPlaceholder)
+        , seam_() {}
+
+    template <typename Create>
+    std::uint32_t addVertex(const size3_t& cell, size_t edge, Create createVertex) {
+        const auto key = edgeCache_.key(cell, edge);
+        auto& index = edgeCache_[key];
+        if (index == EdgeIndexCache::invalid) {
+            if (onSeam(key, zBegin_)) {
+                index = firstPlaceholder_ + static_cast<std::uint32_t>(seam_.size());
+                seam_.push_back(key);
+                return index;
+            }
+            const std::pair<vec3, vec3> vertex = createVertex();
+            index = nextVertex_++;
+            buffers_.positions[index] = vertex.first;
+            buffers_.normals[index] =
+                normals_ == MarchingTetrahedra::Normals::Gradient ? vertex.second : vec3(0.0f);
+            buffers_.texCoords[index] = vertex.first;
+            buffers_.colors[index] = color_;
+        }
+        return index;
+    }
+
+    void addTriangle(size_t i0, size_t i1, size_t i2) {
+        *indices_++ = static_cast<std::uint32_t>(i0);
+        *indices_++ = static_cast<std::uint32_t>(i1);
+        *indices_++ = static_cast<std::uint32_t>(i2);
+    }
+
+    MarchingTetrahedra::Normals getNormalMode() const { return normals_; }
+
+    std::uint32_t getNextVertex() const { return nextVertex_; }
+    const std::uint32_t* getIndicesEnd() const { return indices_; }
+    size_t getSizeInBytes() const {
+        return edgeCache_.getSizeInBytes() + seam_.capacity() * sizeof(EdgeIndexCache::Key);
+    }
+
+    /**
+     * Replaces the placeholders in the triangles of the slab with the vertices created by the
+     * writer of the slab below, which has to be done.
+     */
+    void resolveSeam(const MeshWriter& below) {
+        if (seam_.empty()) return;
+
+        std::vector<std::uint32_t> vertices;
+        vertices.reserve(seam_.size());
+        for (const auto& key : seam_) {
+            vertices.push_back(below.edgeCache_.find(key));
+            ivwAssert(vertices.back() != EdgeIndexCache::invalid,
+                      "the slab below should have a vertex on every seam edge");
+        }
+        for (auto index = indicesBegin_; index != indices_; ++index) {
+            if (*index >= firstPlaceholder_) *index = vertices[*index - firstPlaceholder_];
+        }
+    }
+
+private:
+    EdgeIndexCache edgeCache_;
+    size_t zBegin_;
+    MarchingTetrahedra::Normals normals_;
+    vec4 color_;
+    Buffers buffers_;
+    std::uint32_t nextVertex_;
+    std::uint32_t* indicesBegin_;
+    std::uint32_t* indices_;
+    std::uint32_t firstPlaceholder_;
+    std::vector<EdgeIndexCache::Key> seam_;
+};
+
+/**
+ * Takes the place of a MeshHelper in Allocation::Shared. The meshes of all threads add the
+ * vertices of a layer to the same Layer, where the edges are welded through a ConcurrentEdgeMap,
+ * so the cells can be split between the threads in any way. The triangles go to the list given
+ * by setTriangles. If the map of the layer is full, full is set and the mesh is incomplete.
+ */
+class SharedMesh {
+public:
+    struct Layer {
+        explicit Layer(size_t edges)
+            : map(edges), positions(map.capacity()), normals(map.capacity()) {}
+
+        ConcurrentEdgeMap map;
+        std::vector<vec3> positions;  // by the index in map
+        std::vector<vec3> normals;    // only set with Normals::Gradient
+    };
+
+    SharedMesh(Layer& layer, std::atomic<bool>& full, size3_t dims,
+               MarchingTetrahedra::Normals normals)
+        : layer_(&layer), full_(&full), dims_(dims), normals_(normals), triangles_(nullptr) {}
+
+    void setTriangles(std::vector<std::uint32_t>& triangles) { triangles_ = &triangles; }
+
+    template <typename Create>
+    std::uint32_t addVertex(const size3_t& cell, size_t edge, Create createVertex) {
+        auto voxel = [&](size_t corner) {
+            return cell.x + (corner & 1) +
+                   dims_.x * (cell.y + ((corner >> 1) & 1) + dims_.y * (cell.z + (corner >> 2)));
+        };
+        const auto corners = EdgeIndexCache::cellEdges[edge];
+        const auto vertex =
+            layer_->map.findOrInsert(ConcurrentEdgeMap::key(voxel(corners[0]), voxel(corners[1])));
+        if (vertex.first == ConcurrentEdgeMap::invalid) {
+            full_->store(true, std::memory_order_relaxed);
+            return 0;
+        }
+        if (vertex.second) {
+            const std::pair<vec3, vec3> created = createVertex();
+            layer_->positions[vertex.first] = created.first;
+            if (normals_ == MarchingTetrahedra::Normals::Gradient) {
+                layer_->normals[vertex.first] = created.second;
+            }
+        }
+        return vertex.first;
+    }
+
+    void addTriangle(size_t i0, size_t i1, size_t i2) {
+        triangles_->push_back(static_cast<std::uint32_t>(i0));
+        triangles_->push_back(static_cast<std::uint32_t>(i1));
+        triangles_->push_back(static_cast<std::uint32_t>(i2));
+    }
+
+    MarchingTetrahedra::Normals getNormalMode() const { return normals_; }
+
+private:
+    Layer* layer_;
+    std::atomic<bool>* full_;
+    size3_t dims_;
+    MarchingTetrahedra::Normals normals_;
+    std::vector<std::uint32_t>* triangles_;
+};
+
+/**
+ * Adds the face normals of the triangles to the normals of their vertices, in triangle order.
+ */
+void accumulateFaceNormals(const std::vector<vec3>& positions,
+                           const std::vector<std::uint32_t>& indices,
+                           std::vector<vec3>& normals) {
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const auto i0 = indices[t];
+        const auto i1 = indices[t + 1];
+        const auto i2 = indices[t + 2];
+        const vec3 n = glm::normalize(
+            glm::cross(positions[i1] - positions[i0], positions[i2] - positions[i0]));
+        normals[i0] += n;
+        normals[i1] += n;
+        normals[i2] += n;
+    }
+}
+
+/**
+ * Extracts the items [0, itemCount), such as planes or blocks of cells, through SharedMeshes
+ * into a mesh with one index buffer per color. The threads take the items one at a time;
+ * makeWorker(meshes) is called once per thread and returns what extracts an item into those
+ * meshes. The triangles are ordered by item and the vertices numbered in the order the
+ * triangles first use them, which does not depend on which thread created them first. edges is
+ * a guess of the number of vertices of each layer, the maps are made four times larger until
+ * they fit. Returns null if cancel is set before it is done. The copy into the mesh, the normals
+ * and the size of the maps are added to stats if given, the workers report their own phases.
+ */
+template <typename MakeWorker>
+std::shared_ptr<BasicMesh> extractShared(size3_t dims, const std::vector<vec4>& colors,
+                                         MarchingTetrahedra::Normals normals, size_t itemCount,
+                                         size_t threads, size_t edges,
+                                         const std::atomic<bool>* cancel, ExtractionStats* stats,
+                                         MakeWorker makeWorker) {
+    using Normals = MarchingTetrahedra::Normals;
+    if (dims.x * dims.y * dims.z > std::numeric_limits<std::uint32_t>::max()) {
+        throw Exception("Shared allocation needs voxel indices that fit in 32 bits",
+                        IVW_CONTEXT_CUSTOM("MarchingTetrahedra"));
+    }
+    auto cancelled = [&]() { return cancel && cancel->load(std::memory_order_relaxed); };
+
+    // the triangles of each layer in each item
+    const size_t layerCount = colors.size();
+    const size_t workers = std::max<size_t>(1, std::min(threads, itemCount));
+    std::vector<std::vector<std::vector<std::uint32_t>>> triangles;
+    std::vector<std::unique_ptr<SharedMesh::Layer>> shared;
+    std::atomic<bool> full(false);
+    do {
+        full = false;
+        triangles.assign(layerCount, std::vector<std::vector<std::uint32_t>>(itemCount));
+        shared.clear();
+        for (size_t layer = 0; layer < layerCount; ++layer) {
+            shared.push_back(std::make_unique<SharedMesh::Layer>(edges));
+        }
+
+        std::atomic<size_t> nextItem(0);
+        util::parallelFor(workers, [&](size_t) {
+            std::vector<SharedMesh> meshes;
+            for (size_t layer = 0; layer < layerCount; ++layer) {
+                meshes.emplace_back(*shared[layer], full, dims, normals);
+            }
+            auto worker = makeWorker(meshes);
+            for (size_t item; !full && !cancelled() && (item = nextItem++) < itemCount;) {
+                for (size_t layer = 0; layer < layerCount; ++layer) {
+                    meshes[layer].setTriangles(triangles[layer][item]);
+                }
+                worker(item);
+            }
+        });
+        if (cancelled()) return nullptr;
+        edges *= 4;
+    } while (full);
+
+    auto mesh = std::make_shared<BasicMesh>();
+    auto& positions =
+        mesh->getEditableVertices()->getEditableRAMRepresentation()->getDataContainer();
+    auto& vertexNormals =
+        mesh->getEditableNormals()->getEditableRAMRepresentation()->getDataContainer();
+    auto& texCoords =
+        mesh->getEditableTexCoords()->getEditableRAMRepresentation()->getDataContainer();
+    auto& vertexColors =
+        mesh->getEditableColors()->getEditableRAMRepresentation()->getDataContainer();
+    std::vector<std::vector<std::uint32_t>*> indexBuffers;
+    {
+        ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::MeshCopy);
+        std::vector<std::uint32_t> remap;
+        for (size_t layer = 0; layer < layerCount; ++layer) {
+            const auto& source = *shared[layer];
+            remap.assign(source.map.size(), ConcurrentEdgeMap::invalid);
+            positions.reserve(positions.size() + source.map.size());
+            auto& indices = mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)
+                                ->getDataContainer();
+            for (const auto& item : triangles[layer]) {
+                for (const auto i : item) {
+                    if (remap[i] == ConcurrentEdgeMap::invalid) {
+                        remap[i] = static_cast<std::uint32_t>(positions.size());
+                        positions.push_back(source.positions[i]);
+                        vertexNormals.push_back(normals == Normals::Gradient ? source.normals[i]
+                                                                             : vec3(0.0f));
+                        texCoords.push_back(source.positions[i]);
+                        vertexColors.push_back(colors[layer]);
+                    }
+                    indices.push_back(remap[i]);
+                }
+            }
+            indexBuffers.push_back(&indices);
+        }
+    }
+    if (normals == Normals::FaceAccumulated) {
+        // each vertex is only used by one layer, so its sum is the same as layer by layer
+        ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::NormalFinalize);
+        for (const auto indices : indexBuffers) {
+            accumulateFaceNormals(positions, *indices, vertexNormals);
+        }
+        for (auto& normal : vertexNormals) {
+            normal = glm::normalize(normal);
+        }
+    }
+
+    if (stats) {
+        size_t capacity = 0;
+        size_t bytes = getSizeInBytes(*mesh);
+        for (const auto& layer : shared) {
+            capacity += layer->map.capacity();
+            bytes += layer->map.getSizeInBytes() +
+                     (layer->positions.capacity() + layer->normals.capacity()) * sizeof(vec3);
+        }
+        for (const auto& layer : triangles) {
+            for (const auto& item : layer) {
+                bytes += item.capacity() * sizeof(std::uint32_t);
+            }
+        }
+        stats->updateEdgeMapSize(capacity);
+        stats->addBytesAllocated(bytes);
+    }
+    return mesh;
+}
+
+/**
+ * Takes the place of a MeshHelper for the cells of a single brick, so that the helper only has
+ * to cache the edges of the brick. Cells are given in the volume and passed on relative to the
+ * first cell of the brick.
+ */
+class BrickMesh {
+public:
+    BrickMesh(MarchingTetrahedra::MeshHelper& mesh, size3_t origin)
+        : mesh_(&mesh), origin_(origin) {}
+
+    template <typename Create>
+    std::uint32_t addVertex(const size3_t& cell, size_t edge, Create createVertex) {
+        return mesh_->addVertex(cell - origin_, edge, createVertex);
+    }
+
+    void addTriangle(size_t i0, size_t i1, size_t i2) { mesh_->addTriangle(i0, i1, i2); }
+
+    MarchingTetrahedra::Normals getNormalMode() const { return mesh_->getNormalMode(); }
+
+private:
+    MarchingTetrahedra::MeshHelper* mesh_;
+    size3_t origin_;
+};
+
+/**
+ * Extracts runs of consecutive cells along x, reading the voxels directly from data. The rows of
+ * voxels of a run are first compared against the iso values with SIMD instructions, and only the
+ * cells the surfaces pass through are visited. The corners with x = 1 of a cell are the corners
+ * with x = 0 of the next one, so within a stretch of such cells only those with x = 1 have to be
+ * read from the volume. Mesh is a MeshHelper or one of the stand-ins above. With stats the
+ * time of each run is split into its phases, which costs a few clock reads per vertex.
+ */
+template <typename T, typename Mesh>
+class CellExtractor {
+public:
+    CellExtractor(const T* data, size3_t dims, const std::vector<float>& isos,
+                  std::vector<Mesh>& meshes,
+                  MarchingTetrahedra::Method method = MarchingTetrahedra::Method::Tetrahedra,
+                  ExtractionStats* stats = nullptr)
+        : data_(data)
+        , origin_(0)
+        , dataDims_(dims)
+        , dims_(dims)
+        , isos_(isos)
+        , meshes_(meshes)
+        , method_(method)
+        , cubeCases_(MarchingCubesCases::get())
+        , stats_(stats)
+        , words_(0) {
+        setData(data, origin_, dataDims_);
+        voxelCoords(dims, coords_);
+    }
+
+    /**
+     * Reads the voxels from data from now on, data pointing to the first voxel of z-slice
+     * zOrigin. Only the slices that are accessed have to be there.
+     */
+    void setData(const T* data, size_t zOrigin) { setData(data, size3_t(0, 0, zOrigin), dims_); }
+
+    /**
+     * Reads the voxels from data from now on, data holding the box of dataDims voxels with its
+     * first voxel at origin. Only the voxels that are accessed have to be in the box.
+     */
+    void setData(const T* data, const size3_t& origin, const size3_t& dataDims) {
+        data_ = data;
+        origin_ = origin;
+        dataDims_ = dataDims;
+
+        // offsets from the first corner of a cell to the others, corner index = x + 2y + 4z
+        const size_t strideY = dataDims.x;
+        const size_t strideZ = dataDims.x * dataDims.y;
+        const size_t offsets[8] = {0,       1,           strideY,           strideY + 1,
+                                   strideZ, strideZ + 1, strideZ + strideY, strideZ + strideY + 1};
+        std::copy(std::begin(offsets), std::end(offsets), std::begin(offsets_));
+    }
+
+    /**
+     * Extracts the cells (x, y, z) with x in [xBegin, xEnd). Runs have to be given with z
+     * increasing for vertices to be shared between them.
+     */
+    void extractRun(size_t xBegin, size_t xEnd, size_t y, size_t z) {
+        using Voxel = MarchingTetrahedra::Voxel;
+
+        size3_t pos(xBegin, y, z);
+        auto loadVoxel = [&](size_t index, size_t corner) {
+            Voxel& voxel = cell_.voxels[corner];
+            voxel.pos = vec3(coords_[0][pos.x + (corner & 1)],
+                             coords_[1][pos.y + ((corner >> 1) & 1)],
+                             coords_[2][pos.z + (corner >> 2)]);
+            voxel.value = static_cast<float>(data_[index + offsets_[corner]]);
+        };
+
+        using Clock = ExtractionStats::Clock;
+        const auto start = stats_ ? Clock::now() : Clock::time_point();
+
+        // Rows without any cell the surfaces pass through are skipped as a whole
+        const bool any = classifyRun(xBegin, xEnd, y, z);
+        const auto classified = stats_ ? Clock::now() : Clock::time_point();
+        if (stats_) {
+            stats_->addTime(ExtractionStats::Phase::Classification, classified - start);
+            size_t active = 0;
+            for (const auto word : activeCells_) active += std::bitset<64>(word).count();
+            stats_->addCells(xEnd - xBegin, active);
+            runVertices_ = RunVertices();
+        }
+        if (!any) return;
+
+        size_t index = dataIndex(pos);
+        bool previous = false;  // whether cell_ holds the cell before pos
+        for (; pos.x < xEnd; ++pos.x, ++index) {
+            const size_t cell = pos.x - xBegin;
+            if (!isActive(activeCells_.data(), cell)) {
+                previous = false;
+                continue;
+            }
+
+            // Step 1: create current cell
+            // Spatial position should be between 0 and 1
+            if (!previous) {
+                for (size_t corner = 0; corner < 8; corner += 2) {
+                    loadVoxel(index, corner);
+                }
+            } else {
+                for (size_t corner = 0; corner < 8; corner += 2) {
+                    cell_.voxels[corner] = cell_.voxels[corner + 1];
+                }
+            }
+            for (size_t corner = 1; corner < 8; corner += 2) {
+                loadVoxel(index, corner);
+            }
+            previous = true;
+
+            for (size_t layer = 0; layer < isos_.size(); ++layer) {
+                if (isActive(activeLayerCells_.data() + layer * words_, cell)) {
+                    if (method_ == MarchingTetrahedra::Method::Cubes) {
+                        extractCube(pos, isos_[layer], meshes_[layer]);
+                    } else {
+                        extractCell(pos, isos_[layer], meshes_[layer]);
+                    }
+                }
+            }
+        }
+
+        if (stats_) {
+            // the rest of the time of the run went into the cells themselves
+            const auto vertices = runVertices_.interpolation + runVertices_.dedup;
+            stats_->addTime(ExtractionStats::Phase::CellSetup,
+                            Clock::now() - classified - vertices);
+            stats_->addTime(ExtractionStats::Phase::Interpolation, runVertices_.interpolation);
+            stats_->addTime(ExtractionStats::Phase::VertexDedup, runVertices_.dedup);
+            stats_->addVertexLookups(runVertices_.lookups, runVertices_.hits);
+        }
+    }
+
+private:
+    static bool isActive(const std::uint64_t* bits, size_t cell) {
+        return (bits[cell / 64] >> (cell % 64)) & 1;
+    }
+
+    /**
+     * Classifies the four rows of voxels of the cells (x, y, z) with x in [xBegin, xEnd)
+     * against each iso value with IsoClassifier. A cell is active for an iso value if its
+     * corners are both below and not below it, the same test as on the value range of the
+     * cell. Returns whether any cell is active for any iso value.
+     */
+    bool classifyRun(size_t xBegin, size_t xEnd, size_t y, size_t z) {
+        const size_t cells = xEnd - xBegin;
+        const size_t voxels = cells + 1;
+        words_ = IsoClassifier::words(voxels);
+        below_.resize(4 * words_);
+        someBelow_.resize(words_);
+        allBelow_.resize(words_);
+        activeCells_.assign(words_, 0);
+        activeLayerCells_.resize(isos_.size() * words_);
+
+        const float* rows[4];
+        rowValues_.resize(4 * voxels);
+        for (size_t row = 0; row < 4; ++row) {
+            const size_t first = dataIndex(size3_t(xBegin, y + (row & 1), z + (row >> 1)));
+            rows[row] = toFloat(data_ + first, voxels, rowValues_.data() + row * voxels);
+        }
+
+        // the bits of the cells past the run are cleared
+        const std::uint64_t lastWord =
+            cells % 64 == 0 ? ~std::uint64_t{0} : (std::uint64_t{1} << (cells % 64)) - 1;
+        bool any = false;
+        for (size_t layer = 0; layer < isos_.size(); ++layer) {
+            for (size_t row = 0; row < 4; ++row) {
+                IsoClassifier::classify(rows[row], voxels, isos_[layer],
+                                        below_.data() + row * words_);
+            }
+            for (size_t w = 0; w < words_; ++w) {
+                someBelow_[w] = below_[w] | below_[words_ + w] | below_[2 * words_ + w] |
+                                below_[3 * words_ + w];
+                allBelow_[w] = below_[w] & below_[words_ + w] & below_[2 * words_ + w] &
+                               below_[3 * words_ + w];
+            }
+
+            // cell x has the voxels x and x + 1 of each row
+            std::uint64_t* active = activeLayerCells_.data() + layer * words_;
+            for (size_t w = 0; w < words_; ++w) {
+                const std::uint64_t someNext =
+                    (someBelow_[w] >> 1) | (w + 1 < words_ ? someBelow_[w + 1] << 63 : 0);
+                const std::uint64_t allNext =
+                    (allBelow_[w] >> 1) | (w + 1 < words_ ? allBelow_[w + 1] << 63 : 0);
+                active[w] = (someBelow_[w] | someNext) & ~(allBelow_[w] & allNext);
+            }
+            // voxels has one bit more than cells, so the cells fit into the same words
+            if (cells == 0) {
+                std::fill(active, active + words_, std::uint64_t{0});
+            } else {
+                const size_t last = (cells - 1) / 64;
+                active[last] &= lastWord;
+                std::fill(active + last + 1, active + words_, std::uint64_t{0});
+            }
+            for (size_t w = 0; w < words_; ++w) {
+                activeCells_[w] |= active[w];
+                any = any || active[w] != 0;
+            }
+        }
+        return any;
+    }
+
+    /**
+     * The values of a row as floats, converted into buffer unless they already are.
+     */
+    template <typename U>
+    static const float* toFloat(const U* values, size_t count, float* buffer) {
+        for (size_t i = 0; i < count; ++i) buffer[i] = static_cast<float>(values[i]);
+        return buffer;
+    }
+    static const float* toFloat(const float* values, size_t, float*) { return values; }
+
+    void extractCell(const size3_t& pos, float iso, Mesh& mesh) {
+        // Step 2 & 3: classify each tetrahedra, its triangles are in the case table
+        for (const auto& ids : tetrahedraIds) {
+            int caseId = 0;
+            for (int k = 0; k < 4; ++k) {
+                if (cell_.voxels[ids[k]].value < iso) caseId |= 1 << k;
+            }
+
+            // Step four: Extract triangles
+            const TetrahedraCase& tetrahedraCase = tetrahedraCases[caseId];
+            std::uint32_t vertices[4];
+            for (int e = 0; e < tetrahedraCase.edgeCount; ++e) {
+                // always interpolate from the lower corner of the cell so that the edge gets the
+                // same vertex no matter which tetrahedra reaches it first
+                const size_t a = ids[tetrahedraCase.edges[e][0]];
+                const size_t b = ids[tetrahedraCase.edges[e][1]];
+                vertices[e] = addVertex(pos, iso, EdgeIndexCache::cellEdge(a, b), mesh);
+            }
+            for (int i = 0; i < tetrahedraCase.triangleCount; ++i) {
+                const auto& triangle = tetrahedraCase.triangles[i];
+                mesh.addTriangle(vertices[triangle[0]], vertices[triangle[1]],
+                                 vertices[triangle[2]]);
+            }
+        }
+    }
+
+    /**
+     * Marching cubes on the cell at pos. The vertices are on the cube edges, which are the first
+     * twelve cell edges, so they are the same as the ones of the tetrahedra on those edges. The
+     * cell diagonal is not used by marching cubes, its slot holds the vertex in the middle of the
+     * cell if the case has one.
+     */
+    void extractCube(const size3_t& pos, float iso, Mesh& mesh) {
+        size_t caseId = 0;
+        for (size_t corner = 0; corner < 8; ++corner) {
+            if (cell_.voxels[corner].value < iso) caseId |= size_t{1} << corner;
+        }
+        const auto& cubeCase = cubeCases_.getCase(
+            caseId, iso, [&](size_t corner) { return cell_.voxels[corner].value; });
+
+        std::uint32_t vertices[13];
+        std::fill(std::begin(vertices), std::end(vertices), EdgeIndexCache::invalid);
+        if (cubeCase.centerLoop != 0) {
+            vertices[MarchingCubesCases::center] =
+                addVertex(mesh, pos, EdgeIndexCache::cellEdge(2, 5), [&]() {
+                    // the centroid of the loop, with the mean of its normals
+                    std::pair<vec3, vec3> center(vec3(0.0f), vec3(0.0f));
+                    float count = 0.0f;
+                    for (size_t edge = 0; edge < 12; ++edge) {
+                        if (!((cubeCase.centerLoop >> edge) & 1)) continue;
+                        const auto vertex = createVertex(pos, iso, edge, mesh.getNormalMode());
+                        center.first += vertex.first;
+                        center.second += vertex.second;
+                        count += 1.0f;
+                    }
+                    center.first /= count;
+                    if (glm::length(center.second) > 0.0f) {
+                        center.second = glm::normalize(center.second);
+                    }
+                    return center;
+                });
+        }
+        for (size_t i = 0; i < cubeCase.triangleCount; ++i) {
+            const auto& triangle = cubeCase.triangles[i];
+            for (auto edge : triangle) {
+                if (vertices[edge] == EdgeIndexCache::invalid) {
+                    vertices[edge] = addVertex(pos, iso, edge, mesh);
+                }
+            }
+            mesh.addTriangle(vertices[triangle[0]], vertices[triangle[1]],
+                             vertices[triangle[2]]);
+        }
+    }
+
+    /**
+     * Adds the vertex on the given cell edge of the cell at pos.
+     */
+    std::uint32_t addVertex(const size3_t& pos, float iso, size_t edge, Mesh& mesh) {
+        return addVertex(mesh, pos, edge,
+                         [&]() { return createVertex(pos, iso, edge, mesh.getNormalMode()); });
+    }
+
+    /**
+     * Adds the vertex on the given cell edge of the cell at pos, calling createVertex() if the
+     * edge does not have one yet. With stats the time in createVertex counts as interpolation
+     * and the rest as dedup.
+     */
+    template <typename Create>
+    std::uint32_t addVertex(Mesh& mesh, const size3_t& pos, size_t edge, Create createVertex) {
+        if (!stats_) return mesh.addVertex(pos, edge, createVertex);
+
+        using Clock = ExtractionStats::Clock;
+        const auto start = Clock::now();
+        Clock::duration interpolation(0);
+        bool created = false;
+        const auto vertex = mesh.addVertex(pos, edge, [&]() {
+            const auto begin = Clock::now();
+            const auto result = createVertex();
+            interpolation = Clock::now() - begin;
+            created = true;
+            return result;
+        });
+        runVertices_.interpolation += interpolation;
+        runVertices_.dedup += Clock::now() - start - interpolation;
+        ++runVertices_.lookups;
+        if (!created) ++runVertices_.hits;
+        return vertex;
+    }
+
+    /**
+     * Position and normal of the vertex on the given cell edge of the cell at pos. It is
+     * interpolated from the lower corner of the edge so that the edge gets the same vertex no
+     * matter which cell or tetrahedra reaches it first.
+     */
+    std::pair<vec3, vec3> createVertex(const size3_t& pos, float iso, size_t edge,
+                                       MarchingTetrahedra::Normals normals) const {
+        using Voxel = MarchingTetrahedra::Voxel;
+
+        const size_t a = EdgeIndexCache::cellEdges[edge][0];
+        const size_t b = EdgeIndexCache::cellEdges[edge][1];
+        const Voxel& va = cell_.voxels[a];
+        const Voxel& vb = cell_.voxels[b];
+        const float t = (iso - va.value) / (vb.value - va.value);
+        const vec3 interp = va.pos + (vb.pos - va.pos) * t;
+
+        // the normal points towards lower values, as the triangles do
+        vec3 normal(0.0f);
+        if (normals == MarchingTetrahedra::Normals::Gradient) {
+            normal = -((1.0f - t) * gradient(pos, a) + t * gradient(pos, b));
+            if (glm::length(normal) > 0.0f) normal = glm::normalize(normal);
+        }
+        return std::make_pair(interp, normal);
+    }
+
+    /**
+     * Gradient at the corner of the cell at pos. Needs the slices next to the cell.
+     */
+    vec3 gradient(const size3_t& pos, size_t corner) const {
+        const size3_t voxel(pos.x + (corner & 1), pos.y + ((corner >> 1) & 1),
+                            pos.z + (corner >> 2));
+        return detail::gradient(voxel, dims_, coords_,
+                                [this](const size3_t& v) { return value(v); });
+    }
+
+    float value(const size3_t& voxel) const { return static_cast<float>(data_[dataIndex(voxel)]); }
+
+    size_t dataIndex(const size3_t& voxel) const {
+        return voxel.x - origin_.x +
+               dataDims_.x * (voxel.y - origin_.y + dataDims_.y * (voxel.z - origin_.z));
+    }
+
+    const T* data_;
+    size3_t origin_;    // first voxel in data
+    size3_t dataDims_;  // voxels in data
+    size3_t dims_;      // of the volume
+    const std::vector<float>& isos_;
+    std::vector<Mesh>& meshes_;
+    MarchingTetrahedra::Method method_;
+    const MarchingCubesCases& cubeCases_;
+    ExtractionStats* stats_;
+    size_t offsets_[8];
+    std::vector<float> coords_[3];
+    MarchingTetrahedra::Cell cell_;
+
+    // classification of the current run, see classifyRun
+    size_t words_;
+    std::vector<float> rowValues_;
+    std::vector<std::uint64_t> below_;
+    std::vector<std::uint64_t> someBelow_;
+    std::vector<std::uint64_t> allBelow_;
+    std::vector<std::uint64_t> activeCells_;       // active for any iso value
+    std::vector<std::uint64_t> activeLayerCells_;  // words_ per iso value
+
+    // the vertices of the current run, only kept with stats
+    struct RunVertices {
+        ExtractionStats::Clock::duration interpolation{0};
+        ExtractionStats::Clock::duration dedup{0};
+        size_t lookups = 0;
+        size_t hits = 0;
+    };
+    RunVertices runVertices_;
+};
+
+/**
+ * Interleaves the bits of x and y, x in the lower one of each pair.
+ */
+std::uint64_t mortonCode(std::uint32_t x, std::uint32_t y) {
+    auto spread = [](std::uint64_t v) {
+        v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+        v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+        v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+        v = (v | (v << 2)) & 0x3333333333333333ull;
+        v = (v | (v << 1)) & 0x5555555555555555ull;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+/**
+ * Extracts the cells with z in [zBegin, zEnd), and within the x and y range of roi if given.
+ * Cells in bricks that are not active for any of the iso values are skipped if bricks is given.
+ * The planes are always visited with z increasing, as the edge cache needs, the traversal only
+ * orders the cells within each plane.
+ */
+template <typename T, typename Mesh>
+void extractSlab(const T* data, size3_t dims, const std::vector<float>& isos, size_t zBegin,
+                 size_t zEnd, const MinMaxBricks* bricks, MarchingTetrahedra::Method method,
+                 MarchingTetrahedra::Traversal traversal, const MarchingTetrahedra::CellBox* roi,
+                 std::vector<Mesh>& meshes, ExtractionStats* stats = nullptr) {
+    CellExtractor<T, Mesh> extractor(data, dims, isos, meshes, method, stats);
+
+    const size_t cellsX = dims.x > 1 ? dims.x - 1 : 0;
+    const size_t cellsY = dims.y > 1 ? dims.y - 1 : 0;
+    size2_t end(cellsX, cellsY);
+    size2_t begin(0);
+    if (roi) {
+        end = glm::min(end, size2_t(roi->end));
+        begin = glm::min(size2_t(roi->begin), end);
+    }
+
+    // the runs end at brick borders with bricks and in tiles, so that each is in a single brick
+    const size_t brickSize = MinMaxBricks::brickSize;
+    const bool tiled = traversal == MarchingTetrahedra::Traversal::Morton;
+    const size_t runLength = bricks || tiled ? brickSize : std::max<size_t>(cellsX, 1);
+
+    // the tiles of the part of a plane to extract, as the cells of their first corner, in
+    // Z-order
+    std::vector<size2_t> tiles;
+    if (tiled) {
+        const size2_t first = begin / brickSize;
+        const size2_t last = (end + size2_t(brickSize - 1)) / brickSize;
+        std::vector<std::pair<std::uint64_t, size2_t>> codes;
+        for (size_t y = first.y; y < last.y; ++y) {
+            for (size_t x = first.x; x < last.x; ++x) {
+                codes.emplace_back(mortonCode(static_cast<std::uint32_t>(x),
+                                              static_cast<std::uint32_t>(y)),
+                                   size2_t(x, y) * brickSize);
+            }
+        }
+        std::sort(codes.begin(), codes.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& code : codes) tiles.push_back(code.second);
+    } else {
+        tiles.push_back(begin);
+    }
+
+    for (size_t z = zBegin; z < zEnd; ++z) {
+        for (const auto& tile : tiles) {
+            const size_t xBegin = std::max(tile.x, begin.x);
+            const size_t xEnd = tiled ? std::min(tile.x + brickSize, end.x) : end.x;
+            const size_t yEnd = tiled ? std::min(tile.y + brickSize, end.y) : end.y;
+            for (size_t y = std::max(tile.y, begin.y); y < yEnd; ++y) {
+                for (size_t x = xBegin, runEnd; x < xEnd; x = runEnd) {
+                    runEnd = std::min((x / runLength + 1) * runLength, xEnd);
+                    if (!bricks || bricks->isActive(size3_t(x, y, z) / brickSize, isos)) {
+                        extractor.extractRun(x, runEnd, y, z);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Extracts the cells given as the 1D-index of their first voxel, in increasing order.
+ */
+template <typename T, typename Mesh>
+void extractCells(const T* data, size3_t dims, const std::vector<float>& isos,
+                  const std::uint32_t* begin, const std::uint32_t* end,
+                  MarchingTetrahedra::Method method, std::vector<Mesh>& meshes,
+                  ExtractionStats* stats = nullptr) {
+    CellExtractor<T, Mesh> extractor(data, dims, isos, meshes, method, stats);
+
+    // the last cell of a row is not followed by a cell, so consecutive indices share a row
+    while (begin != end) {
+        const std::uint32_t* runEnd = begin + 1;
+        while (runEnd != end && *runEnd == *(runEnd - 1) + 1) ++runEnd;
+
+        const size_t x = *begin % dims.x;
+        const size_t y = (*begin / dims.x) % dims.y;
+        const size_t z = *begin / (dims.x * dims.y);
+        extractor.extractRun(x, x + static_cast<size_t>(runEnd - begin), y, z);
+        begin = runEnd;
+    }
+}
+
+/**
+ * Extracts the cells in [begin, end).
+ */
+template <typename T, typename Mesh>
+void extractBox(const T* data, size3_t dims, const std::vector<float>& isos, size3_t begin,
+                size3_t end, MarchingTetrahedra::Method method, std::vector<Mesh>& meshes) {
+    CellExtractor<T, Mesh> extractor(data, dims, isos, meshes, method);
+    for (size_t z = begin.z; z < end.z; ++z) {
+        for (size_t y = begin.y; y < end.y; ++y) {
+            extractor.extractRun(begin.x, end.x, y, z);
+        }
+    }
+}
+
+/**
+ * Compares the voxels in [begin, end) with copy and brings copy up to date, a row at a time.
+ * Returns whether any voxel differed, and the range of the voxels.
+ */
+template <typename T>
+bool updateBox(const T* data, size3_t dims, size3_t begin, size3_t end,
+               std::vector<unsigned char>& copy, vec2& range) {
+    const size_t count = end.x - begin.x;
+    const size_t rowBytes = count * sizeof(T);
+    const size_t bytes = rowBytes * (end.y - begin.y) * (end.z - begin.z);
+    bool changed = copy.size() != bytes;
+    if (changed) copy.assign(bytes, 0);
+
+    range = vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+    util::IndexMapper3D indexMapper(dims);
+    unsigned char* dst = copy.data();
+    for (size_t z = begin.z; z < end.z; ++z) {
+        for (size_t y = begin.y; y < end.y; ++y, dst += rowBytes) {
+            const T* row = data + indexMapper(size3_t(begin.x, y, z));
+            for (size_t x = 0; x < count; ++x) {
+                const float value = static_cast<float>(row[x]);
+                range.x = std::min(range.x, value);
+                range.y = std::max(range.y, value);
+            }
+            if (std::memcmp(dst, row, rowBytes) != 0) {
+                std::memcpy(dst, row, rowBytes);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+/**
+ * Extracts all cells of a raw volume file with the voxels stored from byteOffset on. Only the
+ * two slices of the current z, and their neighbours for gradient normals, are mapped at any time.
+ */
+template <typename T>
+void extractRaw(MappedFile& file, size_t byteOffset, size3_t dims, const std::vector<float>& isos,
+                MarchingTetrahedra::Method method,
+                std::vector<MarchingTetrahedra::MeshHelper>& meshes) {
+    CellExtractor<T, MarchingTetrahedra::MeshHelper> extractor(nullptr, dims, isos, meshes,
+                                                               method);
+
+    // gradients need one more slice on either side
+    const bool gradients = !meshes.empty() && meshes.front().getNormalMode() ==
+                                                  MarchingTetrahedra::Normals::Gradient;
+    const size_t border = gradients ? 1 : 0;
+    const size_t sliceBytes = dims.x * dims.y * sizeof(T);
+    for (size_t z = 0; z + 1 < dims.z; ++z) {
+        const size_t first = z > border ? z - border : 0;
+        const size_t last = std::min(z + 2 + border, dims.z);
+        const auto slices = file.map(byteOffset + first * sliceBytes, (last - first) * sliceBytes);
+        extractor.setData(reinterpret_cast<const T*>(slices), first);
+        for (size_t y = 0; y + 1 < dims.y; ++y) {
+            extractor.extractRun(0, dims.x - 1, y, z);
+        }
+    }
+}
+
+/**
+ * Dual contouring on the leaves of the octree. Each leaf the surface passes through gets one
+ * vertex, at the mean of the crossings on the minimal edges around it, and each crossed minimal
+ * edge gets a quad between the vertices of the leaves around it, or a triangle where one leaf
+ * takes two places. Leaves of different sizes share the same vertices, so there are no cracks
+ * where the resolution changes.
+ */
+template <typename T>
+void extractAdaptive(const T* data, size3_t dims, const IsoOctree& octree, float iso,
+                     MarchingTetrahedra::MeshHelper& mesh) {
+    struct MassPoint {
+        vec3 pos;
+        vec3 normal;
+        float count;
+    };
+
+    util::IndexMapper3D indexMapper(dims);
+    auto value = [&](const size3_t& voxel) { return static_cast<float>(data[indexMapper(voxel)]); };
+    std::vector<float> coords[3];
+    voxelCoords(dims, coords);
+    const bool gradients = mesh.getNormalMode() == MarchingTetrahedra::Normals::Gradient;
+
+    // the mass point of each leaf is numbered in the order the leaves are reached
+    std::vector<std::uint32_t> leafPoints(octree.size(), EdgeIndexCache::invalid);
+    std::vector<MassPoint> points;
+    std::vector<std::array<std::uint32_t, 4>> polygons;
+
+    octree.forEachEdge([&](const std::uint32_t(&leaves)[4], size_t axis, const size3_t& from,
+                           size_t length) {
+        size3_t to(from);
+        to[axis] += length;
+        const float va = value(from);
+        const float vb = value(to);
+        const bool below = va < iso;
+        if (below == (vb < iso)) return;
+
+        const float t = (iso - va) / (vb - va);
+        vec3 pos(coords[0][from.x], coords[1][from.y], coords[2][from.z]);
+        pos[axis] += t * (coords[axis][to[axis]] - coords[axis][from[axis]]);
+        vec3 normal(0.0f);
+        if (gradients) {
+            normal = -((1.0f - t) * gradient(from, dims, coords, value) +
+                       t * gradient(to, dims, coords, value));
+        }
+
+        // (0, 1, 3, 2) goes around the edge counter clockwise seen from the upper end of the
+        // axis for x and z, and from the lower end for y. Leaves taking two places are
+        // consecutive.
+        std::array<std::uint32_t, 4> polygon;
+        polygon.fill(EdgeIndexCache::invalid);
+        size_t count = 0;
+        for (const size_t j : {0, 1, 3, 2}) {
+            auto& point = leafPoints[leaves[j]];
+            if (point == EdgeIndexCache::invalid) {
+                point = static_cast<std::uint32_t>(points.size());
+                points.push_back({vec3(0.0f), vec3(0.0f), 0.0f});
+            }
+            if (std::find(polygon.begin(), polygon.begin() + count, point) !=
+                polygon.begin() + count) {
+                continue;
+            }
+            points[point].pos += pos;
+            points[point].normal += normal;
+            points[point].count += 1.0f;
+            polygon[count++] = point;
+        }
+        if (count < 3) return;
+
+        // the face normal has to point towards lower values
+        if (below != (axis == 1)) std::reverse(polygon.begin(), polygon.begin() + count);
+        polygons.push_back(polygon);
+    });
+
+    for (const auto& point : points) {
+        const vec3 normal =
+            glm::length(point.normal) > 0.0f ? glm::normalize(point.normal) : vec3(0.0f);
+        mesh.addVertex(point.pos / point.count, normal);
+    }
+    for (const auto& polygon : polygons) {
+        mesh.addTriangle(polygon[0], polygon[1], polygon[2]);
+        if (polygon[3] != EdgeIndexCache::invalid) {
+            mesh.addTriangle(polygon[0], polygon[2], polygon[3]);
+        }
+    }
+}
+
+}  // namespace detail
+
+}  // namespace
+
+const ProcessorInfo MarchingTetrahedra::processorInfo_{
+    "org.inviwo.MarchingTetrahedra",  // Class identifier
+    "Marching Tetrahedra",            // Display name
+    "TNM067",                         // Category
+    CodeState::Experimental,          // Code state
+    Tags::None,                       // Tags
+};
+const ProcessorInfo MarchingTetrahedra::getProcessorInfo() const { return processorInfo_; }
+
+MarchingTetrahedra::MarchingTetrahedra()
+    : Processor()
+    , volume_("volume")
+    , sparseVolume_("sparseVolume")
+    , mesh_("mesh")
+    , brickMeshes_("brickMeshes")
+    , isoValue_("isoValue", "ISO value", 0.5f, 0.0f, 1.0f)
+    , multipleIsoValues_("multipleIsoValues", "Multiple ISO Values", false)
+    , isoValues_("isoValues", "ISO Values", "")
+    , method_("method", "Method",
+              {{"tetrahedra", "Marching Tetrahedra", Method::Tetrahedra},
+               {"cubes", "Marching Cubes", Method::Cubes}},
+              0)
+    , normals_("normals", "Normals",
+               {{"gradient", "Volume Gradient", Normals::Gradient},
+                {"faceAccumulated", "Face Accumulated", Normals::FaceAccumulated}},
+               1)
+    , allocation_("allocation", "Mesh Allocation",
+                  {{"incremental", "Incremental", Allocation::Incremental},
+                   {"countThenFill", "Count Then Fill", Allocation::CountThenFill},
+                   {"shared", "Shared", Allocation::Shared}},
+                  0)
+    , traversal_("traversal", "Traversal",
+                 {{"linear", "Linear", Traversal::Linear},
+                  {"morton", "Z-Order Tiles", Traversal::Morton}},
+                 0)
+    , threads_("threads", "Threads", std::max<size_t>(1, std::thread::hardware_concurrency()),
+               1, 64)
+    , streamRawFile_("streamRawFile", "Stream Raw File", false)
+    , rawFile_("rawFile", "Raw File")
+    , rawDimensions_("rawDimensions", "Dimensions", size3_t(128), size3_t(1), size3_t(8192))
+    , rawFormat_("rawFormat", "Format",
+                 {{"int8", "INT8", DataFormatId::Int8},
+                  {"uint8", "UINT8", DataFormatId::UInt8},
+                  {"int16", "INT16", DataFormatId::Int16},
+                  {"uint16", "UINT16", DataFormatId::UInt16},
+                  {"int32", "INT32", DataFormatId::Int32},
+                  {"uint32", "UINT32", DataFormatId::UInt32},
+                  {"float32", "FLOAT32", DataFormatId::Float32},
+                  {"float64", "FLOAT64", DataFormatId::Float64}},
+                 1)
+    , rawHeaderSize_("rawHeaderSize", "Header Size", 0, 0, 4096)
+    , adaptive_("adaptive", "Adaptive Resolution", false)
+    , tolerance_("tolerance", "Error Tolerance", 0.01f, 0.0f, 0.1f, 0.001f)
+    , bricked_("bricked", "Bricked Output", false)
+    , brickSize_("brickSize", "Brick Size", 32, 4, 256)
+    , updatedBricks_("updatedBricks", "Updated Bricks", 0, 0, std::numeric_limits<size_t>::max(),
+                     1, InvalidationLevel::Valid)
+    , temporal_("temporal", "Temporal Coherence", false)
+    , extractedCells_("extractedCells", "Extracted Cells", 0, 0,
+                      std::numeric_limits<size_t>::max(), 1, InvalidationLevel::Valid)
+    , diskCache_("diskCache", "Disk Cache")
+    , clip_("clip", "Clip Box", false)
+    , clipX_("clipX", "X", 0.0f, 1.0f, 0.0f, 1.0f)
+    , clipY_("clipY", "Y", 0.0f, 1.0f, 0.0f, 1.0f)
+    , clipZ_("clipZ", "Z", 0.0f, 1.0f, 0.0f, 1.0f)
+    , progressive_("progressive", "Progressive Preview", false)
+    , previewStride_("previewStride", "Preview Stride", {{"2", "2x", 2}, {"4", "4x", 4}}, 0)
+    , refining_("refining", "Refining", false, InvalidationLevel::Valid)
+    , instrumentation_("instrumentation", "Instrumentation", false)
+    , statsStatus_("statsStatus", "Stats", "", InvalidationLevel::Valid)
+    , cellSetupTime_("cellSetupTime", "Cell Setup (ms)", 0.0f, 0.0f,
+                     std::numeric_limits<float>::max(), 0.01f, InvalidationLevel::Valid)
+    , classificationTime_("classificationTime", "Classification (ms)", 0.0f, 0.0f,
+                          std::numeric_limits<float>::max(), 0.01f, InvalidationLevel::Valid)
+    , interpolationTime_("interpolationTime", "Interpolation (ms)", 0.0f, 0.0f,
+                         std::numeric_limits<float>::max(), 0.01f, InvalidationLevel::Valid)
+    , vertexDedupTime_("vertexDedupTime", "Vertex Dedup (ms)", 0.0f, 0.0f,
+                       std::numeric_limits<float>::max(), 0.01f, InvalidationLevel::Valid)
+    , normalFinalizeTime_("normalFinalizeTime", "Normal Finalize (ms)", 0.0f, 0.0f,
+                          std::numeric_limits<float>::max(), 0.01f, InvalidationLevel::Valid)
+    , meshCopyTime_("meshCopyTime", "Mesh Copy (ms)", 0.0f, 0.0f,
+                    std::numeric_limits<float>::max(), 0.01f, InvalidationLevel::Valid)
+    , cellsVisited_("cellsVisited", "Cells Visited", 0, 0, std::numeric_limits<size_t>::max(), 1,
+                    InvalidationLevel::Valid)
+    , activeCells_("activeCells", "Active Cells", 0, 0, std::numeric_limits<size_t>::max(), 1,
+                   InvalidationLevel::Valid)
+    , dedupHitRate_("dedupHitRate", "Dedup Hit Rate", 0.0f, 0.0f, 1.0f, 0.01f,
+                    InvalidationLevel::Valid)
+    , peakEdgeMapSize_("peakEdgeMapSize", "Peak Edge Map Size", 0, 0,
+                       std::numeric_limits<size_t>::max(), 1, InvalidationLevel::Valid)
+    , bytesAllocated_("bytesAllocated", "Bytes Allocated", 0, 0,
+                      std::numeric_limits<size_t>::max(), 1, InvalidationLevel::Valid)
+    , statsFile_("statsFile", "JSON File", "")
+    , spanSpaceIndex_("spanSpaceIndex", "Span Space Index", false)
+    , indexMemoryLimit_("indexMemoryLimit", "Index Memory Limit (MB)", 1024, 1, 1 << 20)
+    , skipEmptyBricks_("skipEmptyBricks", "Skip Empty Bricks", true)
+    , skippedBricks_("skippedBricks", "Skipped Bricks", 0.0f, 0.0f, 1.0f, 0.01f,
+                     InvalidationLevel::Valid)
+    , triangleCount_("triangleCount", "Triangles", 0, 0, std::numeric_limits<size_t>::max(), 1,
+                     InvalidationLevel::Valid)
+    , vertexCount_("vertexCount", "Vertices", 0, 0, std::numeric_limits<size_t>::max(), 1,
+                   InvalidationLevel::Valid)
+    , index_()
+    , bricks_()
+    , brickedMesh_()
+    , temporalMesh_()
+    , cancelRefinement_()
+    , refinement_()
+    , refinedMesh_()
+    , deliveringRefinement_(false) {
+
+    addPort(volume_);
+    addPort(sparseVolume_);
+    addPort(mesh_);
+    addPort(brickMeshes_);
+
+    addProperty(isoValue_);
+    addProperty(multipleIsoValues_);
+    addProperty(isoValues_);
+    addProperty(method_);
+    addProperty(normals_);
+    addProperty(allocation_);
+    addProperty(traversal_);
+    addProperty(threads_);
+    streamRawFile_.addProperty(rawFile_);
+    streamRawFile_.addProperty(rawDimensions_);
+    streamRawFile_.addProperty(rawFormat_);
+    streamRawFile_.addProperty(rawHeaderSize_);
+    addProperty(streamRawFile_);
+    adaptive_.addProperty(tolerance_);
+    addProperty(adaptive_);
+    bricked_.addProperty(brickSize_);
+    bricked_.addProperty(updatedBricks_);
+    addProperty(bricked_);
+    temporal_.addProperty(extractedCells_);
+    addProperty(temporal_);
+    addProperty(diskCache_);
+    clip_.addProperty(clipX_);
+    clip_.addProperty(clipY_);
+    clip_.addProperty(clipZ_);
+    addProperty(clip_);
+    progressive_.addProperty(previewStride_);
+    progressive_.addProperty(refining_);
+    addProperty(progressive_);
+    instrumentation_.addProperty(statsStatus_);
+    instrumentation_.addProperty(cellSetupTime_);
+    instrumentation_.addProperty(classificationTime_);
+    instrumentation_.addProperty(interpolationTime_);
+    instrumentation_.addProperty(vertexDedupTime_);
+    instrumentation_.addProperty(normalFinalizeTime_);
+    instrumentation_.addProperty(meshCopyTime_);
+    instrumentation_.addProperty(cellsVisited_);
+    instrumentation_.addProperty(activeCells_);
+    instrumentation_.addProperty(dedupHitRate_);
+    instrumentation_.addProperty(peakEdgeMapSize_);
+    instrumentation_.addProperty(bytesAllocated_);
+    instrumentation_.addProperty(statsFile_);
+    addProperty(instrumentation_);
+    addProperty(spanSpaceIndex_);
+    addProperty(indexMemoryLimit_);
+    addProperty(skipEmptyBricks_);
+    addProperty(skippedBricks_);
+    addProperty(triangleCount_);
+    addProperty(vertexCount_);
+
+    skippedBricks_.setReadOnly(true);
+    skippedBricks_.setSerializationMode(PropertySerializationMode::None);
+    triangleCount_.setReadOnly(true);
+    triangleCount_.setSerializationMode(PropertySerializationMode::None);
+    vertexCount_.setReadOnly(true);
+    vertexCount_.setSerializationMode(PropertySerializationMode::None);
+    updatedBricks_.setReadOnly(true);
+    updatedBricks_.setSerializationMode(PropertySerializationMode::None);
+    extractedCells_.setReadOnly(true);
+    extractedCells_.setSerializationMode(PropertySerializationMode::None);
+    refining_.setReadOnly(true);
+    refining_.setSerializationMode(PropertySerializationMode::None);
+    statsStatus_.setReadOnly(true);
+    statsStatus_.setSerializationMode(PropertySerializationMode::None);
+    cellSetupTime_.setReadOnly(true);
+    cellSetupTime_.setSerializationMode(PropertySerializationMode::None);
+    classificationTime_.setReadOnly(true);
+    classificationTime_.setSerializationMode(PropertySerializationMode::None);
+    interpolationTime_.setReadOnly(true);
+    interpolationTime_.setSerializationMode(PropertySerializationMode::None);
+    vertexDedupTime_.setReadOnly(true);
+    vertexDedupTime_.setSerializationMode(PropertySerializationMode::None);
+    normalFinalizeTime_.setReadOnly(true);
+    normalFinalizeTime_.setSerializationMode(PropertySerializationMode::None);
+    meshCopyTime_.setReadOnly(true);
+    meshCopyTime_.setSerializationMode(PropertySerializationMode::None);
+    cellsVisited_.setReadOnly(true);
+    cellsVisited_.setSerializationMode(PropertySerializationMode::None);
+    activeCells_.setReadOnly(true);
+    activeCells_.setSerializationMode(PropertySerializationMode::None);
+    dedupHitRate_.setReadOnly(true);
+    dedupHitRate_.setSerializationMode(PropertySerializationMode::None);
+    peakEdgeMapSize_.setReadOnly(true);
+    peakEdgeMapSize_.setSerializationMode(PropertySerializationMode::None);
+    bytesAllocated_.setReadOnly(true);
+    bytesAllocated_.setSerializationMode(PropertySerializationMode::None);
+
+    // the bricks of another size have to be extracted again
+    brickSize_.onChange([&]() { brickedMesh_.reset(); });
+
+    // the adaptive, bricked, temporal and sparse extractions always cover the whole volume
+    auto updateClip = [this]() {
+        clip_.setReadOnly(adaptive_.isChecked() || bricked_.isChecked() ||
+                          temporal_.isChecked() || sparseVolume_.isConnected());
+    };
+    adaptive_.onChange(updateClip);
+    bricked_.onChange(updateClip);
+    temporal_.onChange(updateClip);
+    // none of the options of the dense extraction apply to a sparse volume
+    auto updateSparse = [this, updateClip]() {
+        const bool sparse = sparseVolume_.isConnected();
+        for (Property* property : std::initializer_list<Property*>{
+                 &spanSpaceIndex_, &skipEmptyBricks_, &allocation_, &traversal_, &progressive_,
+                 &adaptive_, &bricked_, &temporal_, &diskCache_}) {
+            property->setReadOnly(sparse);
+        }
+        updateClip();
+    };
+    sparseVolume_.onConnect(updateSparse);
+    sparseVolume_.onDisconnect(updateSparse);
+    // the bricks only support gradient normals, see BrickedMesh
+    bricked_.onChange([this]() { normals_.setReadOnly(bricked_.isChecked()); });
+
+    isoValue_.setSerializationMode(PropertySerializationMode::All);
+
+    // a list of iso values separated by spaces or commas, one surface each
+    isoValues_.setVisible(false);
+    multipleIsoValues_.onChange([&]() {
+        isoValue_.setVisible(!multipleIsoValues_.get());
+        isoValues_.setVisible(multipleIsoValues_.get());
+    });
+
+    // the streamed volume is never loaded, so it does not need the inport, and a sparse volume
+    // takes the place of the dense one, they can not both be connected
+    volume_.setOptional(true);
+    sparseVolume_.setOptional(true);
+    rawFormat_.onChange([&]() {
+        const auto format = DataFormatBase::get(rawFormat_.get());
+        if (streamRawFile_.isChecked() && format &&
+            format->getNumericType() != NumericType::Float) {
+            setIsoValueRange(vec2(format->getMin(), format->getMax()));
+        }
+    });
+
+    volume_.onChange([&]() {
+        index_.reset();
+        bricks_.reset();
+        firstChannel_.reset();
+        volumeHash_ = 0;
+        volumeExtracted_ = false;
+        if (!volume_.hasData()) {
+            return;
+        }
+        setIsoValueRange(volume_.getData()->dataMap_.valueRange);
+    });
+    sparseVolume_.onChange([&]() {
+        if (sparseVolume_.hasData()) {
+            setIsoValueRange(sparseVolume_.getData()->getValueRange());
+        }
+    });
+}
+
+MarchingTetrahedra::~MarchingTetrahedra() {
+    if (cancelRefinement_) *cancelRefinement_ = true;
+    if (refinement_.valid()) refinement_.wait();
+}
+
+void MarchingTetrahedra::invalidate(InvalidationLevel invalidationLevel,
+                                    Property* modifiedProperty) {
+    // the outputs set in process do not make the refinement stale
+    if (invalidationLevel >= InvalidationLevel::InvalidOutput && !deliveringRefinement_) {
+        if (cancelRefinement_) *cancelRefinement_ = true;
+        refinedMesh_.reset();
+    }
+    Processor::invalidate(invalidationLevel, modifiedProperty);
+}
+
+void MarchingTetrahedra::setIsoValueRange(vec2 range) {
+    NetworkLock lock(getNetwork());
+    const float iso = (isoValue_.get() - isoValue_.getMinValue()) /
+                (isoValue_.getMaxValue() - isoValue_.getMinValue());
+    isoValue_.setMinValue(range.x);
+    isoValue_.setMaxValue(range.y);
+    isoValue_.setIncrement(glm::abs(range.y - range.x) / 50.0f);
+    isoValue_.set(iso * (range.y - range.x) + range.x);
+    isoValue_.setCurrentStateAsDefault();
+}
+
+std::uint64_t MarchingTetrahedra::getCacheKey(const Volume& volume, const std::vector<float>& isos,
+                                              const std::vector<vec4>& colors) {
+    const auto ram = volume.getRepresentation<VolumeRAM>();
+    const size3_t dims = ram->getDimensions();
+    const auto format = ram->getDataFormat()->getId();
+    const mat4 matrices[2] = {volume.getModelMatrix(), volume.getWorldMatrix()};
+    const int options[3] = {static_cast<int>(method_.get()), static_cast<int>(normals_.get()),
+                            adaptive_.isChecked() ? 1 : 0};
+    // as in process, relative to the value range
+    const auto range = volume.dataMap_.valueRange;
+    const float tolerance = adaptive_.isChecked()
+                                ? tolerance_.get() * static_cast<float>(range.y - range.x)
+                                : 0.0f;
+
+    if (volumeHash_ == 0) {
+        volumeHash_ = MeshCache::hash(ram->getData(),
+                                      dims.x * dims.y * dims.z * ram->getDataFormat()->getSize());
+        volumeHash_ = MeshCache::hash(&dims, sizeof(dims), volumeHash_);
+        volumeHash_ = MeshCache::hash(&format, sizeof(format), volumeHash_);
+    }
+    std::uint64_t key = MeshCache::hash(matrices, sizeof(matrices), volumeHash_);
+    key = MeshCache::hash(isos.data(), isos.size() * sizeof(float), key);
+    key = MeshCache::hash(colors.data(), colors.size() * sizeof(vec4), key);
+    key = MeshCache::hash(options, sizeof(options), key);
+    key = MeshCache::hash(&tolerance, sizeof(tolerance), key);
+    if (isClipped()) {
+        const auto box = getClipBox(dims);
+        key = MeshCache::hash(&box, sizeof(box), key);
+    }
+    // 0 stands for no key
+    return key != 0 ? key : 1;
+}
+
+MarchingTetrahedra::CellBox MarchingTetrahedra::getClipBox(size3_t dims) const {
+    const vec3 min(clipX_.getStart(), clipY_.getStart(), clipZ_.getStart());
+    const vec3 max(clipX_.getEnd(), clipY_.getEnd(), clipZ_.getEnd());
+    // the cells partly inside the box are kept
+    const vec3 cells = vec3(glm::max(dims, size3_t(1)) - size3_t(1));
+    return {size3_t(glm::floor(min * cells)), size3_t(glm::ceil(max * cells))};
+}
+
+bool MarchingTetrahedra::isClipped() const {
+    return clip_.isChecked() && !adaptive_.isChecked() && !bricked_.isChecked() &&
+           !temporal_.isChecked();
+}
+
+void MarchingTetrahedra::setExtractionStats(const ExtractionStats* stats) {
+    statsStatus_.set(stats ? "Measured" : "Not available in this mode");
+    for (Property* property : std::initializer_list<Property*>{
+             &cellSetupTime_, &classificationTime_, &interpolationTime_, &vertexDedupTime_,
+             &normalFinalizeTime_, &meshCopyTime_, &cellsVisited_, &activeCells_,
+             &dedupHitRate_, &peakEdgeMapSize_, &bytesAllocated_}) {
+        property->setVisible(stats != nullptr);
+    }
+    if (!stats) return;
+
+    using Phase = ExtractionStats::Phase;
+    auto milliseconds = [&](Phase phase) {
+        return static_cast<float>(stats->getSeconds(phase) * 1e3);
+    };
+    cellSetupTime_.set(milliseconds(Phase::CellSetup));
+    classificationTime_.set(milliseconds(Phase::Classification));
+    interpolationTime_.set(milliseconds(Phase::Interpolation));
+    vertexDedupTime_.set(milliseconds(Phase::VertexDedup));
+    normalFinalizeTime_.set(milliseconds(Phase::NormalFinalize));
+    meshCopyTime_.set(milliseconds(Phase::MeshCopy));
+    cellsVisited_.set(stats->getCellsVisited());
+    activeCells_.set(stats->getActiveCells());
+    dedupHitRate_.set(static_cast<float>(stats->getDedupHitRate()));
+    peakEdgeMapSize_.set(stats->getPeakEdgeMapSize());
+    bytesAllocated_.set(stats->getBytesAllocated());
+
+    if (!statsFile_.get().empty()) {
+        std::ofstream file(statsFile_.get());
+        file << stats->toJSON();
+        if (!file) {
+            throw FileException("Could not write the extraction stats to " + statsFile_.get(),
+                                IVW_CONTEXT);
+        }
+    }
+}
+
+void MarchingTetrahedra::process() {
+    std::vector<float> isos;
+    std::vector<vec4> colors;
+    if (multipleIsoValues_.get()) {
+        isos = detail::parseIsoValues(isoValues_.get());
+        for (size_t i = 0; i < isos.size(); ++i) {
+            const float hue = static_cast<float>(i) / static_cast<float>(isos.size());
+            colors.push_back(vec4(color::hsv2rgb(vec3(hue, 0.6f, 0.9f)), 1.0f));
+        }
+    }
+    if (isos.empty()) {
+        isos.push_back(isoValue_.get());
+        colors.push_back(vec4(0.7f, 0.7f, 0.7f, 1.0f));
+    }
+
+    // neither input takes priority over the other
+    if (!streamRawFile_.isChecked() && volume_.isConnected() && sparseVolume_.isConnected()) {
+        throw Exception("Connect either a volume or a sparse volume, not both", IVW_CONTEXT);
+    }
+
+    // the previous volume is only worth keeping while it is used
+    if (!temporal_.isChecked()) {
+        temporalMesh_.reset();
+    }
+    // any refinement still running was cancelled by the change that led here
+    refining_.set(false);
+
+    std::shared_ptr<BasicMesh> mesh;
+    ExtractionStats stats;
+    ExtractionStats* const instrumented = instrumentation_.isChecked() ? &stats : nullptr;
+    // only some of the extractions fill in the stats
+    bool measured = false;
+    if (streamRawFile_.isChecked()) {
+        skippedBricks_.set(0.0f);
+        mesh = extractRaw(rawFile_.get(), rawDimensions_.get(), rawFormat_.get(),
+                          rawHeaderSize_.get(), isos, colors, mat4(1.0f), mat4(1.0f),
+                          normals_.get(), method_.get());
+    } else if (sparseVolume_.hasData()) {
+        const auto sparse = sparseVolume_.getData();
+        skippedBricks_.set(0.0f);
+        mesh = extractSparse(*sparse, isos, colors, threads_.get(), normals_.get(),
+                             method_.get(), instrumented);
+        measured = true;
+    } else if (volume_.hasData()) {
+        std::shared_ptr<const Volume> volume = volume_.getData();
+        if (volume->getDataFormat()->getComponents() > 1) {
+            if (!firstChannel_) {
+                firstChannel_ = firstChannel(*volume);
+            }
+            volume = firstChannel_;
+        }
+        const auto ram = volume->getRepresentation<VolumeRAM>();
+
+        // the mesh of the same voxels with the same settings is read back instead of extracted
+        std::uint64_t cacheKey = 0;
+        if (diskCache_.isChecked() && !bricked_.isChecked() && !temporal_.isChecked()) {
+            cacheKey = getCacheKey(*volume, isos, colors);
+            mesh = diskCache_.find(cacheKey);
+        }
+        const bool cached = mesh != nullptr;
+        bool preview = false;
+
+        if (bricked_.isChecked()) {
+            processBricked(volume, isos, colors);
+            if (instrumented) {
+                setExtractionStats(nullptr);
+            }
+            return;
+        } else if (cached) {
+            skippedBricks_.set(0.0f);
+        } else if (refinedMesh_) {
+            // the full resolution mesh of the preview extracted last time
+            mesh = std::move(refinedMesh_);
+        } else if (temporal_.isChecked()) {
+            if (!temporalMesh_) {
+                temporalMesh_ = std::make_unique<TemporalMesh>();
+            }
+            skippedBricks_.set(0.0f);
+            extractedCells_.set(temporalMesh_->update(volume, isos, colors, normals_.get(),
+                                                      method_.get()));
+            mesh = temporalMesh_->getMesh();
+        } else if (adaptive_.isChecked()) {
+            if (!bricks_) {
+                bricks_ = std::make_shared<MinMaxBricks>(*ram);
+            }
+            // the tolerance is relative to the value range, as the iso value slider
+            const auto range = volume->dataMap_.valueRange;
+            skippedBricks_.set(0.0f);
+            mesh = extractAdaptive(volume, isos, colors,
+                                   tolerance_.get() * static_cast<float>(range.y - range.x),
+                                   bricks_.get(), normals_.get());
+        } else {
+            mesh = extractDense(volume, isos, colors, instrumented, preview);
+            measured = true;
+        }
+
+        // the preview is not the mesh of the key
+        if (cacheKey != 0 && !cached && !preview) diskCache_.insert(cacheKey, *mesh);
+    } else {
+        return;
+    }
 
-const ProcessorInfo MarchingTetrahedra::processorInfo_{
-    "org.inviwo.MarchingTetrahedra",  // Class identifier
-    "Marching Tetrahedra",            // Display name
-    "TNM067",                         // Category
-    CodeState::Experimental,          // Code state
-    Tags::None,                       // Tags
-};
-const ProcessorInfo MarchingTetrahedra::getProcessorInfo() const { return processorInfo_; }
+    if (instrumented) {
+        setExtractionStats(measured ? &stats : nullptr);
+    }
 
-MarchingTetrahedra::MarchingTetrahedra()
-    : Processor()
-    , volume_("volume")
-    , mesh_("mesh")
-    , isoValue_("isoValue", "ISO value", 0.5f, 0.0f, 1.0f) {
+    size_t triangles = 0;
+    for (size_t i = 0; i < mesh->getNumberOfIndicies(); ++i) {
+        triangles += mesh->getIndices(i)->getSize() / 3;
+    }
+    triangleCount_.set(triangles);
+    vertexCount_.set(mesh->getVertices()->getSize());
+    mesh_.setData(mesh);
+}
 
-    addPort(volume_);
-    addPort(mesh_);
+void MarchingTetrahedra::processBricked(std::shared_ptr<const Volume> volume,
+                                        const std::vector<float>& isos,
+                                        const std::vector<vec4>& colors) {
+    if (!brickedMesh_) {
+        brickedMesh_ = std::make_unique<BrickedMesh>(brickSize_.get());
+    }
+    skippedBricks_.set(0.0f);
+    updatedBricks_.set(brickedMesh_->update(volume, isos, colors, threads_.get(), method_.get()));
 
-    addProperty(isoValue_);
+    size_t triangles = 0;
+    size_t vertices = 0;
+    for (const auto& brick : brickedMesh_->getBricks()) {
+        if (!brick.mesh) continue;
+        for (size_t i = 0; i < brick.mesh->getNumberOfIndicies(); ++i) {
+            triangles += brick.mesh->getIndices(i)->getSize() / 3;
+        }
+        vertices += brick.mesh->getVertices()->getSize();
+    }
+    triangleCount_.set(triangles);
+    vertexCount_.set(vertices);
+    // the single mesh is left empty rather than joining the bricks again
+    mesh_.setData(std::make_shared<BasicMesh>());
+    brickMeshes_.setData(brickedMesh_->getMeshes());
+}
 
-    isoValue_.setSerializationMode(PropertySerializationMode::All);
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extractDense(std::shared_ptr<const Volume> volume,
+                                                            const std::vector<float>& isos,
+                                                            const std::vector<vec4>& colors,
+                                                            ExtractionStats* stats, bool& preview) {
+    const auto ram = volume->getRepresentation<VolumeRAM>();
+    const auto threads = threads_.get();
+    const auto normals = normals_.get();
+    const auto allocation = allocation_.get();
+    const auto method = method_.get();
+    const auto traversal = traversal_.get();
+    const bool clip = isClipped();
+    const auto dims = ram->getDimensions();
+    const auto box = getClipBox(dims);
+    std::function<std::shared_ptr<BasicMesh>(const std::atomic<bool>*, ExtractionStats*)>
+        extractFull;
+    const bool useIndex =
+        spanSpaceIndex_.get() && (index_ || volumeExtracted_) && SpanSpaceIndex::canIndex(dims) &&
+        SpanSpaceIndex::maxSizeInBytes(dims) <= (indexMemoryLimit_.get() << 20);
+    volumeExtracted_ = true;
 
-    volume_.onChange([&]() {
-        if (!volume_.hasData()) {
-            return;
+    std::shared_ptr<const MinMaxBricks> bricks;
+    if (skipEmptyBricks_.get()) {
+        if (!bricks_) {
+            bricks_ = std::make_shared<MinMaxBricks>(*ram);
         }
-        NetworkLock lock(getNetwork());
-        const float iso = (isoValue_.get() - isoValue_.getMinValue()) /
-                    (isoValue_.getMaxValue() - isoValue_.getMinValue());
-        const vec2 vr = volume_.getData()->dataMap_.valueRange;
-        isoValue_.setMinValue(vr.x);
-        isoValue_.setMaxValue(vr.y);
-        isoValue_.setIncrement(glm::abs(vr.y - vr.x) / 50.0f);
-        isoValue_.set(iso * (vr.y - vr.x) + vr.x);
-        isoValue_.setCurrentStateAsDefault();
+        bricks = bricks_;
+        skippedBricks_.set(bricks_->getSkippedFraction(isos));
+    } else {
+        skippedBricks_.set(0.0f);
+    }
+    if (useIndex) {
+        if (!index_) {
+            index_ = std::make_shared<SpanSpaceIndex>(*ram);
+        }
+        extractFull = [=, index = index_](const std::atomic<bool>* cancel,
+                                          ExtractionStats* fullStats) {
+            return extract(volume, isos, colors, *index, threads, normals, allocation, method,
+                           traversal, clip ? &box : nullptr, cancel, fullStats);
+        };
+    } else {
+        extractFull = [=](const std::atomic<bool>* cancel, ExtractionStats* fullStats) {
+            return extract(volume, isos, colors, threads, bricks.get(), normals, allocation,
+                           method, traversal, clip ? &box : nullptr, cancel, fullStats);
+        };
+    }
+
+    if (!progressive_.isChecked()) {
+        return extractFull(nullptr, stats);
+    }
+
+    // a preview of a subsampled volume now, the full resolution mesh is delivered through the
+    // next process, unless anything changes before that
+    const auto coarse = subsample(*volume, previewStride_.get());
+    const auto coarseBox = getClipBox(coarse->getDimensions());
+    auto mesh = extract(coarse, isos, colors, threads, nullptr, normals, allocation, method,
+                        traversal, clip ? &coarseBox : nullptr, nullptr, stats);
+    preview = true;
+
+    const auto cancel = std::make_shared<std::atomic<bool>>(false);
+    cancelRefinement_ = cancel;
+    refining_.set(true);
+    refinement_ = dispatchPool([this, cancel, extractFull]() {
+        auto refined = extractFull(cancel.get(), nullptr);
+        if (!refined) return;
+        dispatchFront([this, cancel, refined]() {
+            // the destructor sets cancel too, so this is never reached without it
+            if (*cancel) return;
+            deliveringRefinement_ = true;
+            refinedMesh_ = refined;
+            invalidate(InvalidationLevel::InvalidOutput);
+            deliveringRefinement_ = false;
+        });
     });
+    return mesh;
 }
 
-void MarchingTetrahedra::process() {
-    auto volume = volume_.getData()->getRepresentation<VolumeRAM>();
-    MeshHelper mesh(volume_.getData());
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extract(std::shared_ptr<const Volume> volume,
+                                                       float iso, size_t threads,
+                                                       const MinMaxBricks* bricks) {
+    return extract(volume, std::vector<float>{iso}, std::vector<vec4>{vec4(0.7f, 0.7f, 0.7f, 1.0f)},
+                   threads, bricks);
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extract(std::shared_ptr<const Volume> volume,
+                                                       float iso, const SpanSpaceIndex& index,
+                                                       size_t threads) {
+    return extract(volume, std::vector<float>{iso}, std::vector<vec4>{vec4(0.7f, 0.7f, 0.7f, 1.0f)},
+                   index, threads);
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extract(std::shared_ptr<const Volume> volume,
+                                                       const std::vector<float>& isos,
+                                                       const std::vector<vec4>& colors,
+                                                       size_t threads, const MinMaxBricks* bricks,
+                                                       Normals normals, Allocation allocation,
+                                                       Method method, Traversal traversal,
+                                                       const CellBox* roi,
+                                                       const std::atomic<bool>* cancel,
+                                                       ExtractionStats* stats) {
+    ivwAssert(isos.size() == colors.size(), "there should be one color per iso value");
+    if (volume->getDataFormat()->getComponents() > 1) {
+        return extract(firstChannel(*volume), isos, colors, threads, bricks, normals, allocation,
+                       method, traversal, roi, cancel, stats);
+    }
+    const auto ram = volume->getRepresentation<VolumeRAM>();
+    return extractSlabs(
+        volume, colors, normals, allocation, threads, roi, cancel, stats,
+        [&](size_t zBegin, size_t zEnd, auto& meshes, ExtractionStats* rangeStats) {
+            ram->dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+                detail::extractSlab(vrprecision->getDataTyped(), vrprecision->getDimensions(),
+                                    isos, zBegin, zEnd, bricks, method, traversal, roi, meshes,
+                                    rangeStats);
+            });
+        });
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extract(std::shared_ptr<const Volume> volume,
+                                                       const std::vector<float>& isos,
+                                                       const std::vector<vec4>& colors,
+                                                       const SpanSpaceIndex& index,
+                                                       size_t threads, Normals normals,
+                                                       Allocation allocation, Method method,
+                                                       Traversal traversal, const CellBox* roi,
+                                                       const std::atomic<bool>* cancel,
+                                                       ExtractionStats* stats) {
+    ivwAssert(isos.size() == colors.size(), "there should be one color per iso value");
+    if (volume->getDataFormat()->getComponents() > 1) {
+        return extract(firstChannel(*volume), isos, colors, index, threads, normals, allocation,
+                       method, traversal, roi, cancel, stats);
+    }
+    const auto ram = volume->getRepresentation<VolumeRAM>();
+    const auto dims = ram->getDimensions();
+
+    std::vector<std::uint32_t> cells;
+    for (auto iso : isos) {
+        const auto isoCells = index.query(iso);
+        std::vector<std::uint32_t> merged;
+        merged.reserve(cells.size() + isoCells.size());
+        std::set_union(cells.begin(), cells.end(), isoCells.begin(), isoCells.end(),
+                       std::back_inserter(merged));
+        cells.swap(merged);
+    }
+    if (roi) {
+        util::IndexMapper3D indexMapper(dims);
+        cells.erase(std::remove_if(cells.begin(), cells.end(),
+                                   [&](std::uint32_t cell) {
+                                       const size3_t pos = indexMapper(cell);
+                                       return glm::any(glm::lessThan(pos, roi->begin)) ||
+                                              !glm::all(glm::lessThan(pos, roi->end));
+                                   }),
+                    cells.end());
+    }
+    if (traversal == Traversal::Morton) {
+        // the planes stay in order, as extractSlabs splits them by index
+        const size_t tileSize = MinMaxBricks::brickSize;
+        auto order = [&](std::uint32_t cell) {
+            const size_t x = cell % dims.x;
+            const size_t y = (cell / dims.x) % dims.y;
+            return std::make_tuple(cell / (dims.x * dims.y),
+                                   detail::mortonCode(static_cast<std::uint32_t>(x / tileSize),
+                                                      static_cast<std::uint32_t>(y / tileSize)),
+                                   cell);
+        };
+        std::sort(cells.begin(), cells.end(),
+                  [&](std::uint32_t a, std::uint32_t b) { return order(a) < order(b); });
+    }
+
+    return extractSlabs(
+        volume, colors, normals, allocation, threads, roi, cancel, stats,
+        [&](size_t zBegin, size_t zEnd, auto& meshes, ExtractionStats* rangeStats) {
+            const auto begin =
+                std::lower_bound(cells.begin(), cells.end(), zBegin * dims.x * dims.y);
+            const auto end = std::lower_bound(begin, cells.end(), zEnd * dims.x * dims.y);
+            ram->dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+                detail::extractCells(vrprecision->getDataTyped(), vrprecision->getDimensions(),
+                                     isos, cells.data() + (begin - cells.begin()),
+                                     cells.data() + (end - cells.begin()), method, meshes,
+                                     rangeStats);
+            });
+        });
+}
+
+std::shared_ptr<Volume> MarchingTetrahedra::subsample(const Volume& volume, size_t stride) {
+    const auto ram = volume.getRepresentation<VolumeRAM>();
+    const size3_t dims = ram->getDimensions();
+    const size3_t coarse = (glm::max(dims, size3_t(1)) - size3_t(1)) / stride + size3_t(1);
+
+    auto result = ram->dispatch<std::shared_ptr<Volume>, dispatching::filter::Scalars>(
+        [&](auto vrprecision) {
+            using T = util::PrecisionValueType<decltype(vrprecision)>;
+            const T* data = vrprecision->getDataTyped();
+            auto subsampled = std::make_shared<VolumeRAMPrecision<T>>(coarse);
+            T* out = subsampled->getDataTyped();
+            for (size_t z = 0; z < coarse.z; ++z) {
+                for (size_t y = 0; y < coarse.y; ++y) {
+                    const T* row = data + dims.x * (y * stride + dims.y * z * stride);
+                    for (size_t x = 0; x < coarse.x; ++x) {
+                        *out++ = row[x * stride];
+                    }
+                }
+            }
+            return std::make_shared<Volume>(subsampled);
+        });
+
+    // the last voxel kept is not the last one of the volume unless stride divides its size
+    vec3 scale(1.0f);
+    for (size_t axis = 0; axis < 3; ++axis) {
+        if (dims[axis] > 1) {
+            scale[axis] = static_cast<float>((coarse[axis] - 1) * stride) /
+                          static_cast<float>(dims[axis] - 1);
+        }
+    }
+    result->setModelMatrix(glm::scale(volume.getModelMatrix(), scale));
+    result->setWorldMatrix(volume.getWorldMatrix());
+    result->dataMap_ = volume.dataMap_;
+    return result;
+}
+
+std::shared_ptr<Volume> MarchingTetrahedra::firstChannel(const Volume& volume) {
+    const auto ram = volume.getRepresentation<VolumeRAM>();
+    const size3_t dims = ram->getDimensions();
+
+    auto result = ram->dispatch<std::shared_ptr<Volume>>([&](auto vrprecision) {
+        using T = util::PrecisionValueType<decltype(vrprecision)>;
+        using P = typename util::value_type<T>::type;
+        const T* data = vrprecision->getDataTyped();
+        auto channel = std::make_shared<VolumeRAMPrecision<P>>(dims);
+        P* out = channel->getDataTyped();
+        for (size_t i = 0; i < dims.x * dims.y * dims.z; ++i) {
+            out[i] = util::glmcomp(data[i], 0);
+        }
+        return std::make_shared<Volume>(channel);
+    });
+
+    result->setModelMatrix(volume.getModelMatrix());
+    result->setWorldMatrix(volume.getWorldMatrix());
+    result->dataMap_ = volume.dataMap_;
+    return result;
+}
 
+template <typename ExtractRange>
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extractSlabs(std::shared_ptr<const Volume> volume,
+                                                            const std::vector<vec4>& colors,
+                                                            Normals normals, Allocation allocation,
+                                                            size_t threads, const CellBox* roi,
+                                                            const std::atomic<bool>* cancel,
+                                                            ExtractionStats* stats,
+                                                            ExtractRange extractRange) {
     const auto dims = volume->getDimensions();
-    MarchingTetrahedra::HashFunc::max = dims.x * dims.y * dims.z;
 
-    float iso = isoValue_.get();
+    size_t zBegin = 0;
+    size_t zEnd = dims.z > 1 ? dims.z - 1 : 0;
+    if (roi) {
+        zEnd = std::min(zEnd, roi->end.z);
+        zBegin = std::min(roi->begin.z, zEnd);
+    }
+    const size_t slabCount = std::max<size_t>(1, std::min(threads, zEnd - zBegin));
+    auto slabBegin = [&](size_t slab) { return zBegin + slab * (zEnd - zBegin) / slabCount; };
+    // the first slab has no slab below to share its first plane with
+    auto seamPlane = [&](size_t slab) { return slab == 0 ? 0 : slabBegin(slab); };
 
-    util::IndexMapper3D indexMapper(dims);
+    // with cancel the planes are extracted one at a time, so that it is noticed in time
+    auto cancelled = [&]() { return cancel && cancel->load(std::memory_order_relaxed); };
+    auto extractPlanes = [&](size_t begin, size_t end, auto& meshes,
+                             ExtractionStats* planeStats) {
+        if (!cancel) {
+            extractRange(begin, end, meshes, planeStats);
+            return;
+        }
+        for (size_t z = begin; z < end && !cancelled(); ++z) {
+            extractRange(z, z + 1, meshes, planeStats);
+        }
+    };
+    // each slab has an edge cache per layer
+    const size_t edgeCacheCapacity = slabCount * colors.size() * EdgeIndexCache::capacity(dims);
+
+    if (allocation == Allocation::Incremental) {
+        std::vector<MeshHelper> layers;
+        for (const auto& color : colors) {
+            layers.emplace_back(volume, color, normals);
+        }
+
+        std::vector<std::vector<MeshHelper>> slabs(slabCount, layers);
+        util::parallelFor(slabCount, [&](size_t i) {
+            extractPlanes(slabBegin(i), slabBegin(i + 1), slabs[i], stats);
+        });
+        if (cancelled()) return nullptr;
+
+        size_t bytes = 0;
+        if (stats) {
+            for (const auto& slab : slabs) {
+                for (const auto& helper : slab) {
+                    bytes += helper.getSizeInBytes();
+                }
+            }
+        }
+        layers = std::move(slabs.front());
+        {
+            ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::MeshCopy);
+            for (size_t i = 1; i < slabCount; ++i) {
+                for (size_t layer = 0; layer < layers.size(); ++layer) {
+                    layers[layer].append(std::move(slabs[i][layer]));
+                }
+            }
+        }
+        auto mesh = MeshHelper::toBasicMesh(layers, stats);
+        if (stats) {
+            stats->updateEdgeMapSize(edgeCacheCapacity);
+            stats->addBytesAllocated(bytes + detail::getSizeInBytes(*mesh));
+        }
+        return mesh;
+    }
+
+    if (allocation == Allocation::Shared) {
+        // As there are no seams the threads take the planes one at a time, so that none of them
+        // runs out of work early
+        auto mesh = detail::extractShared(
+            dims, colors, normals, zEnd - zBegin, threads,
+            std::max<size_t>(size_t(1) << 16,
+                             2 * (dims.x * dims.y + dims.y * dims.z + dims.z * dims.x)),
+            cancel, stats, [&](auto& meshes) {
+                return [&](size_t plane) {
+                    extractRange(zBegin + plane, zBegin + plane + 1, meshes, stats);
+                };
+            });
+        if (mesh) {
+            mesh->setModelMatrix(volume->getModelMatrix());
+            mesh->setWorldMatrix(volume->getWorldMatrix());
+        }
+        return mesh;
+    }
+
+    // First pass: count the vertices and triangles of each layer in each slab. The prefix sums
+    // give where they go in the mesh, vertices ordered by layer and then by slab.
+    const size_t layerCount = colors.size();
+    std::vector<std::uint32_t> firstVertex(layerCount * slabCount);
+    std::vector<size_t> firstIndex(layerCount * slabCount);
+    std::vector<size_t> indexCounts(layerCount, 0);
+    size_t vertexCount = 0;
+    size_t bytes = 0;
+    {
+        std::vector<std::vector<detail::MeshCounter>> counters(slabCount);
+        for (size_t i = 0; i < slabCount; ++i) {
+            for (size_t layer = 0; layer < layerCount; ++layer) {
+                counters[i].emplace_back(dims, seamPlane(i));
+            }
+        }
+        // the counting pass is left out of the stats, it would count every vertex as a hit
+        util::parallelFor(slabCount, [&](size_t i) {
+            extractPlanes(slabBegin(i), slabBegin(i + 1), counters[i], nullptr);
+        });
+        if (cancelled()) return nullptr;
+
+        for (size_t layer = 0; layer < layerCount; ++layer) {
+            for (size_t i = 0; i < slabCount; ++i) {
+                firstVertex[layer * slabCount + i] = static_cast<std::uint32_t>(vertexCount);
+                firstIndex[layer * slabCount + i] = indexCounts[layer];
+                vertexCount += counters[i][layer].getVertexCount();
+                indexCounts[layer] += 3 * counters[i][layer].getTriangleCount();
+                bytes += counters[i][layer].getSizeInBytes();
+            }
+        }
+    }
+
+    // The buffers are allocated once, at their final size
+    auto mesh = std::make_shared<BasicMesh>();
+    mesh->setModelMatrix(volume->getModelMatrix());
+    mesh->setWorldMatrix(volume->getWorldMatrix());
+    auto& positions =
+        mesh->getEditableVertices()->getEditableRAMRepresentation()->getDataContainer();
+    auto& vertexNormals =
+        mesh->getEditableNormals()->getEditableRAMRepresentation()->getDataContainer();
+    auto& texCoords =
+        mesh->getEditableTexCoords()->getEditableRAMRepresentation()->getDataContainer();
+    auto& vertexColors =
+        mesh->getEditableColors()->getEditableRAMRepresentation()->getDataContainer();
+    positions.resize(vertexCount);
+    vertexNormals.resize(vertexCount);
+    texCoords.resize(vertexCount);
+    vertexColors.resize(vertexCount);
+    std::vector<std::vector<std::uint32_t>*> indexBuffers;
+    for (size_t layer = 0; layer < layerCount; ++layer) {
+        auto& indices =
+            mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)->getDataContainer();
+        indices.resize(indexCounts[layer]);
+        indexBuffers.push_back(&indices);
+    }
+
+    // Second pass: fill in the vertices and triangles of each slab in parallel. Indices past the
+    // last vertex stand for vertices on the seam to the slab below until that one is done.
+    const detail::MeshWriter::Buffers buffers{positions.data(), vertexNormals.data(),
+                                              texCoords.data(), vertexColors.data()};
+    std::vector<std::vector<detail::MeshWriter>> writers(slabCount);
+    for (size_t i = 0; i < slabCount; ++i) {
+        for (size_t layer = 0; layer < layerCount; ++layer) {
+            writers[i].emplace_back(dims, seamPlane(i), normals, colors[layer], buffers,
+                                    firstVertex[layer * slabCount + i],
+                                    indexBuffers[layer]->data() + firstIndex[layer * slabCount + i],
+                                    static_cast<std::uint32_t>(vertexCount));
+        }
+    }
+    util::parallelFor(slabCount, [&](size_t i) {
+        extractPlanes(slabBegin(i), slabBegin(i + 1), writers[i], stats);
+    });
+    if (cancelled()) return nullptr;
+    util::parallelFor(slabCount, [&](size_t i) {
+        for (size_t layer = 0; i > 0 && layer < layerCount; ++layer) {
+            writers[i][layer].resolveSeam(writers[i - 1][layer]);
+        }
+    });
+    ivwAssert(writers.back().empty() ||
+                  writers.back().back().getNextVertex() == vertexCount,
+              "the second pass should create the vertices counted in the first");
+
+    // Accumulated in triangle order as in MeshHelper, so the normals are the same
+    if (normals == Normals::FaceAccumulated) {
+        ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::NormalFinalize);
+        for (const auto indices : indexBuffers) {
+            detail::accumulateFaceNormals(positions, *indices, vertexNormals);
+        }
+        for (auto& normal : vertexNormals) {
+            normal = glm::normalize(normal);
+        }
+    }
+    if (stats) {
+        for (const auto& slab : writers) {
+            for (const auto& writer : slab) {
+                bytes += writer.getSizeInBytes();
+            }
+        }
+        stats->updateEdgeMapSize(edgeCacheCapacity);
+        stats->addBytesAllocated(bytes + detail::getSizeInBytes(*mesh));
+    }
+    return mesh;
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extractRaw(
+    const std::string& file, size3_t dims, DataFormatId format, size_t byteOffset,
+    const std::vector<float>& isos, const std::vector<vec4>& colors, const mat4& modelMatrix,
+    const mat4& worldMatrix, Normals normals, Method method) {
+    ivwAssert(isos.size() == colors.size(), "there should be one color per iso value");
+    if (dims.x == 0 || dims.y == 0 || dims.z == 0) {
+        throw Exception("Invalid volume dimensions " + toString(dims),
+                        IVW_CONTEXT_CUSTOM("MarchingTetrahedra"));
+    }
+
+    std::vector<MeshHelper> layers;
+    for (const auto& color : colors) {
+        layers.emplace_back(dims, modelMatrix, worldMatrix, color, normals);
+    }
+
+    MappedFile mappedFile(file);
+    auto extract = [&](auto type) {
+        using T = decltype(type);
+        if (byteOffset % sizeof(T) != 0) {
+            throw Exception("The header size has to be a multiple of the voxel size",
+                            IVW_CONTEXT_CUSTOM("MarchingTetrahedra"));
+        }
+        if (mappedFile.size() < byteOffset + dims.x * dims.y * dims.z * sizeof(T)) {
+            throw FileException("File is too small for a volume of " + toString(dims) + ": " +
+                                    file,
+                                IVW_CONTEXT_CUSTOM("MarchingTetrahedra"));
+        }
+        detail::extractRaw<T>(mappedFile, byteOffset, dims, isos, method, layers);
+    };
+    switch (format) {
+        case DataFormatId::Int8:
+            extract(std::int8_t{});
+            break;
+        case DataFormatId::UInt8:
+            extract(std::uint8_t{});
+            break;
+        case DataFormatId::Int16:
+            extract(std::int16_t{});
+            break;
+        case DataFormatId::UInt16:
+            extract(std::uint16_t{});
+            break;
+        case DataFormatId::Int32:
+            extract(std::int32_t{});
+            break;
+        case DataFormatId::UInt32:
+            extract(std::uint32_t{});
+            break;
+        case DataFormatId::Float32:
+            extract(float{});
+            break;
+        case DataFormatId::Float64:
+            extract(double{});
+            break;
+        default:
+            throw Exception("Unsupported raw volume format",
+                            IVW_CONTEXT_CUSTOM("MarchingTetrahedra"));
+    }
+
+    return MeshHelper::toBasicMesh(layers);
+}
 
-    const static size_t tetrahedraIds[6][4] = {{0, 1, 2, 5}, {1, 3, 2, 5}, {3, 2, 5, 7},
-                                               {0, 2, 4, 5}, {6, 4, 2, 5}, {6, 7, 5, 2}};
-
-    size3_t pos;
-    for (pos.z = 0; pos.z < dims.z - 1; ++pos.z) {
-        for (pos.y = 0; pos.y < dims.y - 1; ++pos.y) {
-            for (pos.x = 0; pos.x < dims.x - 1; ++pos.x) {
-                // Step 1: create current cell
-                // Use volume->getAsDouble to query values from the volume
-                // Spatial position should be between 0 and 1
-                // The voxel index should be the 1D-index for the voxel
-                Cell c;
-
-				int CELL_SIZE = 2;
-
-				for (int z = 0; z < CELL_SIZE; z++) {
-					for (int y = 0; y < CELL_SIZE; y++) {
-						for (int x = 0; x < CELL_SIZE; x++) {
-							// index
-							int index = (z * CELL_SIZE * CELL_SIZE) + (y * CELL_SIZE) + x;
-
-							// value for voxel
-							size3_t query_pos{ pos.x + x, pos.y + y, pos.z + z };
-
-							// positions
-							c.voxels[index].pos.x = (pos.x + x) / (dims.x - 1.0);
-							c.voxels[index].pos.y = (pos.y + y) / (dims.y - 1.0);
-							c.voxels[index].pos.z = (pos.z + z) / (dims.z - 1.0);
-
-							c.voxels[index].index = indexMapper(query_pos);
-
-							c.voxels[index].value = volume->getAsDouble(query_pos);
-						}
-					}
-				}
-
-                // Step 2: Subdivide cell into tetrahedra (hint: use tetrahedraIds)
-                std::vector<Tetrahedra> tetrahedras;
-
-				for (size_t i = 0; i < 6; ++i) {
-					Tetrahedra t;
-					for (size_t j = 0; j < 4; ++j) {
-						t.voxels[j] = c.voxels[tetrahedraIds[i][j]];
-					}
-					tetrahedras.push_back(t);
-				}
-
-                for (const Tetrahedra& tetrahedra : tetrahedras) {
-                    // Step three: Calculate for tetra case index
-                    int caseId = 0;
-
-					Voxel v0 = tetrahedra.voxels[0];
-					Voxel v1 = tetrahedra.voxels[1];
-					Voxel v2 = tetrahedra.voxels[2];
-					Voxel v3 = tetrahedra.voxels[3];
-
-					if (v0.value < iso)
-						caseId += 1;
-					if (v1.value < iso)
-						caseId += 2;
-					if (v2.value < iso)
-						caseId += 4;
-					if (v3.value < iso)
-						caseId += 8;
-
-					vec3 interp0, interp1, interp2, interp3;
-
-					uint32_t i0, i1, i2, i3;
-
-                    // step four: Extract triangles
-					switch (caseId) {
-						case 0: case 15:
-							break;
-						case 1: case 14: {
-							// interpolation: where are we on the edge? interp_pos = origin + direction * iso_distance = origin + (end - origin) * (iso - origin.iso) / (end.iso - origin.iso)
-							interp0 = v0.pos + (v1.pos - v0.pos) * ((iso - v0.value) / (v1.value - v0.value)); // 0-1
-							interp1 = v0.pos + (v2.pos - v0.pos) * ((iso - v0.value) / (v2.value - v0.value)); // 0-2
-							interp2 = v0.pos + (v3.pos - v0.pos) * ((iso - v0.value) / (v3.value - v0.value)); // 0-3
-
-							i0 = mesh.addVertex(interp0, v0.index, v1.index);
-							i1 = mesh.addVertex(interp1, v0.index, v2.index);
-							i2 = mesh.addVertex(interp2, v0.index, v3.index);
-
-							if (caseId == 1) {
-								mesh.addTriangle(i0, i2, i1);
-							}
-							else {
-								mesh.addTriangle(i0, i1, i2);
-							}
-							break;
-						}
-						case 2: case 13: {
-							// interpolation: where are we on the edge? interp_pos = origin + direction * iso_distance = origin + (end - origin) * (iso - origin.iso) / (end.iso - origin.iso)
-							interp0 = v1.pos + (v0.pos - v1.pos) * ((iso - v1.value) / (v0.value - v1.value)); //1-0
-							interp1 = v1.pos + (v2.pos - v1.pos) * ((iso - v1.value) / (v2.value - v1.value)); //1-2
-							interp2 = v1.pos + (v3.pos - v1.pos) * ((iso - v1.value) / (v3.value - v1.value)); //1-3 
-
-							i0 = mesh.addVertex(interp0, v1.index, v0.index);
-							i1 = mesh.addVertex(interp1, v1.index, v2.index);
-							i2 = mesh.addVertex(interp2, v1.index, v3.index);
-
-							if (caseId == 2) {
-								mesh.addTriangle(i0, i1, i2);
-							}
-							else {
-								mesh.addTriangle(i0, i2, i1);
-							}
-							break;
-
-						}
-						case 3: case 12: {
-							// interpolation: where are we on the edge? interp_pos = origin + direction * iso_distance = origin + (end - origin) * (iso - origin.iso) / (end.iso - origin.iso)
-							interp0 = v0.pos + (v2.pos - v0.pos) * ((iso - v0.value) / (v2.value - v0.value)); //0-2
-							interp1 = v0.pos + (v3.pos - v0.pos) * ((iso - v0.value) / (v3.value - v0.value)); //0-3
-							interp2 = v1.pos + (v2.pos - v1.pos) * ((iso - v1.value) / (v2.value - v1.value)); //1-2
-							interp3 = v1.pos + (v3.pos - v1.pos) * ((iso - v1.value) / (v3.value - v1.value)); //1-3 
-
-							i0 = mesh.addVertex(interp0, v0.index, v2.index);
-							i1 = mesh.addVertex(interp1, v0.index, v3.index);
-							i2 = mesh.addVertex(interp2, v1.index, v2.index);
-							i3 = mesh.addVertex(interp3, v1.index, v3.index);
-
-							if (caseId == 3) {
-								// left triangle
-								mesh.addTriangle(i1, i2, i3);
-								// right triangle
-								mesh.addTriangle(i0, i2, i1);
-							}
-							else {
-								// left triangle
-								mesh.addTriangle(i1, i3, i2);
-								// right triangle
-								mesh.addTriangle(i0, i1, i2);	
-							}
-							break;
-
-						}
-						case 4: case 11: {
-							// interpolation: where are we on the edge? interp_pos = origin + direction * iso_distance = origin + (end - origin) * (iso - origin.iso) / (end.iso - origin.iso)
-							interp0 = v2.pos + (v0.pos - v2.pos) * ((iso - v2.value) / (v0.value - v2.value)); //2-0
-							interp1 = v2.pos + (v1.pos - v2.pos) * ((iso - v2.value) / (v1.value - v2.value)); //2-1
-							interp2 = v2.pos + (v3.pos - v2.pos) * ((iso - v2.value) / (v3.value - v2.value)); //2-3 
-
-							i0 = mesh.addVertex(interp0, v2.index, v0.index);
-							i1 = mesh.addVertex(interp1, v2.index, v1.index);
-							i2 = mesh.addVertex(interp2, v2.index, v3.index);
-
-							if (caseId == 4) {
-								mesh.addTriangle(i0, i2, i1);
-							}
-							else {
-								mesh.addTriangle(i0, i1, i2);
-							}
-							break;
-
-						}
-						case 5: case 10: {
-							// interpolation: where are we on the edge? interp_pos = origin + direction * iso_distance = origin + (end - origin) * (iso - origin.iso) / (end.iso - origin.iso)
-							interp0 = v0.pos + (v1.pos - v0.pos) * ((iso - v0.value) / (v1.value - v0.value)); //0-1
-							interp1 = v0.pos + (v3.pos - v0.pos) * ((iso - v0.value) / (v3.value - v0.value)); //0-3
-							interp2 = v2.pos + (v1.pos - v2.pos) * ((iso - v2.value) / (v1.value - v2.value)); //2-1
-							interp3 = v2.pos + (v3.pos - v2.pos) * ((iso - v2.value) / (v3.value - v2.value)); //2-3 
-
-							i0 = mesh.addVertex(interp0, v0.index, v1.index);
-							i1 = mesh.addVertex(interp1, v0.index, v3.index);
-							i2 = mesh.addVertex(interp2, v2.index, v1.index);
-							i3 = mesh.addVertex(interp3, v2.index, v3.index);
-
-							if (caseId == 5) {
-								// left triangle
-								mesh.addTriangle(i0, i1, i2);
-								// right triangle
-								mesh.addTriangle(i1, i3, i2);
-							}
-							else {
-								// left triangle
-								mesh.addTriangle(i0, i2, i1);
-								// right triangle
-								mesh.addTriangle(i1, i2, i3);
-							}
-							break;
-
-						}
-						case 6: case 9: {
-							// interpolation: where are we on the edge? interp_pos = origin + direction * iso_distance = origin + (end - origin) * (iso - origin.iso) / (end.iso - origin.iso)
-							interp0 = v1.pos + (v0.pos - v1.pos) * ((iso - v1.value) / (v0.value - v1.value)); //1-0
-							interp1 = v1.pos + (v3.pos - v1.pos) * ((iso - v1.value) / (v3.value - v1.value)); //1-3
-							interp2 = v2.pos + (v0.pos - v2.pos) * ((iso - v2.value) / (v0.value - v2.value)); //2-0
-							interp3 = v2.pos + (v3.pos - v2.pos) * ((iso - v2.value) / (v3.value - v2.value)); //2-3 
-
-							i0 = mesh.addVertex(interp0, v1.index, v0.index);
-							i1 = mesh.addVertex(interp1, v1.index, v3.index);
-							i2 = mesh.addVertex(interp2, v2.index, v0.index);
-							i3 = mesh.addVertex(interp3, v2.index, v3.index);
-
-							if (caseId == 5) {
-								// left triangle
-								mesh.addTriangle(i0, i2, i1);
-								// right triangle
-								mesh.addTriangle(i2, i3, i1);
-							}
-							else {
-								// left triangle
-								mesh.addTriangle(i0, i1, i2);
-								// right triangle
-								mesh.addTriangle(i2, i1, i3);
-							}
-							break;
-
-						}
-						case 7: case 8: {
-							// interpolation: where are we on the edge? interp_pos = origin + direction * iso_distance = origin + (end - origin) * (iso - origin.iso) / (end.iso - origin.iso)
-							interp0 = v0.pos + (v3.pos - v0.pos) * ((iso - v0.value) / (v3.value - v0.value)); //0-3
-							interp1 = v1.pos + (v3.pos - v1.pos) * ((iso - v1.value) / (v3.value - v1.value)); //1-3
-							interp2 = v2.pos + (v3.pos - v2.pos) * ((iso - v2.value) / (v3.value - v2.value)); //2-3 
-
-							i0 = mesh.addVertex(interp0, v0.index, v3.index);
-							i1 = mesh.addVertex(interp1, v1.index, v3.index);
-							i2 = mesh.addVertex(interp2, v2.index, v3.index);
-
-							if (caseId == 7) {
-								mesh.addTriangle(i0, i2, i1);
-							}
-							else {
-								mesh.addTriangle(i0, i1, i2);
-							}
-							break;
-						}
-					}
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extractSparse(const SparseVolume& volume,
+                                                             const std::vector<float>& isos,
+                                                             const std::vector<vec4>& colors,
+                                                             size_t threads, Normals normals,
+                                                             Method method,
+                                                             ExtractionStats* stats) {
+    ivwAssert(isos.size() == colors.size(), "there should be one color per iso value");
+    const size3_t dims = volume.getDimensions();
+    constexpr size_t blockSize = SparseVolume::blockSize;
+    const size3_t cells = glm::max(dims, size3_t(1)) - size3_t(1);
+    const size3_t cellBlocks = (cells + size3_t(blockSize - 1)) / blockSize;
 
+    // The corners of the cells of a block are in the voxel blocks with the same or one higher
+    // index along each axis
+    const size3_t blockDims = volume.getBlockDimensions();
+    const util::IndexMapper3D cellBlockIndex(cellBlocks);
+    std::vector<char> needed(cellBlocks.x * cellBlocks.y * cellBlocks.z, 0);
+    size3_t block;
+    for (block.z = 0; block.z < blockDims.z; ++block.z) {
+        for (block.y = 0; block.y < blockDims.y; ++block.y) {
+            for (block.x = 0; block.x < blockDims.x; ++block.x) {
+                if (!volume.getBlock(block)) continue;
+                for (size_t corner = 0; corner < 8; ++corner) {
+                    const size3_t offset(corner & 1, (corner >> 1) & 1, corner >> 2);
+                    if (glm::any(glm::lessThan(block, offset))) continue;
+                    const size3_t cellBlock = block - offset;
+                    if (glm::all(glm::lessThan(cellBlock, cellBlocks))) {
+                        needed[cellBlockIndex(cellBlock)] = 1;
+                    }
                 }
             }
         }
     }
+    std::vector<size3_t> blocks;
+    for (size_t i = 0; i < needed.size(); ++i) {
+        if (needed[i]) blocks.push_back(cellBlockIndex(i));
+    }
+
+    // the voxels of the cells of a block and, for gradients, the voxels next to them
+    const size_t margin = normals == Normals::Gradient ? 1 : 0;
+    auto mesh = detail::extractShared(
+        dims, colors, normals, blocks.size(), threads,
+        std::max<size_t>(size_t(1) << 16, 4 * blockSize * blockSize * blocks.size()), nullptr,
+        stats, [&](auto& meshes) {
+            using Mesh = typename std::decay_t<decltype(meshes)>::value_type;
+            return [&, voxels = std::vector<float>(),
+                    extractor = detail::CellExtractor<float, Mesh>(
+                        nullptr, dims, isos, meshes, method, stats)](size_t item) mutable {
+                const size3_t first = blocks[item] * blockSize;
+                const size3_t last = glm::min(first + size3_t(blockSize), cells);
+                const size3_t origin = glm::max(first, size3_t(margin)) - size3_t(margin);
+                const size3_t boxDims = glm::min(last + size3_t(1 + margin), dims) - origin;
+                voxels.resize(boxDims.x * boxDims.y * boxDims.z);
+                volume.copyBox(origin, boxDims, voxels.data());
+
+                extractor.setData(voxels.data(), origin, boxDims);
+                for (size_t z = first.z; z < last.z; ++z) {
+                    for (size_t y = first.y; y < last.y; ++y) {
+                        extractor.extractRun(first.x, last.x, y, z);
+                    }
+                }
+            };
+        });
+    mesh->setModelMatrix(volume.getModelMatrix());
+    mesh->setWorldMatrix(volume.getWorldMatrix());
+    return mesh;
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extractAdaptive(
+    std::shared_ptr<const Volume> volume, const std::vector<float>& isos,
+    const std::vector<vec4>& colors, float tolerance, const MinMaxBricks* bricks,
+    Normals normals) {
+    ivwAssert(isos.size() == colors.size(), "there should be one color per iso value");
+    const auto ram = volume->getRepresentation<VolumeRAM>();
+
+    std::unique_ptr<MinMaxBricks> ownBricks;
+    if (!bricks) {
+        ownBricks = std::make_unique<MinMaxBricks>(*ram);
+        bricks = ownBricks.get();
+    }
 
-    mesh_.setData(mesh.toBasicMesh());
+    std::vector<MeshHelper> layers;
+    for (const auto& color : colors) {
+        layers.emplace_back(volume, color, normals);
+    }
+    util::parallelFor(isos.size(), [&](size_t layer) {
+        const IsoOctree octree(*ram, isos[layer], tolerance, bricks);
+        ram->dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+            detail::extractAdaptive(vrprecision->getDataTyped(), vrprecision->getDimensions(),
+                                    octree, isos[layer], layers[layer]);
+        });
+    });
+    return MeshHelper::toBasicMesh(layers);
 }
 
-MarchingTetrahedra::MeshHelper::MeshHelper(std::shared_ptr<const Volume> vol)
-    : edgeToVertex_()
-    , vertices_()
-    , mesh_(std::make_shared<BasicMesh>())
-    , indexBuffer_(mesh_->addIndexBuffer(DrawType::Triangles, ConnectivityType::None).get()) {
-    mesh_->setModelMatrix(vol->getModelMatrix());
-    mesh_->setWorldMatrix(vol->getWorldMatrix());
+MarchingTetrahedra::BrickedMesh::BrickedMesh(size_t brickSize)
+    : brickSize_(std::max<size_t>(brickSize, 1))
+    , dims_(0)
+    , format_(nullptr)
+    , modelMatrix_(1.0f)
+    , worldMatrix_(1.0f)
+    , isos_()
+    , colors_()
+    , method_(Method::Tetrahedra)
+    , bricks_()
+    , voxels_() {}
+
+size_t MarchingTetrahedra::BrickedMesh::update(std::shared_ptr<const Volume> volume,
+                                               const std::vector<float>& isos,
+                                               const std::vector<vec4>& colors, size_t threads,
+                                               Method method) {
+    ivwAssert(isos.size() == colors.size(), "there should be one color per iso value");
+    const auto ram = volume->getRepresentation<VolumeRAM>();
+    const size3_t dims = ram->getDimensions();
+
+    // Anything but the iso values changing affects every brick
+    const bool reset = dims != dims_ || ram->getDataFormat() != format_ ||
+                       volume->getModelMatrix() != modelMatrix_ ||
+                       volume->getWorldMatrix() != worldMatrix_ || colors != colors_ ||
+                       method != method_;
+    const bool isosChanged = isos != isos_;
+    if (dims != dims_) {
+        size3_t cells(0);
+        size3_t count(0);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            cells[axis] = dims[axis] > 1 ? dims[axis] - 1 : 0;
+            count[axis] = (cells[axis] + brickSize_ - 1) / brickSize_;
+        }
+        // as in voxelCoords, without dividing by zero for a single voxel plane
+        const vec3 spacing = vec3(glm::max(cells, size3_t(1)));
+        bricks_.clear();
+        size3_t brick;
+        for (brick.z = 0; brick.z < count.z; ++brick.z) {
+            for (brick.y = 0; brick.y < count.y; ++brick.y) {
+                for (brick.x = 0; brick.x < count.x; ++brick.x) {
+                    const size3_t origin = brick * brickSize_;
+                    const size3_t end = glm::min(origin + size3_t(brickSize_), cells);
+                    bricks_.push_back(
+                        {origin, vec3(origin) / spacing, vec3(end) / spacing, nullptr});
+                }
+            }
+        }
+        voxels_.assign(bricks_.size(), {});
+    }
+    dims_ = dims;
+    format_ = ram->getDataFormat();
+    modelMatrix_ = volume->getModelMatrix();
+    worldMatrix_ = volume->getWorldMatrix();
+    isos_ = isos;
+    colors_ = colors;
+    method_ = method;
+
+    const size_t workers = std::max<size_t>(1, std::min(threads, bricks_.size()));
+    std::vector<char> replaced(bricks_.size(), 0);
+    ram->dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+        const auto data = vrprecision->getDataTyped();
+        // the gradient normals read one voxel further
+        const size_t border = 1;
+
+        util::parallelFor(workers, [&](size_t worker) {
+            for (size_t i = worker; i < bricks_.size(); i += workers) {
+                auto& brick = bricks_[i];
+                const size3_t end = glm::min(brick.origin + size3_t(brickSize_), dims - size3_t(1));
+                const size3_t first = glm::max(brick.origin, size3_t(border)) - size3_t(border);
+                const size3_t last = glm::min(end + size3_t(1 + border), dims);
+
+                vec2 range;
+                const bool changed = detail::updateBox(data, dims, first, last, voxels_[i], range);
+                if (!reset && !isosChanged && !changed) continue;
+
+                const bool active = std::any_of(isos.begin(), isos.end(), [&](float iso) {
+                    return range.x < iso && !(range.y < iso);
+                });
+                if (!active) {
+                    replaced[i] = brick.mesh != nullptr;
+                    brick.mesh = nullptr;
+                    continue;
+                }
+
+                std::vector<MeshHelper> layers;
+                for (const auto& color : colors) {
+                    layers.emplace_back(end - brick.origin + size3_t(1), modelMatrix_,
+                                        worldMatrix_, color, Normals::Gradient);
+                }
+                std::vector<detail::BrickMesh> meshes;
+                for (auto& layer : layers) {
+                    meshes.emplace_back(layer, brick.origin);
+                }
+                detail::extractBox(data, dims, isos, brick.origin, end, method, meshes);
+
+                auto mesh = MeshHelper::toBasicMesh(layers);
+                size_t indices = 0;
+                for (size_t b = 0; b < mesh->getNumberOfIndicies(); ++b) {
+                    indices += mesh->getIndices(b)->getSize();
+                }
+                replaced[i] = brick.mesh != nullptr || indices > 0;
+                brick.mesh = indices > 0 ? mesh : nullptr;
+            }
+        });
+    });
+    return static_cast<size_t>(std::count(replaced.begin(), replaced.end(), 1));
+}
+
+size_t MarchingTetrahedra::BrickedMesh::getBrickSize() const { return brickSize_; }
+
+const std::vector<MarchingTetrahedra::BrickedMesh::Brick>&
+MarchingTetrahedra::BrickedMesh::getBricks() const {
+    return bricks_;
+}
+
+std::shared_ptr<std::vector<std::shared_ptr<Mesh>>> MarchingTetrahedra::BrickedMesh::getMeshes()
+    const {
+    auto meshes = std::make_shared<std::vector<std::shared_ptr<Mesh>>>();
+    for (const auto& brick : bricks_) {
+        if (brick.mesh) meshes->push_back(brick.mesh);
+    }
+    return meshes;
+}
+
+/**
+ * Takes the place of a MeshHelper for one layer of a TemporalMesh. Vertices are shared through
+ * the edges of the whole volume. Triangles belong to the cell of the vertices added last, the
+ * extractors add all the vertices of a cell before its triangles.
+ */
+class MarchingTetrahedra::TemporalMesh::CellMesh {
+public:
+    CellMesh(TemporalMesh& mesh, size_t layer) : mesh_(&mesh), layer_(layer), cell_(0) {}
+
+    template <typename Create>
+    std::uint32_t addVertex(const size3_t& cell, size_t edge, Create createVertex) {
+        const size3_t& dims = mesh_->dims_;
+        cell_ = cell.x + dims.x * (cell.y + dims.y * cell.z);
+        const auto key = mesh_->edgeKey(cell, edge, layer_);
+        const auto it = mesh_->edgeVertices_.find(key);
+        if (it != mesh_->edgeVertices_.end()) return it->second;
+
+        const std::pair<vec3, vec3> vertex = createVertex();
+        return mesh_->addVertex(key, layer_, vertex.first,
+                                mesh_->normals_ == Normals::Gradient ? vertex.second : vec3(0.0f));
+    }
+
+    void addTriangle(size_t i0, size_t i1, size_t i2) {
+        mesh_->addTriangle(layer_, cell_, static_cast<std::uint32_t>(i0),
+                           static_cast<std::uint32_t>(i1), static_cast<std::uint32_t>(i2));
+    }
+
+    Normals getNormalMode() const { return mesh_->normals_; }
+
+private:
+    TemporalMesh* mesh_;
+    size_t layer_;
+    size_t cell_;
+};
+
+MarchingTetrahedra::TemporalMesh::TemporalMesh()
+    : dims_(0)
+    , format_(nullptr)
+    , modelMatrix_(1.0f)
+    , worldMatrix_(1.0f)
+    , isos_()
+    , colors_()
+    , normals_(Normals::FaceAccumulated)
+    , method_(Method::Tetrahedra)
+    , voxels_()
+    , dirty_()
+    , positions_()
+    , vertexNormals_()
+    , vertexLayers_()
+    , vertexEdges_()
+    , references_()
+    , freeVertices_()
+    , edgeVertices_()
+    , indices_()
+    , freeTriangles_()
+    , cellTriangles_() {}
+
+size_t MarchingTetrahedra::TemporalMesh::update(std::shared_ptr<const Volume> volume,
+                                                const std::vector<float>& isos,
+                                                const std::vector<vec4>& colors, Normals normals,
+                                                Method method) {
+    ivwAssert(isos.size() == colors.size(), "there should be one color per iso value");
+    const auto ram = volume->getRepresentation<VolumeRAM>();
+    const size3_t dims = ram->getDimensions();
+    const size_t voxelCount = dims.x * dims.y * dims.z;
+
+    // Only changed voxels can be patched, anything else changes every cell. So does a mesh
+    // that has more unused than used vertices left after earlier updates.
+    const bool reset = dims != dims_ || ram->getDataFormat() != format_ ||
+                       volume->getModelMatrix() != modelMatrix_ ||
+                       volume->getWorldMatrix() != worldMatrix_ || isos != isos_ ||
+                       colors != colors_ || normals != normals_ || method != method_ ||
+                       2 * freeVertices_.size() > positions_.size() + 1024;
+    if (reset) {
+        clear();
+        dims_ = dims;
+        format_ = ram->getDataFormat();
+        modelMatrix_ = volume->getModelMatrix();
+        worldMatrix_ = volume->getWorldMatrix();
+        isos_ = isos;
+        colors_ = colors;
+        normals_ = normals;
+        method_ = method;
+        const auto begin = static_cast<const unsigned char*>(ram->getData());
+        voxels_.assign(begin, begin + voxelCount * ram->getDataFormat()->getSize());
+        dirty_.assign(voxelCount, 0);
+        indices_.resize(isos.size());
+        freeTriangles_.resize(isos.size());
+    }
+
+    const size3_t cells = glm::max(dims, size3_t(1)) - size3_t(1);
+    size_t extracted = 0;
+    ram->dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+        using T = util::PrecisionValueType<decltype(vrprecision)>;
+        const T* data = vrprecision->getDataTyped();
+
+        std::vector<CellMesh> meshes;
+        for (size_t layer = 0; layer < isos.size(); ++layer) meshes.emplace_back(*this, layer);
+        detail::CellExtractor<T, CellMesh> extractor(data, dims, isos, meshes, method);
+
+        if (reset) {
+            for (size_t z = 0; z < cells.z; ++z) {
+                for (size_t y = 0; y < cells.y; ++y) {
+                    extractor.extractRun(0, cells.x, y, z);
+                }
+            }
+            extracted = cells.x * cells.y * cells.z;
+            return;
+        }
+
+        // The cells with a changed voxel as a corner, gradient normals also read the voxels
+        // next to the corners of the edges. Only the changed voxels are copied for the next
+        // update.
+        T* previous = reinterpret_cast<T*>(voxels_.data());
+        const size_t reach = normals == Normals::Gradient ? 2 : 1;
+        util::IndexMapper3D index(dims);
+        std::vector<size_t> dirtyCells;
+        for (size_t i = 0; i < voxelCount; ++i) {
+            if (data[i] == previous[i]) continue;
+            previous[i] = data[i];
+            const size3_t voxel = index(i);
+            const size3_t first = glm::max(voxel, size3_t(reach)) - size3_t(reach);
+            const size3_t last = glm::min(voxel + size3_t(reach), cells);
+            size3_t cell;
+            for (cell.z = first.z; cell.z < last.z; ++cell.z) {
+                for (cell.y = first.y; cell.y < last.y; ++cell.y) {
+                    for (cell.x = first.x; cell.x < last.x; ++cell.x) {
+                        const size_t c = index(cell);
+                        if (!dirty_[c]) {
+                            dirty_[c] = 1;
+                            dirtyCells.push_back(c);
+                        }
+                    }
+                }
+            }
+        }
+
+        // All the old triangles have to be gone before extracting, so that no new cell finds a
+        // vertex on an edge that has changed
+        for (auto cell : dirtyCells) {
+            removeCell(cell);
+            dirty_[cell] = 0;
+        }
+        std::sort(dirtyCells.begin(), dirtyCells.end());
+        for (size_t i = 0; i < dirtyCells.size();) {
+            size_t end = i + 1;
+            while (end < dirtyCells.size() && dirtyCells[end] == dirtyCells[end - 1] + 1 &&
+                   dirtyCells[end] % dims.x != 0) {
+                ++end;
+            }
+            const size3_t cell = index(dirtyCells[i]);
+            extractor.extractRun(cell.x, cell.x + (end - i), cell.y, cell.z);
+            i = end;
+        }
+        extracted = dirtyCells.size();
+    });
+    return extracted;
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::TemporalMesh::getMesh() const {
+    auto mesh = std::make_shared<BasicMesh>();
+    mesh->setModelMatrix(modelMatrix_);
+    mesh->setWorldMatrix(worldMatrix_);
+
+    // the vertices in use, numbered in order
+    std::vector<std::uint32_t> remap(positions_.size(), EdgeIndexCache::invalid);
+    std::vector<BasicMesh::Vertex> vertices;
+    vertices.reserve(positions_.size() - freeVertices_.size());
+    for (size_t i = 0; i < positions_.size(); ++i) {
+        if (references_[i] == 0) continue;
+        remap[i] = static_cast<std::uint32_t>(vertices.size());
+        const vec3 normal = normals_ == Normals::FaceAccumulated
+                                ? glm::normalize(vertexNormals_[i])
+                                : vertexNormals_[i];
+        vertices.emplace_back(positions_[i], normal, positions_[i], colors_[vertexLayers_[i]]);
+    }
+    mesh->addVertices(vertices);
+
+    for (const auto& layer : indices_) {
+        auto& indices =
+            mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)->getDataContainer();
+        indices.reserve(layer.size());
+        for (size_t t = 0; t + 2 < layer.size(); t += 3) {
+            if (layer[t] == EdgeIndexCache::invalid) continue;
+            for (size_t j = 0; j < 3; ++j) indices.push_back(remap[layer[t + j]]);
+        }
+    }
+    return mesh;
+}
+
+void MarchingTetrahedra::TemporalMesh::clear() {
+    voxels_.clear();
+    dirty_.clear();
+    positions_.clear();
+    vertexNormals_.clear();
+    vertexLayers_.clear();
+    vertexEdges_.clear();
+    references_.clear();
+    freeVertices_.clear();
+    edgeVertices_.clear();
+    indices_.clear();
+    freeTriangles_.clear();
+    cellTriangles_.clear();
 }
 
+void MarchingTetrahedra::TemporalMesh::removeCell(size_t cell) {
+    const auto it = cellTriangles_.find(cell);
+    if (it == cellTriangles_.end()) return;
+
+    for (const auto& triangle : it->second) {
+        std::uint32_t* indices = &indices_[triangle.first][3 * triangle.second];
+        const vec3 normal =
+            normals_ == Normals::FaceAccumulated ? faceNormal(indices) : vec3(0.0f);
+        for (size_t j = 0; j < 3; ++j) {
+            const auto vertex = indices[j];
+            vertexNormals_[vertex] -= normal;
+            if (--references_[vertex] == 0) {
+                edgeVertices_.erase(vertexEdges_[vertex]);
+                freeVertices_.push_back(vertex);
+            }
+        }
+        indices[0] = EdgeIndexCache::invalid;
+        freeTriangles_[triangle.first].push_back(triangle.second);
+    }
+    cellTriangles_.erase(it);
+}
+
+std::uint64_t MarchingTetrahedra::TemporalMesh::edgeKey(const size3_t& cell, size_t edge,
+                                                        size_t layer) const {
+    const auto key = EdgeIndexCache::key(dims_, cell, edge);
+    const std::uint64_t planeSize = dims_.x * dims_.y * EdgeIndexCache::edgeTypes;
+    return (key.plane * planeSize + key.slot) * isos_.size() + layer;
+}
+
+std::uint32_t MarchingTetrahedra::TemporalMesh::addVertex(std::uint64_t key, size_t layer,
+                                                          vec3 pos, vec3 normal) {
+    std::uint32_t vertex;
+    if (freeVertices_.empty()) {
+        vertex = static_cast<std::uint32_t>(positions_.size());
+        positions_.push_back(pos);
+        vertexNormals_.push_back(normal);
+        vertexLayers_.push_back(static_cast<std::uint32_t>(layer));
+        vertexEdges_.push_back(key);
+        references_.push_back(0);
+    } else {
+        vertex = freeVertices_.back();
+        freeVertices_.pop_back();
+        positions_[vertex] = pos;
+        vertexNormals_[vertex] = normal;
+        vertexLayers_[vertex] = static_cast<std::uint32_t>(layer);
+        vertexEdges_[vertex] = key;
+    }
+    edgeVertices_[key] = vertex;
+    return vertex;
+}
+
+void MarchingTetrahedra::TemporalMesh::addTriangle(size_t layer, size_t cell, std::uint32_t i0,
+                                                   std::uint32_t i1, std::uint32_t i2) {
+    auto& indices = indices_[layer];
+    auto& free = freeTriangles_[layer];
+    std::uint32_t slot;
+    if (free.empty()) {
+        slot = static_cast<std::uint32_t>(indices.size() / 3);
+        indices.resize(indices.size() + 3);
+    } else {
+        slot = free.back();
+        free.pop_back();
+    }
+    std::uint32_t* triangle = &indices[3 * slot];
+    triangle[0] = i0;
+    triangle[1] = i1;
+    triangle[2] = i2;
+
+    const vec3 normal = normals_ == Normals::FaceAccumulated ? faceNormal(triangle) : vec3(0.0f);
+    for (size_t j = 0; j < 3; ++j) {
+        vertexNormals_[triangle[j]] += normal;
+        ++references_[triangle[j]];
+    }
+    cellTriangles_[cell].emplace_back(static_cast<std::uint32_t>(layer), slot);
+}
+
+vec3 MarchingTetrahedra::TemporalMesh::faceNormal(const std::uint32_t* triangle) const {
+    const vec3& a = positions_[triangle[0]];
+    const vec3& b = positions_[triangle[1]];
+    const vec3& c = positions_[triangle[2]];
+    return glm::normalize(glm::cross(b - a, c - a));
+}
+
+void MarchingTetrahedra::extractSlab(const VolumeRAM& volume, const std::vector<float>& isos,
+                                     size_t zBegin, size_t zEnd, std::vector<MeshHelper>& meshes,
+                                     const MinMaxBricks* bricks, Method method,
+                                     Traversal traversal) {
+    volume.dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+        detail::extractSlab(vrprecision->getDataTyped(), vrprecision->getDimensions(), isos,
+                            zBegin, zEnd, bricks, method, traversal, nullptr, meshes);
+    });
+}
+
+void MarchingTetrahedra::extractCells(const VolumeRAM& volume, const std::vector<float>& isos,
+                                      const std::uint32_t* begin, const std::uint32_t* end,
+                                      std::vector<MeshHelper>& meshes, Method method) {
+    volume.dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+        detail::extractCells(vrprecision->getDataTyped(), vrprecision->getDimensions(), isos,
+                             begin, end, method, meshes);
+    });
+}
+
+MarchingTetrahedra::MeshHelper::MeshHelper(std::shared_ptr<const Volume> vol, vec4 color,
+                                           Normals normals)
+    : MeshHelper(vol->getDimensions(), vol->getModelMatrix(), vol->getWorldMatrix(), color,
+                 normals) {}
+
+MarchingTetrahedra::MeshHelper::MeshHelper(size3_t dims, const mat4& modelMatrix,
+                                           const mat4& worldMatrix, vec4 color, Normals normals)
+    : edgeCache_(dims)
+    , firstPlane_(std::numeric_limits<size_t>::max())
+    , seam_()
+    , edgeToVertex_(0, HashFunc(dims.x * dims.y * dims.z))
+    , vertices_()
+    , indices_()
+    , modelMatrix_(modelMatrix)
+    , worldMatrix_(worldMatrix)
+    , color_(color)
+    , normals_(normals) {}
+
 void MarchingTetrahedra::MeshHelper::addTriangle(size_t i0, size_t i1, size_t i2) {
     ivwAssert(i0 != i1, "i0 and i1 should not be the same value");
     ivwAssert(i0 != i2, "i0 and i2 should not be the same value");
     ivwAssert(i1 != i2, "i1 and i2 should not be the same value");
 
-    indexBuffer_->add(static_cast<glm::uint32_t>(i0));
-    indexBuffer_->add(static_cast<glm::uint32_t>(i1));
-    indexBuffer_->add(static_cast<glm::uint32_t>(i2));
+    indices_.push_back(static_cast<glm::uint32_t>(i0));
+    indices_.push_back(static_cast<glm::uint32_t>(i1));
+    indices_.push_back(static_cast<glm::uint32_t>(i2));
+}
+
+void MarchingTetrahedra::MeshHelper::append(MeshHelper&& slab) {
+    const auto unmapped = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> remap(slab.vertices_.size(), unmapped);
+
+    // Only edges on the z-plane shared with the previous slab can be found here
+    for (const auto& seam : slab.seam_) {
+        const auto index = edgeCache_.find(seam.first);
+        if (index != EdgeIndexCache::invalid) {
+            remap[seam.second] = index;
+        }
+    }
+    for (const auto& edge : slab.edgeToVertex_) {
+        auto it = edgeToVertex_.find(edge.first);
+        if (it != edgeToVertex_.end()) {
+            remap[edge.second] = static_cast<std::uint32_t>(it->second);
+        }
+    }
+    for (size_t i = 0; i < slab.vertices_.size(); ++i) {
+        if (remap[i] == unmapped) {
+            remap[i] = static_cast<std::uint32_t>(vertices_.size());
+            vertices_.push_back(slab.vertices_[i]);
+        }
+    }
 
-    auto a = std::get<0>(vertices_[i0]);
-    auto b = std::get<0>(vertices_[i1]);
-    auto c = std::get<0>(vertices_[i2]);
+    slab.edgeCache_.remap(remap);
+    edgeCache_ = std::move(slab.edgeCache_);
+    for (const auto& edge : slab.edgeToVertex_) {
+        edgeToVertex_.emplace(edge.first, remap[edge.second]);
+    }
 
-    vec3 n = glm::normalize(glm::cross(b - a, c - a));
-    std::get<1>(vertices_[i0]) += n;
-    std::get<1>(vertices_[i1]) += n;
-    std::get<1>(vertices_[i2]) += n;
+    indices_.reserve(indices_.size() + slab.indices_.size());
+    for (auto i : slab.indices_) {
+        indices_.push_back(remap[i]);
+    }
 }
 
-std::shared_ptr<BasicMesh> MarchingTetrahedra::MeshHelper::toBasicMesh() {
+void MarchingTetrahedra::MeshHelper::computeNormals() {
+    if (normals_ == Normals::Gradient) return;
+
+    for (size_t t = 0; t + 2 < indices_.size(); t += 3) {
+        auto a = std::get<0>(vertices_[indices_[t]]);
+        auto b = std::get<0>(vertices_[indices_[t + 1]]);
+        auto c = std::get<0>(vertices_[indices_[t + 2]]);
+
+        vec3 n = glm::normalize(glm::cross(b - a, c - a));
+        std::get<1>(vertices_[indices_[t]]) += n;
+        std::get<1>(vertices_[indices_[t + 1]]) += n;
+        std::get<1>(vertices_[indices_[t + 2]]) += n;
+    }
     for (auto& vertex : vertices_) {
         auto& normal = std::get<1>(vertex);
         normal = glm::normalize(normal);
     }
-    mesh_->addVertices(vertices_);
-    return mesh_;
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::MeshHelper::toBasicMesh(ExtractionStats* stats) {
+    {
+        ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::NormalFinalize);
+        computeNormals();
+    }
+
+    ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::MeshCopy);
+    auto mesh = std::make_shared<BasicMesh>();
+    mesh->setModelMatrix(modelMatrix_);
+    mesh->setWorldMatrix(worldMatrix_);
+    mesh->addVertices(vertices_);
+    mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)->getDataContainer() =
+        std::move(indices_);
+    return mesh;
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::MeshHelper::toBasicMesh(
+    std::vector<MeshHelper>& layers, ExtractionStats* stats) {
+    if (layers.size() == 1) return layers.front().toBasicMesh(stats);
+
+    {
+        ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::NormalFinalize);
+        for (auto& layer : layers) {
+            layer.computeNormals();
+        }
+    }
+
+    ExtractionStats::ScopedTimer timer(stats, ExtractionStats::Phase::MeshCopy);
+    auto mesh = std::make_shared<BasicMesh>();
+    if (!layers.empty()) {
+        mesh->setModelMatrix(layers.front().modelMatrix_);
+        mesh->setWorldMatrix(layers.front().worldMatrix_);
+    }
+
+    std::vector<BasicMesh::Vertex> vertices;
+    for (auto& layer : layers) {
+        const auto offset = static_cast<std::uint32_t>(vertices.size());
+        vertices.insert(vertices.end(), layer.vertices_.begin(), layer.vertices_.end());
+        for (auto& i : layer.indices_) {
+            i += offset;
+        }
+        mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)->getDataContainer() =
+            std::move(layer.indices_);
+    }
+    mesh->addVertices(vertices);
+    return mesh;
 }
 
 std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(vec3 pos, size_t i, size_t j) {
@@ -373,12 +2876,47 @@ std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(vec3 pos, size_t i, size
     auto it = edgeToVertex_.find(edge);
 
     if (it == edgeToVertex_.end()) {
+        // the edge cache only knows the last two planes, the map keeps the edge for good
+        EdgeIndexCache::Key key;
+        if (edgeCache_.key(i, j, key)) {
+            const auto index =
+                addVertex(key, [&]() { return std::make_pair(pos, vec3(0.0f)); });
+            edgeToVertex_[edge] = index;
+            return index;
+        }
         edgeToVertex_[edge] = vertices_.size();
-        vertices_.push_back({pos, vec3(0, 0, 0), pos, vec4(0.7f, 0.7f, 0.7f, 1.0f)});
+        vertices_.push_back({pos, vec3(0, 0, 0), pos, color_});
         return static_cast<std::uint32_t>(vertices_.size() - 1);
     }
 
     return static_cast<std::uint32_t>(it->second);
 }
 
+std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(vec3 pos, vec3 normal) {
+    vertices_.push_back(
+        {pos, normals_ == Normals::Gradient ? normal : vec3(0.0f), pos, color_});
+    return static_cast<std::uint32_t>(vertices_.size() - 1);
+}
+
+std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(vec3 pos, const size3_t& cell,
+                                                        size_t edge) {
+    return addVertex(edgeCache_.key(cell, edge),
+                     [&]() { return std::make_pair(pos, vec3(0.0f)); });
+}
+
+size_t MarchingTetrahedra::MeshHelper::getSizeInBytes() const {
+    // each node of the map holds its entry and the pointer to the next one
+    return edgeCache_.getSizeInBytes() +
+           seam_.capacity() * sizeof(std::pair<EdgeIndexCache::Key, std::uint32_t>) +
+           edgeToVertex_.size() * (sizeof(std::pair<const std::pair<size_t, size_t>, size_t>) +
+                                   sizeof(void*)) +
+           edgeToVertex_.bucket_count() * sizeof(void*) +
+           vertices_.capacity() * sizeof(BasicMesh::Vertex) +
+           indices_.capacity() * sizeof(std::uint32_t);
+}
+
+MarchingTetrahedra::Normals MarchingTetrahedra::MeshHelper::getNormalMode() const {
+    return normals_;
+}
+
 }  // namespace inviwo
@@ -38,14 +38,39 @@
 #include <inviwo/core/ports/volumeport.h>
 #include <inviwo/core/ports/meshport.h>
 #include <inviwo/core/datastructures/geometry/basicmesh.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/boolcompositeproperty.h>
+#include <inviwo/core/properties/fileproperty.h>
+#include <inviwo/core/properties/minmaxproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/stringproperty.h>
+#include <modules/tnm067lab2/utils/edgeindexcache.h>
+#include <modules/tnm067lab2/utils/extractionstats.h>
+#include <modules/tnm067lab2/utils/marchingcubescases.h>
+#include <modules/tnm067lab2/utils/meshcacheproperty.h>
+#include <modules/tnm067lab2/utils/minmaxbricks.h>
+#include <modules/tnm067lab2/utils/spanspaceindex.h>
+#include <modules/tnm067lab2/utils/sparsevolume.h>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <unordered_map>
 
 namespace inviwo {
 
 class IVW_MODULE_TNM067LAB2_API MarchingTetrahedra : public Processor { 
 public:
+    /**
+     * Hashes an edge given by the voxel-indices of its two voxels. max is the number of voxels
+     * of the volume the edges belong to, each map of edges has a HashFunc of its own so
+     * extractions of different volumes can run at the same time.
+     */
     struct  HashFunc
     {
-        static size_t max;
+        explicit HashFunc(size_t max = 1) : max(max) {}
+
+        size_t max;
         size_t operator()(std::pair<size_t,size_t> p) const{
             size_t asdf;
             asdf = p.first;
@@ -58,59 +83,582 @@ public:
     struct Voxel {
         vec3 pos;
         float value;
-        size_t index;
     };
 
     struct Cell {
         Voxel voxels[8];
     };
 
-    struct Tetrahedra {
-        Voxel voxels[4];
-    };
+    /**
+     * How the cells are triangulated. Tetrahedra splits each cell into six tetrahedra, Cubes
+     * uses the marching cubes cases of MarchingCubesCases, which gives about half as many
+     * triangles and no vertices on the diagonals of the cells.
+     */
+    enum class Method { Tetrahedra, Cubes };
+
+    /**
+     * How the vertex normals are computed. FaceAccumulated sums up the normals of the
+     * triangles around each vertex, Gradient interpolates the central difference gradients of
+     * the volume along the edge of the vertex when it is created.
+     */
+    enum class Normals { FaceAccumulated, Gradient };
+
+    /**
+     * How the output buffers are allocated. Incremental grows them while extracting and copies
+     * the slabs together. CountThenFill first counts the triangles and vertices of each slab,
+     * allocates the mesh buffers once at their final size and then fills them in parallel at
+     * the offsets given by the prefix sums of the counts. Both give the same mesh. Shared has
+     * all threads add to one mesh per iso value, taking the z-planes one at a time, and welds
+     * the vertices through a ConcurrentEdgeMap. It gives the same triangles and normals, with the
+     * vertices numbered in the order the triangles first use them.
+     */
+    enum class Allocation { Incremental, CountThenFill, Shared };
+
+    /**
+     * The order the cells of each z-plane are visited in. Linear goes row by row along x.
+     * Morton visits tiles of MinMaxBricks::brickSize^2 cells in Z-order, row by row within
+     * each tile, so the voxels of neighbouring cells are still cached when they are read again
+     * for wide volumes. The mesh has the same triangles in another order.
+     */
+    enum class Traversal { Linear, Morton };
 
+    /**
+     * The cells [begin, end), by their first voxel, that extraction is restricted to. The
+     * vertex positions stay relative to the whole volume.
+     */
+    struct CellBox {
+        size3_t begin;
+        size3_t end;
+    };
 
     struct MeshHelper {
 
-        MeshHelper(std::shared_ptr<const Volume> vol);
+        MeshHelper(std::shared_ptr<const Volume> vol,
+                   vec4 color = vec4(0.7f, 0.7f, 0.7f, 1.0f),
+                   Normals normals = Normals::FaceAccumulated);
+        MeshHelper(size3_t dims, const mat4& modelMatrix, const mat4& worldMatrix,
+                   vec4 color = vec4(0.7f, 0.7f, 0.7f, 1.0f),
+                   Normals normals = Normals::FaceAccumulated);
 
         /**
          * Adds a vertex to the mesh. The input parameters i and j are the voxel-indices of the two
          * voxels spanning the edge on which the vertex lies. The vertex will only be added created
          * if a vertex between the same indices has not been added before. Will return the index of
          * the created vertex or the vertex that was created for this edge before. The voxel-index i
-         * and j can be given in any order. 
+         * and j can be given in any order. The edges can be visited in any order as well, unlike
+         * with the overloads below, at the cost of remembering each of them in a hash map.
          *
          * @param pos spatial position of the vertex
          * @param i voxel index of first voxel of the edge
          * @param j voxel index of second voxel of the edge
          */
         std::uint32_t addVertex(vec3 pos, size_t i, size_t j);
+
+        /**
+         * Same as above for the edge (see EdgeIndexCache::cellEdges) of the cell with its first
+         * corner at cell, without having to work out which of the cached edges i and j span.
+         * Cells have to be visited with z increasing for vertices to be shared between them.
+         */
+        std::uint32_t addVertex(vec3 pos, const size3_t& cell, size_t edge);
+
+        /**
+         * Same as above, but the vertex is only computed if the edge does not have one yet.
+         * createVertex() returns the position and the normal of the vertex, the normal is only
+         * used with Normals::Gradient.
+         */
+        template <typename Create>
+        std::uint32_t addVertex(const size3_t& cell, size_t edge, Create createVertex);
+
+        /**
+         * Adds a vertex that is not on any edge, such as one inside of a cell, and is not shared
+         * through addVertex. The normal is only used with Normals::Gradient.
+         */
+        std::uint32_t addVertex(vec3 pos, vec3 normal);
+
         void addTriangle(size_t i0, size_t i1, size_t i2);
-        std::shared_ptr<BasicMesh> toBasicMesh();
+
+        Normals getNormalMode() const;
+
+        /**
+         * Memory allocated by the helper for its vertices, triangles and edges.
+         */
+        size_t getSizeInBytes() const;
+
+        /**
+         * Appends the vertices and triangles of a helper that extracted the z-slab directly
+         * following the last one added to this helper. Vertices on edges shared by the two slabs
+         * are welded to the existing ones, so the result is identical to extracting both slabs
+         * with a single helper. Afterwards only the edges of the appended slab are known to the
+         * cell overloads of addVertex, the ones added by voxel index are all kept.
+         */
+        void append(MeshHelper&& slab);
+
+        /**
+         * Creates the mesh. With Normals::FaceAccumulated the vertex normals are accumulated from
+         * the face normals in triangle order, which keeps them independent of how the extraction
+         * was split up. The time of the normals and of building the mesh is added to stats if
+         * given.
+         */
+        std::shared_ptr<BasicMesh> toBasicMesh(ExtractionStats* stats = nullptr);
+
+        /**
+         * Creates a single mesh out of several helpers of the same volume, with one index buffer
+         * per helper.
+         */
+        static std::shared_ptr<BasicMesh> toBasicMesh(std::vector<MeshHelper>& layers,
+                                                      ExtractionStats* stats = nullptr);
 
     private:
+        template <typename Create>
+        std::uint32_t addVertex(const EdgeIndexCache::Key& key, Create createVertex);
+        void computeNormals();
+
+        EdgeIndexCache edgeCache_;
+        size_t firstPlane_;
+        // vertices on the first plane touched, welded to the previous slab in append
+        std::vector<std::pair<EdgeIndexCache::Key, std::uint32_t>> seam_;
+        // edges added by voxel index, kept for the whole mesh
         std::unordered_map<std::pair<size_t, size_t>, size_t , HashFunc > edgeToVertex_;
         std::vector<BasicMesh::Vertex> vertices_;
-        std::shared_ptr<BasicMesh> mesh_;
-        IndexBufferRAM* indexBuffer_;
+        std::vector<std::uint32_t> indices_;
+        mat4 modelMatrix_;
+        mat4 worldMatrix_;
+        vec4 color_;
+        Normals normals_;
     };
 
 
+    /**
+     * The iso-surfaces split into one mesh per brick of brickSize^3 cells, so renderers can cull
+     * the bricks and only upload the ones that changed. Each update only extracts the bricks
+     * whose voxels changed, found by comparing them with a copy kept of the voxels each brick
+     * reads, or that the old or new iso-surfaces pass through. Vertices on the faces between
+     * bricks are in the meshes of both. Only gradient normals are supported, they are the same
+     * in both meshes; face accumulated normals would only see the triangles of one brick.
+     */
+    class IVW_MODULE_TNM067LAB2_API BrickedMesh {
+    public:
+        struct Brick {
+            size3_t origin;  // first cell of the brick
+            vec3 lower;      // bounding box of the cells, in the space of the vertices
+            vec3 upper;
+            std::shared_ptr<BasicMesh> mesh;  // null if the brick has no triangles
+        };
+
+        explicit BrickedMesh(size_t brickSize = 32);
+
+        /**
+         * Brings the bricks up to date with the volume and iso values. The meshes are laid out
+         * as in extract. Returns the number of bricks whose mesh was replaced.
+         */
+        size_t update(std::shared_ptr<const Volume> volume, const std::vector<float>& isos,
+                      const std::vector<vec4>& colors, size_t threads = 1,
+                      Method method = Method::Tetrahedra);
+
+        size_t getBrickSize() const;
+        const std::vector<Brick>& getBricks() const;
+
+        /**
+         * The meshes of the bricks that have any triangles.
+         */
+        std::shared_ptr<std::vector<std::shared_ptr<Mesh>>> getMeshes() const;
+
+    private:
+        size_t brickSize_;
+        size3_t dims_;
+        const DataFormatBase* format_;
+        mat4 modelMatrix_;
+        mat4 worldMatrix_;
+        std::vector<float> isos_;
+        std::vector<vec4> colors_;
+        Method method_;
+        std::vector<Brick> bricks_;
+        std::vector<std::vector<unsigned char>> voxels_;  // copies of those each brick reads
+    };
+
+    /**
+     * The iso-surfaces of a volume that changes a little at a time, such as the frames of a
+     * simulation. Each update compares the voxels with the previous volume and only extracts the
+     * cells again that have a changed voxel as a corner, or next to one with gradient normals,
+     * replacing their triangles in place. Any other change extracts all cells again.
+     */
+    class IVW_MODULE_TNM067LAB2_API TemporalMesh {
+    public:
+        TemporalMesh();
+
+        /**
+         * Brings the mesh up to date with the volume and iso values. Returns the number of
+         * cells that were extracted again.
+         */
+        size_t update(std::shared_ptr<const Volume> volume, const std::vector<float>& isos,
+                      const std::vector<vec4>& colors, Normals normals = Normals::FaceAccumulated,
+                      Method method = Method::Tetrahedra);
+
+        /**
+         * The current mesh, laid out as in extract but with the vertices and triangles in no
+         * particular order.
+         */
+        std::shared_ptr<BasicMesh> getMesh() const;
+
+    private:
+        class CellMesh;
+
+        void clear();
+        void removeCell(size_t cell);
+        std::uint64_t edgeKey(const size3_t& cell, size_t edge, size_t layer) const;
+        std::uint32_t addVertex(std::uint64_t key, size_t layer, vec3 pos, vec3 normal);
+        void addTriangle(size_t layer, size_t cell, std::uint32_t i0, std::uint32_t i1,
+                         std::uint32_t i2);
+        vec3 faceNormal(const std::uint32_t* triangle) const;
+
+        size3_t dims_;
+        const DataFormatBase* format_;
+        mat4 modelMatrix_;
+        mat4 worldMatrix_;
+        std::vector<float> isos_;
+        std::vector<vec4> colors_;
+        Normals normals_;
+        Method method_;
+        std::vector<unsigned char> voxels_;  // of the previous volume
+        std::vector<char> dirty_;            // marks of the cells to extract, by first voxel
+
+        // vertices of all layers, their slots are reused once no triangle refers to them
+        std::vector<vec3> positions_;
+        std::vector<vec3> vertexNormals_;  // summed face normals with Normals::FaceAccumulated
+        std::vector<std::uint32_t> vertexLayers_;
+        std::vector<std::uint64_t> vertexEdges_;
+        std::vector<std::uint32_t> references_;
+        std::vector<std::uint32_t> freeVertices_;
+        std::unordered_map<std::uint64_t, std::uint32_t> edgeVertices_;
+
+        // triangles of each layer, free slots start with EdgeIndexCache::invalid
+        std::vector<std::vector<std::uint32_t>> indices_;
+        std::vector<std::vector<std::uint32_t>> freeTriangles_;
+        // the triangles of each cell with any, as layer and slot, by the index of its first voxel
+        std::unordered_map<size_t, std::vector<std::pair<std::uint32_t, std::uint32_t>>>
+            cellTriangles_;
+    };
+
     MarchingTetrahedra();
-    virtual ~MarchingTetrahedra() = default;
+    virtual ~MarchingTetrahedra();
      
     virtual void process() override;
 
+    /**
+     * Cancels the refinement of a preview on any change but the refinement being done.
+     */
+    virtual void invalidate(InvalidationLevel invalidationLevel,
+                            Property* modifiedProperty = nullptr) override;
+
     virtual const ProcessorInfo getProcessorInfo() const override;
     static const ProcessorInfo processorInfo_;
+
+    /**
+     * Extracts the iso-surface of the volume. The cells are split into one z-slab per thread,
+     * each slab is extracted into a MeshHelper of its own and the slabs are then stitched
+     * together in order. The resulting mesh does not depend on the number of threads.
+     * If bricks are given, bricks that are not active for iso are skipped.
+     */
+    static std::shared_ptr<BasicMesh> extract(std::shared_ptr<const Volume> volume, float iso,
+                                              size_t threads = 1,
+                                              const MinMaxBricks* bricks = nullptr);
+
+    /**
+     * Same as above, but only visits the cells the index reports as intersected by iso. The
+     * index has to be built for the same volume. The resulting mesh is the same.
+     */
+    static std::shared_ptr<BasicMesh> extract(std::shared_ptr<const Volume> volume, float iso,
+                                              const SpanSpaceIndex& index, size_t threads = 1);
+
+    /**
+     * Extracts the iso-surfaces of several iso values in a single pass. Every cell is read once
+     * and only tested against the iso values within its range. The mesh gets one index buffer
+     * per iso value, and the vertices of each surface get the corresponding color. If cancel
+     * is given, the planes of cells are extracted one at a time and null is returned as soon
+     * as it is set. If stats is given, the time of each phase and the counters of the extraction
+     * are added to it; the counting pass of Allocation::CountThenFill is left out. Of volumes
+     * with several channels the first one is extracted.
+     */
+    static std::shared_ptr<BasicMesh> extract(std::shared_ptr<const Volume> volume,
+                                              const std::vector<float>& isos,
+                                              const std::vector<vec4>& colors, size_t threads = 1,
+                                              const MinMaxBricks* bricks = nullptr,
+                                              Normals normals = Normals::FaceAccumulated,
+                                              Allocation allocation = Allocation::Incremental,
+                                              Method method = Method::Tetrahedra,
+                                              Traversal traversal = Traversal::Linear,
+                                              const CellBox* roi = nullptr,
+                                              const std::atomic<bool>* cancel = nullptr,
+                                              ExtractionStats* stats = nullptr);
+
+    /**
+     * Same as above, visiting the cells the index reports for any of the iso values. With
+     * Traversal::Morton the cells of each plane are visited tile by tile as in extractSlab.
+     */
+    static std::shared_ptr<BasicMesh> extract(std::shared_ptr<const Volume> volume,
+                                              const std::vector<float>& isos,
+                                              const std::vector<vec4>& colors,
+                                              const SpanSpaceIndex& index, size_t threads = 1,
+                                              Normals normals = Normals::FaceAccumulated,
+                                              Allocation allocation = Allocation::Incremental,
+                                              Method method = Method::Tetrahedra,
+                                              Traversal traversal = Traversal::Linear,
+                                              const CellBox* roi = nullptr,
+                                              const std::atomic<bool>* cancel = nullptr,
+                                              ExtractionStats* stats = nullptr);
+
+    /**
+     * Every stride-th voxel of the volume along each axis, always including the first. The
+     * model matrix is scaled so that the voxels stay where they are in the volume, and the
+     * iso-surfaces of the result are a coarse preview of those of the volume.
+     */
+    static std::shared_ptr<Volume> subsample(const Volume& volume, size_t stride);
+
+    /**
+     * The first channel of a volume with several, as a scalar volume with the same matrices and
+     * data map. The extraction reads that channel of multi-channel volumes.
+     */
+    static std::shared_ptr<Volume> firstChannel(const Volume& volume);
+
+    /**
+     * Extracts the iso-surfaces of a raw volume file without loading the volume. The file is
+     * memory mapped two z-slices at a time, four with gradient normals, so apart from the mesh
+     * only those slices are resident. The voxels are read in native byte order starting at
+     * byteOffset, which has to be a multiple of the voxel size. The mesh is laid out as in
+     * extract. It is always built incrementally, counting first would read the file twice.
+     */
+    static std::shared_ptr<BasicMesh> extractRaw(const std::string& file, size3_t dims,
+                                                 DataFormatId format, size_t byteOffset,
+                                                 const std::vector<float>& isos,
+                                                 const std::vector<vec4>& colors,
+                                                 const mat4& modelMatrix = mat4(1.0f),
+                                                 const mat4& worldMatrix = mat4(1.0f),
+                                                 Normals normals = Normals::FaceAccumulated,
+                                                 Method method = Method::Tetrahedra);
+
+    /**
+     * Extracts the iso-surfaces of a sparse volume, only visiting the blocks of cells that have
+     * a corner in an allocated block. The cells of the other blocks have the background value at
+     * all corners, so the result is the same as for the dense volume. The threads take the
+     * blocks one at a time and share the vertices as with Allocation::Shared. The phases and
+     * counters are added to stats if given, as in extract.
+     */
+    static std::shared_ptr<BasicMesh> extractSparse(const SparseVolume& volume,
+                                                    const std::vector<float>& isos,
+                                                    const std::vector<vec4>& colors,
+                                                    size_t threads = 1,
+                                                    Normals normals = Normals::FaceAccumulated,
+                                                    Method method = Method::Tetrahedra,
+                                                    ExtractionStats* stats = nullptr);
+
+    /**
+     * Extracts the iso-surfaces at adaptive resolution, by dual contouring on an IsoOctree per
+     * iso value built with the given tolerance, in units of the volume values. Regions where
+     * the volume is close to trilinear give large leaves and few triangles, and the mesh has no
+     * cracks where the resolution changes. A tolerance of 0 only merges cells that are exactly
+     * trilinear. The iso values are extracted in parallel, the mesh is laid out as in extract.
+     */
+    static std::shared_ptr<BasicMesh> extractAdaptive(std::shared_ptr<const Volume> volume,
+                                                      const std::vector<float>& isos,
+                                                      const std::vector<vec4>& colors,
+                                                      float tolerance,
+                                                      const MinMaxBricks* bricks = nullptr,
+                                                      Normals normals = Normals::FaceAccumulated);
+
+    /**
+     * Extracts the iso-surface of each iso value for all cells with z in [zBegin, zEnd) into the
+     * mesh with the same index.
+     */
+    static void extractSlab(const VolumeRAM& volume, const std::vector<float>& isos,
+                            size_t zBegin, size_t zEnd, std::vector<MeshHelper>& meshes,
+                            const MinMaxBricks* bricks = nullptr,
+                            Method method = Method::Tetrahedra,
+                            Traversal traversal = Traversal::Linear);
+
+    /**
+     * Extracts the iso-surface of each iso value for the cells in [begin, end), given as the
+     * 1D-index of their first voxel in increasing order, into the mesh with the same index.
+     */
+    static void extractCells(const VolumeRAM& volume, const std::vector<float>& isos,
+                             const std::uint32_t* begin, const std::uint32_t* end,
+                             std::vector<MeshHelper>& meshes, Method method = Method::Tetrahedra);
+
 private:
+    /**
+     * Sets the range of isoValue_, keeping its relative position.
+     */
+    void setIsoValueRange(vec2 range);
+
+    /**
+     * Key of the mesh in the disk cache, a hash of the voxels and everything else that affects
+     * the extracted surface. The voxels are only hashed once per input volume.
+     */
+    std::uint64_t getCacheKey(const Volume& volume, const std::vector<float>& isos,
+                              const std::vector<vec4>& colors);
+
+    /**
+     * The cells of a volume with dims voxels within the clip box, which is in [0, 1].
+     */
+    CellBox getClipBox(size3_t dims) const;
+
+    /**
+     * Whether the clip box is applied, which it is not to the adaptive, bricked and temporal
+     * extractions as they always cover the whole volume.
+     */
+    bool isClipped() const;
+
+    /**
+     * Shows the stats of the last extraction in the instrumentation properties, and writes them
+     * to the JSON file if one is set. Null if the extraction was not instrumented, which hides
+     * the stats of the one before instead.
+     */
+    void setExtractionStats(const ExtractionStats* stats);
+
+    /**
+     * Updates the bricks of brickedMesh_ and outputs them, the single mesh is left empty
+     * rather than joining the bricks again.
+     */
+    void processBricked(std::shared_ptr<const Volume> volume, const std::vector<float>& isos,
+                        const std::vector<vec4>& colors);
+
+    /**
+     * The full resolution extraction of the volume, using the span space index, empty brick
+     * skipping, clip box and traversal as set. With a progressive preview it returns the mesh
+     * of a subsampled volume, sets preview and starts the full extraction in the background.
+     */
+    std::shared_ptr<BasicMesh> extractDense(std::shared_ptr<const Volume> volume,
+                                            const std::vector<float>& isos,
+                                            const std::vector<vec4>& colors,
+                                            ExtractionStats* stats, bool& preview);
+
+    /**
+     * Splits the cells, or the z-range of roi if given, into one z-slab per thread and calls
+     * extractRange(zBegin, zEnd, meshes, stats) for each of them with one mesh per color. With
+     * Allocation::Incremental the meshes are MeshHelpers that are stitched together in order
+     * afterwards. With CountThenFill extractRange is called twice per slab, first with meshes
+     * that only count and then with meshes that write straight into the buffers of the result.
+     * Returns null if cancel is set before it is done. stats is passed on to extractRange except
+     * in the counting pass, which would count every vertex lookup as a hit.
+     */
+    template <typename ExtractRange>
+    static std::shared_ptr<BasicMesh> extractSlabs(std::shared_ptr<const Volume> volume,
+                                                   const std::vector<vec4>& colors,
+                                                   Normals normals, Allocation allocation,
+                                                   size_t threads, const CellBox* roi,
+                                                   const std::atomic<bool>* cancel,
+                                                   ExtractionStats* stats,
+                                                   ExtractRange extractRange);
+
     VolumeInport volume_;
+    DataInport<SparseVolume> sparseVolume_;
     MeshOutport mesh_;
+    DataOutport<std::vector<std::shared_ptr<Mesh>>> brickMeshes_;
 
     FloatProperty isoValue_;
+    BoolProperty multipleIsoValues_;
+    StringProperty isoValues_;
+    TemplateOptionProperty<Method> method_;
+    TemplateOptionProperty<Normals> normals_;
+    TemplateOptionProperty<Allocation> allocation_;
+    TemplateOptionProperty<Traversal> traversal_;
+    IntSizeTProperty threads_;
+
+    BoolCompositeProperty streamRawFile_;
+    FileProperty rawFile_;
+    IntSize3Property rawDimensions_;
+    TemplateOptionProperty<DataFormatId> rawFormat_;
+    IntSizeTProperty rawHeaderSize_;
+
+    BoolCompositeProperty adaptive_;
+    FloatProperty tolerance_;  // relative to the value range of the volume
+
+    BoolCompositeProperty bricked_;
+    IntSizeTProperty brickSize_;
+    IntSizeTProperty updatedBricks_;
+
+    BoolCompositeProperty temporal_;
+    IntSizeTProperty extractedCells_;
+
+    MeshCacheProperty diskCache_;
+
+    BoolCompositeProperty clip_;
+    FloatMinMaxProperty clipX_;
+    FloatMinMaxProperty clipY_;
+    FloatMinMaxProperty clipZ_;
+
+    BoolCompositeProperty progressive_;
+    TemplateOptionProperty<size_t> previewStride_;
+    BoolProperty refining_;
+
+    // of the extraction in process, the preview with progressive_
+    BoolCompositeProperty instrumentation_;
+    StringProperty statsStatus_;
+    FloatProperty cellSetupTime_;  // in ms, summed over the threads as all of the times
+    FloatProperty classificationTime_;
+    FloatProperty interpolationTime_;
+    FloatProperty vertexDedupTime_;
+    FloatProperty normalFinalizeTime_;
+    FloatProperty meshCopyTime_;
+    IntSizeTProperty cellsVisited_;
+    IntSizeTProperty activeCells_;
+    FloatProperty dedupHitRate_;
+    IntSizeTProperty peakEdgeMapSize_;
+    IntSizeTProperty bytesAllocated_;  // at the capacity of the containers, summed over threads
+    FileProperty statsFile_;
+
+    BoolProperty spanSpaceIndex_;
+    IntSizeTProperty indexMemoryLimit_;  // in MB
+    BoolProperty skipEmptyBricks_;
+    FloatProperty skippedBricks_;
+    IntSizeTProperty triangleCount_;
+    IntSizeTProperty vertexCount_;
+
+    // acceleration structures for the current input volume, built on first use, shared with a
+    // running refinement
+    std::shared_ptr<SpanSpaceIndex> index_;
+    std::shared_ptr<MinMaxBricks> bricks_;
+    // what is extracted of a multi-channel input volume
+    std::shared_ptr<const Volume> firstChannel_;
+    // of the voxels of the input volume for the cache key, 0 until computed
+    std::uint64_t volumeHash_ = 0;
+    // the index only pays off once the iso value changes, so it is not built on the first pass
+    bool volumeExtracted_ = false;
+    // kept across input volumes, to only extract the bricks that changed
+    std::unique_ptr<BrickedMesh> brickedMesh_;
+    // kept across input volumes, to only extract the cells that changed
+    std::unique_ptr<TemporalMesh> temporalMesh_;
+
+    // the full resolution extraction after a preview, set to cancel it
+    std::shared_ptr<std::atomic<bool>> cancelRefinement_;
+    std::future<void> refinement_;
+    std::shared_ptr<BasicMesh> refinedMesh_;  // done, waiting for the next process
+    bool deliveringRefinement_;
 };
 
+template <typename Create>
+std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(const size3_t& cell, size_t edge,
+                                                        Create createVertex) {
+    return addVertex(edgeCache_.key(cell, edge), createVertex);
+}
+
+template <typename Create>
+std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(const EdgeIndexCache::Key& key,
+                                                        Create createVertex) {
+    auto& index = edgeCache_[key];
+    if (index == EdgeIndexCache::invalid) {
+        const std::pair<vec3, vec3> vertex = createVertex();
+        const vec3 normal = normals_ == Normals::Gradient ? vertex.second : vec3(0.0f);
+        index = static_cast<std::uint32_t>(vertices_.size());
+        vertices_.push_back({vertex.first, normal, vertex.first, color_});
+
+        firstPlane_ = std::min(firstPlane_, key.plane);
+        if (key.plane == firstPlane_) {
+            seam_.emplace_back(key, index);
+        }
+    }
+    return index;
+}
+
 } // namespace
 
 #endif // IVW_MARCHINGTETRAHEDRA_H
@@ -0,0 +1,88 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/processors/meshletpacking.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+
+namespace inviwo {
+
+const ProcessorInfo MeshletPacking::processorInfo_{
+    "org.inviwo.MeshletPacking",  // Class identifier
+    "Meshlet Packing",            // Display name
+    "TNM067",                     // Category
+    CodeState::Experimental,      // Code state
+    Tags::None,                   // Tags
+};
+const ProcessorInfo MeshletPacking::getProcessorInfo() const { return processorInfo_; }
+
+MeshletPacking::MeshletPacking()
+    : Processor()
+    , inport_("inputMesh")
+    , volume_("volume")
+    , outport_("meshlets")
+    , quantizePositions_("quantizePositions", "Quantize Positions", true)
+    , grid_("grid", "Voxel Grid", size3_t(128), size3_t(1), size3_t(65536))
+    , memoryReduction_("memoryReduction", "Memory Reduction", 1.0f, 0.0f, 100.0f, 0.01f,
+                       InvalidationLevel::Valid) {
+
+    addPort(inport_);
+    addPort(volume_);
+    addPort(outport_);
+
+    addProperty(quantizePositions_);
+    addProperty(grid_);
+    addProperty(memoryReduction_);
+
+    memoryReduction_.setReadOnly(true);
+    memoryReduction_.setSerializationMode(PropertySerializationMode::None);
+
+    // the grid of the volume the mesh was extracted from, when it is connected
+    volume_.setOptional(true);
+    volume_.onChange([&]() {
+        grid_.setReadOnly(volume_.hasData());
+        if (volume_.hasData()) grid_.set(volume_.getData()->getDimensions());
+    });
+}
+
+void MeshletPacking::process() {
+    const auto mesh = std::dynamic_pointer_cast<const BasicMesh>(inport_.getData());
+    if (!mesh) {
+        throw Exception("The input has to be a BasicMesh", IVW_CONTEXT);
+    }
+
+    auto meshlets =
+        std::make_shared<MeshletMesh>(*mesh, quantizePositions_.get() ? grid_.get() : size3_t(0));
+    memoryReduction_.set(static_cast<float>(MeshletMesh::getSizeInBytes(*mesh)) /
+                         static_cast<float>(std::max<size_t>(meshlets->getSizeInBytes(), 1)));
+    outport_.setData(meshlets);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,279 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/processors/meshsimplification.h>
+#include <modules/tnm067lab2/utils/quadricsimplifier.h>
+#include <modules/tnm067lab2/utils/parallelfor.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace inviwo {
+
+namespace {
+
+namespace detail {
+
+// Smaller partitions lock too large a part of their vertices along the seams
+constexpr size_t minPartitionTriangles = 4096;
+
+struct Partition {
+    std::vector<std::uint32_t> vertices;  // the vertices of the mesh used by the partition
+    std::vector<QuadricSimplifier::Triangle> triangles;
+    std::vector<BasicMesh::Vertex> simplifiedVertices;
+    std::vector<QuadricSimplifier::Triangle> simplifiedTriangles;
+    std::vector<std::uint32_t> remap;  // from vertices to simplifiedVertices
+};
+
+/**
+ * Splits the triangles into count partitions of about the same size, by the position of their
+ * centroids along the longest side of the bounding box of the mesh.
+ */
+std::vector<Partition> partition(const std::vector<BasicMesh::Vertex>& vertices,
+                                 const std::vector<QuadricSimplifier::Triangle>& triangles,
+                                 size_t count) {
+    vec3 lower(std::numeric_limits<float>::max());
+    vec3 upper(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices) {
+        lower = glm::min(lower, std::get<0>(vertex));
+        upper = glm::max(upper, std::get<0>(vertex));
+    }
+    const vec3 extent = upper - lower;
+    const size_t axis =
+        extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    std::vector<float> centroids(triangles.size());
+    for (size_t t = 0; t < triangles.size(); ++t) {
+        centroids[t] = 0.0f;
+        for (const auto v : triangles[t].v) centroids[t] += std::get<0>(vertices[v])[axis];
+    }
+    std::vector<float> splits;
+    {
+        auto sorted = centroids;
+        for (size_t i = 1; i < count; ++i) {
+            const auto nth = sorted.begin() + i * sorted.size() / count;
+            std::nth_element(sorted.begin(), nth, sorted.end());
+            splits.push_back(*nth);
+        }
+        std::sort(splits.begin(), splits.end());
+    }
+
+    std::vector<Partition> partitions(count);
+    for (size_t t = 0; t < triangles.size(); ++t) {
+        const auto i =
+            std::upper_bound(splits.begin(), splits.end(), centroids[t]) - splits.begin();
+        partitions[i].triangles.push_back(triangles[t]);
+    }
+
+    // Renumber the vertices of each partition, triangles still refer to the mesh vertices here
+    for (auto& part : partitions) {
+        for (const auto& triangle : part.triangles) {
+            part.vertices.insert(part.vertices.end(), std::begin(triangle.v),
+                                 std::end(triangle.v));
+        }
+        std::sort(part.vertices.begin(), part.vertices.end());
+        part.vertices.erase(std::unique(part.vertices.begin(), part.vertices.end()),
+                            part.vertices.end());
+        for (auto& triangle : part.triangles) {
+            for (auto& v : triangle.v) {
+                v = static_cast<std::uint32_t>(
+                    std::lower_bound(part.vertices.begin(), part.vertices.end(), v) -
+                    part.vertices.begin());
+            }
+        }
+    }
+    return partitions;
+}
+
+}  // namespace detail
+
+}  // namespace
+
+const ProcessorInfo MeshSimplification::processorInfo_{
+    "org.inviwo.MeshSimplification",  // Class identifier
+    "Mesh Simplification",            // Display name
+    "TNM067",                         // Category
+    CodeState::Experimental,          // Code state
+    Tags::None,                       // Tags
+};
+const ProcessorInfo MeshSimplification::getProcessorInfo() const { return processorInfo_; }
+
+MeshSimplification::MeshSimplification()
+    : Processor()
+    , inport_("inputMesh")
+    , outport_("outputMesh")
+    , targetTriangles_("targetTriangles", "Target Triangles", 100000, 0, 100000000)
+    , threads_("threads", "Threads", std::max<size_t>(1, std::thread::hardware_concurrency()),
+               1, 64)
+    , triangleCount_("triangleCount", "Triangles", 0, 0, std::numeric_limits<size_t>::max(), 1,
+                     InvalidationLevel::Valid)
+    , vertexCount_("vertexCount", "Vertices", 0, 0, std::numeric_limits<size_t>::max(), 1,
+                   InvalidationLevel::Valid) {
+
+    addPort(inport_);
+    addPort(outport_);
+
+    addProperty(targetTriangles_);
+    addProperty(threads_);
+    addProperty(triangleCount_);
+    addProperty(vertexCount_);
+
+    triangleCount_.setReadOnly(true);
+    triangleCount_.setSerializationMode(PropertySerializationMode::None);
+    vertexCount_.setReadOnly(true);
+    vertexCount_.setSerializationMode(PropertySerializationMode::None);
+}
+
+void MeshSimplification::process() {
+    const auto mesh = std::dynamic_pointer_cast<const BasicMesh>(inport_.getData());
+    if (!mesh) {
+        throw Exception("The input has to be a BasicMesh", IVW_CONTEXT);
+    }
+
+    const auto result = simplify(*mesh, targetTriangles_.get(), threads_.get());
+    size_t triangles = 0;
+    for (size_t i = 0; i < result->getNumberOfIndicies(); ++i) {
+        triangles += result->getIndices(i)->getSize() / 3;
+    }
+    triangleCount_.set(triangles);
+    vertexCount_.set(result->getVertices()->getSize());
+    outport_.setData(result);
+}
+
+std::shared_ptr<BasicMesh> MeshSimplification::simplify(const BasicMesh& mesh,
+                                                        size_t targetTriangles, size_t threads) {
+    const auto& positions = mesh.getVertices()->getRAMRepresentation()->getDataContainer();
+    const auto& normals = mesh.getNormals()->getRAMRepresentation()->getDataContainer();
+    const auto& texCoords = mesh.getTexCoords()->getRAMRepresentation()->getDataContainer();
+    const auto& colors = mesh.getColors()->getRAMRepresentation()->getDataContainer();
+    std::vector<BasicMesh::Vertex> vertices;
+    vertices.reserve(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        vertices.emplace_back(positions[i], normals[i], texCoords[i], colors[i]);
+    }
+
+    std::vector<QuadricSimplifier::Triangle> triangles;
+    for (size_t layer = 0; layer < mesh.getNumberOfIndicies(); ++layer) {
+        if (mesh.getIndexMeshInfo(layer).dt != DrawType::Triangles) {
+            throw Exception("Only triangle meshes can be simplified",
+                            IVW_CONTEXT_CUSTOM("MeshSimplification"));
+        }
+        const auto& indices = mesh.getIndices(layer)->getRAMRepresentation()->getDataContainer();
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            triangles.push_back({{indices[t], indices[t + 1], indices[t + 2]},
+                                 static_cast<std::uint32_t>(layer)});
+        }
+    }
+    const size_t triangleCount = triangles.size();
+    auto boundary = QuadricSimplifier::findBoundary(vertices.size(), triangles);
+
+    const size_t partitionCount =
+        std::max<size_t>(1, std::min(threads, triangleCount / detail::minPartitionTriangles));
+    if (partitionCount > 1 && triangleCount > targetTriangles) {
+        auto partitions = detail::partition(vertices, triangles, partitionCount);
+
+        // Vertices used by more than one partition are on a seam
+        std::vector<std::uint32_t> owner(vertices.size(), QuadricSimplifier::invalid);
+        std::vector<bool> locked(boundary);
+        for (size_t i = 0; i < partitions.size(); ++i) {
+            for (const auto v : partitions[i].vertices) {
+                if (owner[v] == QuadricSimplifier::invalid) {
+                    owner[v] = static_cast<std::uint32_t>(i);
+                } else {
+                    locked[v] = true;
+                }
+            }
+        }
+
+        util::parallelFor(partitions.size(), [&](size_t i) {
+            auto& part = partitions[i];
+            std::vector<BasicMesh::Vertex> partVertices;
+            std::vector<bool> partLocked;
+            for (const auto v : part.vertices) {
+                partVertices.push_back(vertices[v]);
+                partLocked.push_back(locked[v]);
+            }
+            const size_t target = targetTriangles * part.triangles.size() / triangleCount;
+            QuadricSimplifier simplifier(std::move(partVertices), std::move(part.triangles),
+                                         std::move(partLocked));
+            simplifier.simplify(target);
+            part.remap = simplifier.compact();
+            part.simplifiedVertices = simplifier.getVertices();
+            part.simplifiedTriangles = simplifier.getTriangles();
+        });
+
+        // Join the partitions, the locked vertices on the seams are the same in all of them
+        std::vector<std::uint32_t> joined(vertices.size(), QuadricSimplifier::invalid);
+        std::vector<BasicMesh::Vertex> joinedVertices;
+        triangles.clear();
+        for (const auto& part : partitions) {
+            std::vector<std::uint32_t> toJoined(part.simplifiedVertices.size());
+            for (size_t i = 0; i < part.vertices.size(); ++i) {
+                if (part.remap[i] == QuadricSimplifier::invalid) continue;
+                auto& index = joined[part.vertices[i]];
+                if (index == QuadricSimplifier::invalid) {
+                    index = static_cast<std::uint32_t>(joinedVertices.size());
+                    joinedVertices.push_back(part.simplifiedVertices[part.remap[i]]);
+                }
+                toJoined[part.remap[i]] = index;
+            }
+            for (auto triangle : part.simplifiedTriangles) {
+                for (auto& v : triangle.v) v = toJoined[v];
+                triangles.push_back(triangle);
+            }
+        }
+        vertices = std::move(joinedVertices);
+        // Only the vertices on the seams are unlocked again, the boundary is the same
+        boundary = QuadricSimplifier::findBoundary(vertices.size(), triangles);
+    }
+
+    QuadricSimplifier simplifier(std::move(vertices), std::move(triangles), std::move(boundary));
+    simplifier.simplify(targetTriangles);
+    simplifier.compact();
+
+    auto result = std::make_shared<BasicMesh>();
+    result->setModelMatrix(mesh.getModelMatrix());
+    result->setWorldMatrix(mesh.getWorldMatrix());
+    result->addVertices(simplifier.getVertices());
+    std::vector<std::vector<std::uint32_t>*> indexBuffers;
+    for (size_t layer = 0; layer < mesh.getNumberOfIndicies(); ++layer) {
+        indexBuffers.push_back(
+            &result->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)
+                 ->getDataContainer());
+    }
+    for (const auto& triangle : simplifier.getTriangles()) {
+        auto& indices = *indexBuffers[triangle.layer];
+        indices.insert(indices.end(), std::begin(triangle.v), std::end(triangle.v));
+    }
+    return result;
+}
+
+}  // namespace inviwo
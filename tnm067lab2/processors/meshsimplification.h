@@ -0,0 +1,83 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_MESHSIMPLIFICATION_H
+#define IVW_MESHSIMPLIFICATION_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/ports/meshport.h>
+#include <inviwo/core/datastructures/geometry/basicmesh.h>
+
+namespace inviwo {
+
+/**
+ * \class MeshSimplification
+ * \brief Reduces a triangle mesh to a triangle budget by quadric error edge collapses
+ *
+ * Takes the mesh of MarchingTetrahedra, or any other BasicMesh of triangles, and collapses edges
+ * with a QuadricSimplifier until at most the target number of triangles is left. Vertices on the
+ * boundary of the mesh are kept in place, so open surfaces keep their outline. Each index buffer
+ * stays a buffer of its own.
+ */
+class IVW_MODULE_TNM067LAB2_API MeshSimplification : public Processor {
+public:
+    MeshSimplification();
+    virtual ~MeshSimplification() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+    /**
+     * Simplifies the mesh to at most targetTriangles triangles if possible. The triangles are
+     * split into one spatial partition per thread, along the longest side of their bounding box,
+     * and the partitions are simplified in parallel with the vertices they share locked. The
+     * partitions get a budget in proportion to their number of triangles. If the joined mesh is
+     * still above the target a last serial pass collapses the edges along the seams.
+     */
+    static std::shared_ptr<BasicMesh> simplify(const BasicMesh& mesh, size_t targetTriangles,
+                                               size_t threads = 1);
+
+private:
+    MeshInport inport_;
+    MeshOutport outport_;
+
+    IntSizeTProperty targetTriangles_;
+    IntSizeTProperty threads_;
+    IntSizeTProperty triangleCount_;
+    IntSizeTProperty vertexCount_;
+};
+
+}  // namespace inviwo
+
+#endif  // IVW_MESHSIMPLIFICATION_H
@@ -0,0 +1,1592 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+
+#include <modules/tnm067lab2/processors/marchingtetrahedra.h>
+#include <modules/tnm067lab2/utils/concurrentedgemap.h>
+#include <modules/tnm067lab2/utils/extractionstats.h>
+#include <modules/tnm067lab2/utils/isoclassifier.h>
+#include <modules/tnm067lab2/utils/isooctree.h>
+#include <modules/tnm067lab2/utils/marchingcubescases.h>
+#include <modules/tnm067lab2/utils/meshcache.h>
+#include <modules/tnm067lab2/utils/meshletmesh.h>
+#include <modules/tnm067lab2/utils/minmaxbricks.h>
+#include <modules/tnm067lab2/utils/spanspaceindex.h>
+#include <modules/tnm067lab2/utils/sparsevolume.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/util/indexmapper.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+namespace inviwo {
+
+    // helpers of the tests below, local to this file
+    namespace {
+
+    std::shared_ptr<Volume> createTestVolume(size3_t dims) {
+        auto volume = std::make_shared<Volume>(dims, DataFloat32::get());
+        auto ram = volume->getEditableRepresentation<VolumeRAM>();
+        auto data = static_cast<float *>(ram->getData());
+        util::IndexMapper3D index(dims);
+
+        // two overlapping blobs, gives both closed and open surface patches
+        size3_t pos;
+        for (pos.z = 0; pos.z < dims.z; ++pos.z) {
+            for (pos.y = 0; pos.y < dims.y; ++pos.y) {
+                for (pos.x = 0; pos.x < dims.x; ++pos.x) {
+                    vec3 p = vec3(pos) / vec3(dims - size3_t(1));
+                    float a = glm::length(p - vec3(0.35f, 0.4f, 0.45f));
+                    float b = glm::length(p - vec3(0.7f, 0.6f, 0.5f));
+                    data[index(pos)] = std::exp(-8.0f * a * a) + 0.6f * std::exp(-20.0f * b * b);
+                }
+            }
+        }
+        volume->dataMap_.dataRange = volume->dataMap_.valueRange = dvec2(0.0, 1.6);
+        return volume;
+    }
+
+    void expectSameMesh(const BasicMesh &expected, const BasicMesh &result) {
+        const auto &ev = expected.getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &rv = result.getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &en = expected.getNormals()->getRAMRepresentation()->getDataContainer();
+        const auto &rn = result.getNormals()->getRAMRepresentation()->getDataContainer();
+        ASSERT_EQ(ev.size(), rv.size());
+        for (size_t i = 0; i < ev.size(); ++i) {
+            EXPECT_EQ(ev[i], rv[i]);
+            EXPECT_EQ(en[i], rn[i]);
+        }
+
+        ASSERT_EQ(expected.getNumberOfIndicies(), result.getNumberOfIndicies());
+        for (size_t b = 0; b < expected.getNumberOfIndicies(); ++b) {
+            const auto &ei = expected.getIndices(b)->getRAMRepresentation()->getDataContainer();
+            const auto &ri = result.getIndices(b)->getRAMRepresentation()->getDataContainer();
+            ASSERT_EQ(ei.size(), ri.size());
+            for (size_t i = 0; i < ei.size(); ++i) {
+                EXPECT_EQ(ei[i], ri[i]);
+            }
+        }
+    }
+
+    using Triangle = std::array<std::array<float, 3>, 3>;
+
+    /**
+     * The triangles of each index buffer as positions, starting at the smallest corner so that
+     * the winding is kept, for comparing meshes with the triangles in another order.
+     */
+    std::vector<std::multiset<Triangle>> sortedTriangles(const BasicMesh &mesh) {
+        const auto &vertices = mesh.getVertices()->getRAMRepresentation()->getDataContainer();
+        std::vector<std::multiset<Triangle>> result;
+        for (size_t b = 0; b < mesh.getNumberOfIndicies(); ++b) {
+            const auto &indices = mesh.getIndices(b)->getRAMRepresentation()->getDataContainer();
+            result.emplace_back();
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                Triangle triangle;
+                for (size_t j = 0; j < 3; ++j) {
+                    const vec3 v = vertices[indices[i + j]];
+                    triangle[j] = {{v.x, v.y, v.z}};
+                }
+                std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()),
+                            triangle.end());
+                result.back().insert(triangle);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * A path in the temporary directory that no other test run uses, the file or directory
+     * there is removed again when it goes out of scope.
+     */
+    struct TempPath {
+        explicit TempPath(const std::string &name) {
+            std::random_device random;
+            std::ostringstream unique;
+            unique << name << "-" << std::hex << random() << random();
+            path = (std::filesystem::temp_directory_path() / unique.str()).string();
+        }
+        TempPath(const TempPath &) = delete;
+        TempPath &operator=(const TempPath &) = delete;
+        ~TempPath() {
+            std::error_code error;
+            std::filesystem::remove_all(path, error);
+        }
+
+        std::string path;
+    };
+
+    }  // namespace
+
+    TEST(MarchingTetrahedraTest, addVertexSharesEdges) {
+        auto volume = createTestVolume(size3_t(5, 4, 6));
+        util::IndexMapper3D index(volume->getDimensions());
+        MarchingTetrahedra::MeshHelper mesh(volume);
+
+        // x-edge from (1,2,3), i.e. edge 1 (corners 2-3) of cell (1,1,3)
+        auto a = mesh.addVertex(vec3(0.1f), index(size3_t(1, 2, 3)), index(size3_t(2, 2, 3)));
+        EXPECT_EQ(a, mesh.addVertex(vec3(0.1f), index(size3_t(2, 2, 3)), index(size3_t(1, 2, 3))));
+        EXPECT_EQ(a, mesh.addVertex(vec3(0.1f), size3_t(1, 1, 3), 1));
+
+        // cell diagonal (corners 2-5) of cell (1,1,2)
+        auto b = mesh.addVertex(vec3(0.2f), size3_t(1, 1, 2), 18);
+        EXPECT_NE(a, b);
+        EXPECT_EQ(b, mesh.addVertex(vec3(0.2f), index(size3_t(2, 1, 3)), index(size3_t(1, 2, 2))));
+
+        // not an edge of the cell decomposition
+        auto c = mesh.addVertex(vec3(0.3f), index(size3_t(0, 0, 0)), index(size3_t(4, 3, 5)));
+        EXPECT_EQ(c, mesh.addVertex(vec3(0.3f), index(size3_t(4, 3, 5)), index(size3_t(0, 0, 0))));
+
+        EXPECT_EQ(3u, mesh.toBasicMesh()->getVertices()->getSize());
+    }
+
+    TEST(MarchingTetrahedraTest, addVertexAnyPlaneOrder) {
+        auto volume = createTestVolume(size3_t(5, 4, 6));
+        util::IndexMapper3D index(volume->getDimensions());
+        MarchingTetrahedra::MeshHelper mesh(volume);
+
+        // x-edges on every plane, then back to the first one, which the edge cache has evicted
+        std::vector<std::uint32_t> vertices;
+        for (size_t z = 0; z < 6; ++z) {
+            vertices.push_back(
+                mesh.addVertex(vec3(0.1f), index(size3_t(1, 2, z)), index(size3_t(2, 2, z))));
+        }
+        for (size_t z = 6; z-- > 0;) {
+            EXPECT_EQ(vertices[z], mesh.addVertex(vec3(0.1f), index(size3_t(2, 2, z)),
+                                                  index(size3_t(1, 2, z))));
+        }
+
+        EXPECT_EQ(6u, mesh.toBasicMesh()->getVertices()->getSize());
+    }
+
+    TEST(MarchingTetrahedraTest, threadCountIndependent) {
+        for (auto dims : {size3_t(17, 13, 11), size3_t(9, 24, 31)}) {
+            auto volume = createTestVolume(dims);
+            auto serial = MarchingTetrahedra::extract(volume, 0.5f, 1);
+            EXPECT_LT(0u, serial->getIndices(0)->getSize());
+
+            for (size_t threads : {2, 3, 7, 64}) {
+                auto parallel = MarchingTetrahedra::extract(volume, 0.5f, threads);
+                expectSameMesh(*serial, *parallel);
+            }
+        }
+    }
+
+
+    TEST(MarchingTetrahedraTest, concurrentExtractions) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Normals = MarchingTetrahedra::Normals;
+
+        // volumes of different sizes, as several processors in one network would have
+        const std::vector<size3_t> dims = {size3_t(17, 13, 11), size3_t(9, 24, 31),
+                                           size3_t(32, 8, 20), size3_t(5, 40, 7)};
+        std::vector<std::shared_ptr<Volume>> volumes;
+        std::vector<std::shared_ptr<BasicMesh>> expected;
+        for (const auto &d : dims) {
+            volumes.push_back(createTestVolume(d));
+            expected.push_back(MarchingTetrahedra::extract(volumes.back(), {0.5f},
+                                                           {vec4(0.7f, 0.7f, 0.7f, 1.0f)}, 1,
+                                                           nullptr, Normals::FaceAccumulated,
+                                                           Allocation::Incremental));
+        }
+
+        // every job is an extraction of its own, some of them with threads of their own
+        const size_t rounds = 4;
+        std::vector<std::future<std::shared_ptr<BasicMesh>>> jobs;
+        for (size_t i = 0; i < rounds * volumes.size(); ++i) {
+            const auto volume = volumes[i % volumes.size()];
+            const size_t threads = 1 + i % 3;
+            const auto allocation = i % 2 ? Allocation::CountThenFill : Allocation::Incremental;
+            jobs.push_back(std::async(std::launch::async, [volume, threads, allocation]() {
+                return MarchingTetrahedra::extract(volume, {0.5f}, {vec4(0.7f, 0.7f, 0.7f, 1.0f)},
+                                                   threads, nullptr, Normals::FaceAccumulated,
+                                                   allocation);
+            }));
+        }
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            expectSameMesh(*expected[i % volumes.size()], *jobs[i].get());
+        }
+
+        // the edges outside of the cell decomposition of helpers of different volumes
+        std::vector<std::future<void>> helpers;
+        for (const auto &volume : volumes) {
+            helpers.push_back(std::async(std::launch::async, [volume]() {
+                const auto d = volume->getDimensions();
+                const size_t size = d.x * d.y * d.z;
+                MarchingTetrahedra::MeshHelper mesh(volume);
+                for (size_t i = 0; i + 1 < size; ++i) {
+                    const auto a = mesh.addVertex(vec3(0.0f), i, size - 1);
+                    EXPECT_EQ(a, mesh.addVertex(vec3(0.0f), size - 1, i));
+                }
+            }));
+        }
+        for (auto &job : helpers) job.get();
+    }
+
+    TEST(MarchingTetrahedraTest, multiChannelVolume) {
+        const size3_t dims(17, 13, 11);
+        auto scalar = createTestVolume(dims);
+        const auto values = static_cast<const float *>(
+            scalar->getRepresentation<VolumeRAM>()->getData());
+
+        // the first channel is the scalar volume, the second one would give other surfaces
+        auto volume = std::make_shared<Volume>(dims, DataVec2Float32::get());
+        auto data = static_cast<vec2 *>(volume->getEditableRepresentation<VolumeRAM>()->getData());
+        for (size_t i = 0; i < dims.x * dims.y * dims.z; ++i) {
+            data[i] = vec2(values[i], 1.0f - values[i]);
+        }
+        volume->dataMap_ = scalar->dataMap_;
+
+        // the span space index is built from the first channel as well
+        SpanSpaceIndex index(*scalar->getRepresentation<VolumeRAM>());
+        for (size_t threads : {1, 3}) {
+            expectSameMesh(*MarchingTetrahedra::extract(scalar, 0.5f, threads),
+                           *MarchingTetrahedra::extract(volume, 0.5f, threads));
+            expectSameMesh(*MarchingTetrahedra::extract(scalar, 0.5f, index, threads),
+                           *MarchingTetrahedra::extract(volume, 0.5f, index, threads));
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, countThenFill) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Normals = MarchingTetrahedra::Normals;
+
+        auto volume = createTestVolume(size3_t(19, 14, 23));
+        const std::vector<float> isos = {0.3f, 0.6f, 0.9f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1), vec4(0, 0, 1, 1)};
+        SpanSpaceIndex index(*volume->getRepresentation<VolumeRAM>());
+        MinMaxBricks bricks(*volume->getRepresentation<VolumeRAM>());
+
+        // the mesh is the same as the one built incrementally, for any number of threads
+        for (auto normals : {Normals::FaceAccumulated, Normals::Gradient}) {
+            auto expected = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr, normals,
+                                                        Allocation::Incremental);
+            for (size_t threads : {1, 2, 5, 22, 64}) {
+                expectSameMesh(*expected,
+                               *MarchingTetrahedra::extract(volume, isos, colors, threads, nullptr,
+                                                            normals, Allocation::CountThenFill));
+                expectSameMesh(*expected,
+                               *MarchingTetrahedra::extract(volume, isos, colors, threads, &bricks,
+                                                            normals, Allocation::CountThenFill));
+                expectSameMesh(*expected,
+                               *MarchingTetrahedra::extract(volume, isos, colors, index, threads,
+                                                            normals, Allocation::CountThenFill));
+            }
+        }
+
+        // nothing to extract
+        auto empty = MarchingTetrahedra::extract(volume, std::vector<float>{2.0f},
+                                                 std::vector<vec4>{vec4(1.0f)}, 4);
+        EXPECT_EQ(0u, empty->getVertices()->getSize());
+        EXPECT_EQ(0u, empty->getIndices(0)->getSize());
+    }
+
+    TEST(MarchingTetrahedraTest, concurrentEdgeMap) {
+        const size_t edges = 5000;
+        ConcurrentEdgeMap map(edges);
+        EXPECT_LE(edges, map.capacity());
+
+        // every thread inserts all the edges, in an order of its own
+        const size_t threads = 8;
+        std::vector<std::vector<std::uint32_t>> indices(threads);
+        std::vector<size_t> inserted(threads, 0);
+        std::vector<std::future<void>> jobs;
+        for (size_t t = 0; t < threads; ++t) {
+            jobs.push_back(std::async(std::launch::async, [&, t]() {
+                std::vector<size_t> order(edges);
+                for (size_t i = 0; i < edges; ++i) order[i] = i;
+                std::shuffle(order.begin(), order.end(), std::mt19937(static_cast<unsigned>(t)));
+                indices[t].resize(edges);
+                for (auto i : order) {
+                    const auto vertex = map.findOrInsert(ConcurrentEdgeMap::key(i + 7, 3 * i));
+                    indices[t][i] = vertex.first;
+                    if (vertex.second) ++inserted[t];
+                }
+            }));
+        }
+        for (auto &job : jobs) job.get();
+
+        // each edge was inserted once, and all threads got the same index for it
+        size_t insertedTotal = 0;
+        for (auto count : inserted) insertedTotal += count;
+        EXPECT_EQ(edges, insertedTotal);
+        EXPECT_EQ(edges, map.size());
+        std::set<std::uint32_t> unique;
+        for (size_t i = 0; i < edges; ++i) {
+            for (size_t t = 1; t < threads; ++t) {
+                EXPECT_EQ(indices[0][i], indices[t][i]);
+            }
+            EXPECT_EQ(indices[0][i], map.find(ConcurrentEdgeMap::key(3 * i, i + 7)));
+            unique.insert(indices[0][i]);
+        }
+        EXPECT_EQ(edges, unique.size());
+        EXPECT_EQ(edges - 1, *unique.rbegin());
+        EXPECT_EQ(ConcurrentEdgeMap::invalid, map.find(ConcurrentEdgeMap::key(1, 2)));
+
+        // a full map still finds the edges it has
+        ConcurrentEdgeMap small(10);
+        size_t i = 0;
+        while (small.findOrInsert(ConcurrentEdgeMap::key(i, i + 1)).first !=
+               ConcurrentEdgeMap::invalid) {
+            ++i;
+        }
+        EXPECT_EQ(small.capacity(), i);
+        EXPECT_EQ(small.capacity(), small.size());
+        EXPECT_EQ(0u, small.findOrInsert(ConcurrentEdgeMap::key(1, 0)).first);
+
+        // many threads filling a tiny map at once never get an index past its capacity
+        for (size_t round = 0; round < 20; ++round) {
+            ConcurrentEdgeMap tiny(10);
+            std::vector<std::vector<std::uint32_t>> created(threads);
+            std::vector<std::future<void>> fillers;
+            for (size_t t = 0; t < threads; ++t) {
+                fillers.push_back(std::async(std::launch::async, [&, t]() {
+                    for (size_t e = 0; e < 64; ++e) {
+                        const auto vertex =
+                            tiny.findOrInsert(ConcurrentEdgeMap::key(e, 1000 + 64 * t + e));
+                        if (vertex.first == ConcurrentEdgeMap::invalid) continue;
+                        EXPECT_LT(vertex.first, tiny.capacity());
+                        if (vertex.second) created[t].push_back(vertex.first);
+                    }
+                }));
+            }
+            for (auto &job : fillers) job.get();
+
+            // the valid indices are the dense range [0, capacity)
+            std::set<std::uint32_t> all;
+            for (const auto &c : created) all.insert(c.begin(), c.end());
+            EXPECT_EQ(tiny.capacity(), all.size());
+            EXPECT_EQ(tiny.capacity(), tiny.size());
+            if (!all.empty()) EXPECT_EQ(tiny.capacity() - 1, *all.rbegin());
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, sharedAllocation) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Method = MarchingTetrahedra::Method;
+        using Normals = MarchingTetrahedra::Normals;
+
+        auto volume = createTestVolume(size3_t(19, 14, 23));
+        const std::vector<float> isos = {0.3f, 0.6f, 0.9f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1), vec4(0, 0, 1, 1)};
+        SpanSpaceIndex index(*volume->getRepresentation<VolumeRAM>());
+        MinMaxBricks bricks(*volume->getRepresentation<VolumeRAM>());
+
+        // the same triangles in the same order, only the vertices are numbered differently
+        auto expectSameTriangles = [](const BasicMesh &expected, const BasicMesh &result) {
+            const auto &ev = expected.getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &rv = result.getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &en = expected.getNormals()->getRAMRepresentation()->getDataContainer();
+            const auto &rn = result.getNormals()->getRAMRepresentation()->getDataContainer();
+            ASSERT_EQ(ev.size(), rv.size());
+            ASSERT_EQ(expected.getNumberOfIndicies(), result.getNumberOfIndicies());
+            for (size_t b = 0; b < expected.getNumberOfIndicies(); ++b) {
+                const auto &ei = expected.getIndices(b)->getRAMRepresentation()->getDataContainer();
+                const auto &ri = result.getIndices(b)->getRAMRepresentation()->getDataContainer();
+                ASSERT_EQ(ei.size(), ri.size());
+                for (size_t i = 0; i < ei.size(); ++i) {
+                    EXPECT_EQ(ev[ei[i]], rv[ri[i]]);
+                    EXPECT_EQ(en[ei[i]], rn[ri[i]]);
+                }
+            }
+        };
+
+        for (auto method : {Method::Tetrahedra, Method::Cubes}) {
+            for (auto normals : {Normals::FaceAccumulated, Normals::Gradient}) {
+                auto expected = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr,
+                                                            normals, Allocation::Incremental,
+                                                            method);
+                auto single = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr,
+                                                          normals, Allocation::Shared, method);
+                expectSameTriangles(*expected, *single);
+
+                // the vertices do not depend on which thread reached them first
+                for (size_t threads : {2, 5, 22, 64}) {
+                    expectSameMesh(*single, *MarchingTetrahedra::extract(
+                                                volume, isos, colors, threads, nullptr, normals,
+                                                Allocation::Shared, method));
+                    expectSameMesh(*single, *MarchingTetrahedra::extract(
+                                                volume, isos, colors, threads, &bricks, normals,
+                                                Allocation::Shared, method));
+                    expectSameMesh(*single, *MarchingTetrahedra::extract(
+                                                volume, isos, colors, index, threads, normals,
+                                                Allocation::Shared, method));
+                }
+            }
+        }
+
+        // larger than the first guess of the number of vertices
+        auto noisy = std::make_shared<Volume>(size3_t(40, 40, 40), DataFloat32::get());
+        auto data = static_cast<float *>(noisy->getEditableRepresentation<VolumeRAM>()->getData());
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+        for (size_t i = 0; i < 40 * 40 * 40; ++i) data[i] = distribution(random);
+        noisy->dataMap_.dataRange = noisy->dataMap_.valueRange = dvec2(0.0, 1.0);
+        expectSameTriangles(
+            *MarchingTetrahedra::extract(noisy, {0.5f}, {vec4(1.0f)}, 1, nullptr,
+                                         Normals::FaceAccumulated, Allocation::Incremental),
+            *MarchingTetrahedra::extract(noisy, {0.5f}, {vec4(1.0f)}, 4, nullptr,
+                                         Normals::FaceAccumulated, Allocation::Shared));
+    }
+
+    TEST(MarchingTetrahedraTest, sparseVolume) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Method = MarchingTetrahedra::Method;
+        using Normals = MarchingTetrahedra::Normals;
+
+        // distance to a sphere clamped to a narrow band, the background outside of it
+        const size3_t dims(40, 34, 48);
+        const float band = 2.5f;
+        auto volume = std::make_shared<Volume>(dims, DataFloat32::get());
+        auto data = static_cast<float *>(volume->getEditableRepresentation<VolumeRAM>()->getData());
+        util::IndexMapper3D index(dims);
+        size3_t pos;
+        for (pos.z = 0; pos.z < dims.z; ++pos.z) {
+            for (pos.y = 0; pos.y < dims.y; ++pos.y) {
+                for (pos.x = 0; pos.x < dims.x; ++pos.x) {
+                    const float distance = glm::length(vec3(pos) - vec3(19.0f, 16.0f, 23.0f));
+                    data[index(pos)] = std::min(std::abs(distance - 13.5f), band);
+                }
+            }
+        }
+        volume->dataMap_.dataRange = volume->dataMap_.valueRange = dvec2(0.0, band);
+
+        const SparseVolume sparse(*volume->getRepresentation<VolumeRAM>(), band);
+        const size3_t blocks = sparse.getBlockDimensions();
+        EXPECT_EQ(size3_t(5, 5, 6), blocks);
+        EXPECT_LT(0u, sparse.getAllocatedBlockCount());
+        EXPECT_GT(blocks.x * blocks.y * blocks.z, sparse.getAllocatedBlockCount());
+        EXPECT_GT(dims.x * dims.y * dims.z * sizeof(float), sparse.getSizeInBytes());
+        EXPECT_GT(0.5f, sparse.getValueRange().x);
+        EXPECT_EQ(band, sparse.getValueRange().y);
+        for (pos.z = 0; pos.z < dims.z; ++pos.z) {
+            for (pos.y = 0; pos.y < dims.y; ++pos.y) {
+                for (pos.x = 0; pos.x < dims.x; ++pos.x) {
+                    ASSERT_EQ(data[index(pos)], sparse.getValue(pos));
+                }
+            }
+        }
+        // the center of the sphere is far from the surface
+        EXPECT_TRUE(sparse.getBlock(size3_t(19, 16, 23) / SparseVolume::blockSize) == nullptr);
+
+        // the background value does not allocate blocks
+        SparseVolume edited(dims, band);
+        edited.setValue(size3_t(3, 4, 5), band);
+        EXPECT_EQ(0u, edited.getAllocatedBlockCount());
+        edited.setValue(size3_t(39, 33, 47), 1.0f);
+        EXPECT_EQ(1u, edited.getAllocatedBlockCount());
+        EXPECT_EQ(1.0f, edited.getValue(size3_t(39, 33, 47)));
+        EXPECT_EQ(band, edited.getValue(size3_t(38, 33, 47)));
+        EXPECT_TRUE(edited.getBlock(size3_t(4, 4, 5)) != nullptr);
+
+        // to compare the gradient normals of meshes with the vertices in another order
+        auto normalsByPosition = [](const BasicMesh &mesh) {
+            const auto &v = mesh.getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &n = mesh.getNormals()->getRAMRepresentation()->getDataContainer();
+            std::map<std::array<float, 3>, vec3> result;
+            for (size_t i = 0; i < v.size(); ++i) result[{{v[i].x, v[i].y, v[i].z}}] = n[i];
+            return result;
+        };
+
+        const std::vector<float> isos = {0.5f, 1.7f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1)};
+        for (auto method : {Method::Tetrahedra, Method::Cubes}) {
+            for (auto normals : {Normals::FaceAccumulated, Normals::Gradient}) {
+                auto expected = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr,
+                                                            normals, Allocation::Incremental,
+                                                            method);
+                auto mesh =
+                    MarchingTetrahedra::extractSparse(sparse, isos, colors, 1, normals, method);
+                ASSERT_LT(0u, mesh->getVertices()->getSize());
+                EXPECT_EQ(sortedTriangles(*expected), sortedTriangles(*mesh));
+                if (normals == Normals::Gradient) {
+                    EXPECT_EQ(normalsByPosition(*expected), normalsByPosition(*mesh));
+                }
+                for (size_t threads : {3, 16}) {
+                    expectSameMesh(*mesh, *MarchingTetrahedra::extractSparse(
+                                              sparse, isos, colors, threads, normals, method));
+                }
+            }
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, extractionStats) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Normals = MarchingTetrahedra::Normals;
+        using Phase = ExtractionStats::Phase;
+
+        const size3_t dims(24, 19, 21);
+        auto volume = createTestVolume(dims);
+        const std::vector<float> isos = {0.3f, 0.9f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1)};
+        const size_t cells = (dims.x - 1) * (dims.y - 1) * (dims.z - 1);
+
+        for (auto allocation :
+             {Allocation::CountThenFill, Allocation::Incremental, Allocation::Shared}) {
+            ExtractionStats stats;
+            auto mesh = MarchingTetrahedra::extract(
+                volume, isos, colors, 1, nullptr, Normals::FaceAccumulated, allocation,
+                MarchingTetrahedra::Method::Tetrahedra, MarchingTetrahedra::Traversal::Linear,
+                nullptr, nullptr, &stats);
+            // the stats do not change the mesh
+            expectSameMesh(*MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr,
+                                                        Normals::FaceAccumulated, allocation),
+                           *mesh);
+
+            // every cell once, also with the counting pass
+            EXPECT_EQ(cells, stats.getCellsVisited());
+            EXPECT_LT(0u, stats.getActiveCells());
+            EXPECT_GT(cells, stats.getActiveCells());
+            // with a single thread every vertex is created once
+            EXPECT_EQ(mesh->getVertices()->getSize(),
+                      stats.getVertexLookups() - stats.getDedupHits());
+            EXPECT_LT(0.5, stats.getDedupHitRate());
+            EXPECT_LT(0u, stats.getPeakEdgeMapSize());
+            EXPECT_LE(MeshletMesh::getSizeInBytes(*mesh), stats.getBytesAllocated());
+            EXPECT_LT(0.0, stats.getSeconds(Phase::Classification));
+            EXPECT_LT(0.0, stats.getSeconds(Phase::Interpolation));
+            EXPECT_LT(0.0, stats.getSeconds(Phase::NormalFinalize));
+
+            const auto json = stats.toJSON();
+            EXPECT_NE(std::string::npos,
+                      json.find("\"cellsVisited\": " + std::to_string(cells) + ","));
+            for (size_t i = 0; i < ExtractionStats::phaseCount; ++i) {
+                const auto name = ExtractionStats::getName(static_cast<Phase>(i));
+                EXPECT_NE(std::string::npos, json.find("\"" + std::string(name) + "\": "));
+            }
+
+            // the threads add to the same stats
+            ExtractionStats threaded;
+            MarchingTetrahedra::extract(volume, isos, colors, 4, nullptr,
+                                        Normals::FaceAccumulated, allocation,
+                                        MarchingTetrahedra::Method::Tetrahedra,
+                                        MarchingTetrahedra::Traversal::Linear, nullptr, nullptr,
+                                        &threaded);
+            EXPECT_EQ(cells, threaded.getCellsVisited());
+            EXPECT_EQ(stats.getActiveCells(), threaded.getActiveCells());
+
+            stats.reset();
+            EXPECT_EQ(0u, stats.getCellsVisited());
+            EXPECT_EQ(0.0, stats.getDedupHitRate());
+            EXPECT_EQ(0.0, stats.getSeconds(Phase::Classification));
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, DISABLED_edgeMapBenchmark) {
+        using HashFunc = MarchingTetrahedra::HashFunc;
+
+        // the x-, y- and z-edges of a volume, each thread inserts its share of them and then
+        // looks up the share of the next thread, as the cells on both sides of a seam would
+        const size3_t dims(128);
+        const size_t voxels = dims.x * dims.y * dims.z;
+        std::vector<std::pair<size_t, size_t>> edges;
+        for (size_t i = 0; i + dims.x * dims.y < voxels; ++i) {
+            edges.emplace_back(i, i + 1);
+            edges.emplace_back(i, i + dims.x);
+            edges.emplace_back(i, i + dims.x * dims.y);
+        }
+
+        for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+            auto run = [&](auto findOrInsert) {
+                const auto start = std::chrono::steady_clock::now();
+                std::vector<std::future<void>> jobs;
+                for (size_t t = 0; t < threads; ++t) {
+                    jobs.push_back(std::async(std::launch::async, [&, t]() {
+                        for (size_t pass = 0; pass < 2; ++pass) {
+                            const size_t share = (t + pass) % threads;
+                            const size_t end = (share + 1) * edges.size() / threads;
+                            for (size_t i = share * edges.size() / threads; i < end; ++i) {
+                                findOrInsert(edges[i]);
+                            }
+                        }
+                    }));
+                }
+                for (auto &job : jobs) job.get();
+                const std::chrono::duration<double, std::milli> time =
+                    std::chrono::steady_clock::now() - start;
+                return time.count();
+            };
+
+            std::mutex mutex;
+            std::unordered_map<std::pair<size_t, size_t>, size_t, HashFunc> locked(
+                edges.size(), HashFunc(voxels));
+            const double lockedTime = run([&](const std::pair<size_t, size_t> &edge) {
+                std::lock_guard<std::mutex> lock(mutex);
+                return locked.emplace(edge, locked.size()).first->second;
+            });
+
+            ConcurrentEdgeMap concurrent(edges.size());
+            const double concurrentTime = run([&](const std::pair<size_t, size_t> &edge) {
+                return concurrent.findOrInsert(ConcurrentEdgeMap::key(edge.first, edge.second))
+                    .first;
+            });
+
+            EXPECT_EQ(edges.size(), locked.size());
+            EXPECT_EQ(edges.size(), concurrent.size());
+            std::cout << threads << " threads: mutex + unordered_map " << lockedTime
+                      << " ms, ConcurrentEdgeMap " << concurrentTime << " ms" << std::endl;
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, consistentWinding) {
+        // noise hits all 16 tetrahedra cases; with a consistent winding every edge between two
+        // triangles is traversed once in each direction
+        const size3_t dims(9, 8, 10);
+        auto volume = std::make_shared<Volume>(dims, DataFloat32::get());
+        auto data = static_cast<float *>(volume->getEditableRepresentation<VolumeRAM>()->getData());
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (size_t i = 0; i < dims.x * dims.y * dims.z; ++i) {
+            data[i] = dist(rng);
+        }
+
+        auto mesh = MarchingTetrahedra::extract(volume, 0.5f);
+        const auto &indices = mesh->getIndices(0)->getRAMRepresentation()->getDataContainer();
+        std::set<std::pair<std::uint32_t, std::uint32_t>> edges;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (size_t j = 0; j < 3; ++j) {
+                EXPECT_TRUE(edges.emplace(indices[i + j], indices[i + (j + 1) % 3]).second);
+            }
+        }
+
+        // and the faces point towards lower values, i.e. away from the blob center
+        auto blob = createTestVolume(size3_t(16));
+        auto blobMesh = MarchingTetrahedra::extract(blob, 0.9f);
+        const auto &vertices = blobMesh->getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &normals = blobMesh->getNormals()->getRAMRepresentation()->getDataContainer();
+        ASSERT_LT(0u, vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            EXPECT_LT(0.0f, glm::dot(normals[i], vertices[i] - vec3(0.35f, 0.4f, 0.45f)));
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, marchingCubes) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Method = MarchingTetrahedra::Method;
+        using Normals = MarchingTetrahedra::Normals;
+        const std::vector<float> isos = {0.5f};
+        const std::vector<vec4> colors = {vec4(0.7f, 0.7f, 0.7f, 1.0f)};
+
+        // noise hits the ambiguous faces; the surface is closed apart from the volume border,
+        // i.e. every edge between two triangles is traversed once in each direction
+        const size3_t dims(11, 9, 10);
+        auto noise = std::make_shared<Volume>(dims, DataFloat32::get());
+        auto data = static_cast<float *>(noise->getEditableRepresentation<VolumeRAM>()->getData());
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (size_t i = 0; i < dims.x * dims.y * dims.z; ++i) {
+            data[i] = dist(rng);
+        }
+        auto mesh = MarchingTetrahedra::extract(noise, isos, colors, 1, nullptr,
+                                                Normals::FaceAccumulated,
+                                                Allocation::Incremental, Method::Cubes);
+        const auto &vertices = mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &indices = mesh->getIndices(0)->getRAMRepresentation()->getDataContainer();
+        ASSERT_LT(0u, indices.size());
+        std::set<std::pair<std::uint32_t, std::uint32_t>> edges;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (size_t j = 0; j < 3; ++j) {
+                EXPECT_TRUE(edges.emplace(indices[i + j], indices[i + (j + 1) % 3]).second);
+            }
+        }
+        for (const auto &edge : edges) {
+            if (edges.count(std::make_pair(edge.second, edge.first))) continue;
+            const vec3 a = vertices[edge.first];
+            const vec3 b = vertices[edge.second];
+            bool border = false;
+            for (int axis = 0; axis < 3; ++axis) {
+                border |= a[axis] == b[axis] && (a[axis] == 0.0f || a[axis] == 1.0f);
+            }
+            EXPECT_TRUE(border) << "crack between " << a << " and " << b;
+        }
+
+        // same mesh for all ways of extracting it
+        for (auto normals : {Normals::FaceAccumulated, Normals::Gradient}) {
+            auto volume = createTestVolume(size3_t(19, 14, 23));
+            SpanSpaceIndex index(*volume->getRepresentation<VolumeRAM>());
+            MinMaxBricks bricks(*volume->getRepresentation<VolumeRAM>());
+            auto expected = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr, normals,
+                                                        Allocation::Incremental, Method::Cubes);
+            for (size_t threads : {1, 3, 8}) {
+                for (auto allocation : {Allocation::Incremental, Allocation::CountThenFill}) {
+                    expectSameMesh(*expected, *MarchingTetrahedra::extract(
+                                                  volume, isos, colors, threads, &bricks,
+                                                  normals, allocation, Method::Cubes));
+                    expectSameMesh(*expected, *MarchingTetrahedra::extract(
+                                                  volume, isos, colors, index, threads, normals,
+                                                  allocation, Method::Cubes));
+                }
+            }
+        }
+
+        // about half as many triangles as the tetrahedra, facing away from the blob center
+        auto blob = createTestVolume(size3_t(24));
+        auto cubes = MarchingTetrahedra::extract(blob, {0.9f}, colors, 1, nullptr,
+                                                 Normals::FaceAccumulated,
+                                                 Allocation::CountThenFill, Method::Cubes);
+        auto tetrahedra = MarchingTetrahedra::extract(blob, 0.9f);
+        EXPECT_GT(0.6 * tetrahedra->getIndices(0)->getSize(), cubes->getIndices(0)->getSize());
+        EXPECT_GT(tetrahedra->getVertices()->getSize(), cubes->getVertices()->getSize());
+        const auto &cv = cubes->getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &cn = cubes->getNormals()->getRAMRepresentation()->getDataContainer();
+        ASSERT_LT(0u, cv.size());
+        for (size_t i = 0; i < cv.size(); ++i) {
+            EXPECT_LT(0.0f, glm::dot(cn[i], cv[i] - vec3(0.35f, 0.4f, 0.45f)));
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, marchingCubesCenterLoops) {
+        // A case has room for a single center vertex, so no case may have two loops around it
+        const auto &cases = MarchingCubesCases::get().getCases();
+        EXPECT_LE(256u, cases.size());
+        size_t centered = 0;
+        for (const auto &c : cases) {
+            // next[a] = b for each triangle (center, a, b)
+            int next[MarchingCubesCases::center];
+            std::fill(std::begin(next), std::end(next), -1);
+            size_t centerTriangles = 0;
+            for (size_t t = 0; t < c.triangleCount; ++t) {
+                const auto &triangle = c.triangles[t];
+                for (size_t k = 0; k < 3; ++k) {
+                    if (triangle[k] != MarchingCubesCases::center) continue;
+                    const size_t a = triangle[(k + 1) % 3];
+                    EXPECT_EQ(-1, next[a]);
+                    EXPECT_TRUE((c.centerLoop >> a) & 1);
+                    next[a] = triangle[(k + 2) % 3];
+                    ++centerTriangles;
+                }
+            }
+            const size_t loopSize = std::bitset<16>(c.centerLoop).count();
+            EXPECT_EQ(loopSize, centerTriangles);
+            if (loopSize == 0) continue;
+            ++centered;
+
+            // going around the center from any of its triangles visits all of them
+            const size_t start = std::find_if(std::begin(next), std::end(next),
+                                              [](int edge) { return edge != -1; }) -
+                                 std::begin(next);
+            size_t length = 0;
+            size_t edge = start;
+            do {
+                ASSERT_NE(-1, next[edge]);
+                edge = static_cast<size_t>(next[edge]);
+                ++length;
+            } while (edge != start && length <= loopSize);
+            EXPECT_EQ(loopSize, length);
+        }
+        EXPECT_LT(0u, centered);
+    }
+
+    TEST(MarchingTetrahedraTest, adaptiveOctree) {
+        using Normals = MarchingTetrahedra::Normals;
+        const std::vector<vec4> colors = {vec4(0.7f, 0.7f, 0.7f, 1.0f)};
+        const size3_t dims(61, 57, 65);
+        auto blob = createTestVolume(dims);
+        const auto data = static_cast<const float *>(blob->getRepresentation<VolumeRAM>()->getData());
+        util::IndexMapper3D index(dims);
+
+        // trilinear interpolation of the volume at a position in [0, 1]
+        auto sample = [&](vec3 pos) {
+            const vec3 p = pos * vec3(dims - size3_t(1));
+            const size3_t first = glm::min(size3_t(p), dims - size3_t(2));
+            const vec3 t = p - vec3(first);
+            float value = 0.0f;
+            for (size_t corner = 0; corner < 8; ++corner) {
+                const size3_t offset(corner & 1, (corner >> 1) & 1, corner >> 2);
+                float weight = 1.0f;
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    weight *= offset[axis] ? t[axis] : 1.0f - t[axis];
+                }
+                value += weight * data[index(first + offset)];
+            }
+            return value;
+        };
+
+        size_t fullTriangles = 0;
+        for (float tolerance : {0.0f, 0.016f}) {
+            for (auto normals : {Normals::FaceAccumulated, Normals::Gradient}) {
+                auto mesh = MarchingTetrahedra::extractAdaptive(blob, {0.9f}, colors, tolerance,
+                                                                nullptr, normals);
+                const auto &vertices =
+                    mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+                const auto &vertexNormals =
+                    mesh->getNormals()->getRAMRepresentation()->getDataContainer();
+                const auto &indices =
+                    mesh->getIndices(0)->getRAMRepresentation()->getDataContainer();
+                ASSERT_LT(0u, indices.size());
+                if (tolerance == 0.0f) fullTriangles = indices.size() / 3;
+
+                // closed also where leaves of different sizes meet
+                std::set<std::pair<std::uint32_t, std::uint32_t>> edges;
+                for (size_t i = 0; i < indices.size(); i += 3) {
+                    for (size_t j = 0; j < 3; ++j) {
+                        EXPECT_TRUE(edges.emplace(indices[i + j], indices[i + (j + 1) % 3]).second);
+                    }
+                }
+                for (const auto &edge : edges) {
+                    EXPECT_EQ(1u, edges.count(std::make_pair(edge.second, edge.first)))
+                        << "crack between " << vertices[edge.first] << " and "
+                        << vertices[edge.second];
+                }
+
+                // near the surface and facing away from the blob center
+                for (size_t i = 0; i < vertices.size(); ++i) {
+                    EXPECT_NEAR(0.9f, sample(vertices[i]), 0.02f + 2.0f * tolerance);
+                    EXPECT_LT(0.0f,
+                              glm::dot(vertexNormals[i], vertices[i] - vec3(0.35f, 0.4f, 0.45f)));
+                }
+            }
+        }
+        auto coarse = MarchingTetrahedra::extractAdaptive(blob, {0.9f}, colors, 0.016f);
+        EXPECT_GT(fullTriangles / 4, coarse->getIndices(0)->getSize() / 3);
+
+        // a linear ramp is trilinear everywhere, so it collapses to a few large leaves
+        auto ramp = std::make_shared<Volume>(size3_t(33), DataFloat32::get());
+        auto rampData =
+            static_cast<float *>(ramp->getEditableRepresentation<VolumeRAM>()->getData());
+        util::IndexMapper3D rampIndex(size3_t(33));
+        for (size_t z = 0; z < 33; ++z) {
+            for (size_t y = 0; y < 33; ++y) {
+                for (size_t x = 0; x < 33; ++x) {
+                    rampData[rampIndex(size3_t(x, y, z))] = static_cast<float>(x + y + z);
+                }
+            }
+        }
+        IsoOctree octree(*ramp->getRepresentation<VolumeRAM>(), 40.5f, 0.0f);
+        EXPECT_GT(100u, octree.getLeafCount());
+        EXPECT_LT(0u, MarchingTetrahedra::extractAdaptive(ramp, {40.5f}, colors, 0.0f)
+                          ->getIndices(0)
+                          ->getSize());
+    }
+
+    TEST(MarchingTetrahedraTest, mortonTraversal) {
+        using Normals = MarchingTetrahedra::Normals;
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Method = MarchingTetrahedra::Method;
+        using Traversal = MarchingTetrahedra::Traversal;
+        const std::vector<float> isos = {0.3f, 0.8f};
+        const std::vector<vec4> colors = {vec4(1.0f), vec4(0.5f)};
+
+        // wider than a few tiles and not a multiple of them
+        auto volume = createTestVolume(size3_t(45, 38, 21));
+        MinMaxBricks bricks(*volume->getRepresentation<VolumeRAM>());
+        for (auto method : {Method::Tetrahedra, Method::Cubes}) {
+            auto linear = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr,
+                                                      Normals::FaceAccumulated,
+                                                      Allocation::Incremental, method);
+            const auto expected = sortedTriangles(*linear);
+            ASSERT_LT(0u, expected[0].size());
+            for (size_t threads : {1, 3}) {
+                for (const MinMaxBricks *skip : {static_cast<const MinMaxBricks *>(nullptr),
+                                                 static_cast<const MinMaxBricks *>(&bricks)}) {
+                    auto morton = MarchingTetrahedra::extract(
+                        volume, isos, colors, threads, skip, Normals::FaceAccumulated,
+                        Allocation::CountThenFill, method, Traversal::Morton);
+                    EXPECT_EQ(linear->getVertices()->getSize(), morton->getVertices()->getSize());
+                    EXPECT_TRUE(expected == sortedTriangles(*morton));
+                }
+            }
+        }
+    }
+
+    // Run with --gtest_also_run_disabled_tests to compare the traversals on larger volumes. The
+    // 1024^3 volume, where a plane of edges no longer fits in the caches, takes 1 GB of voxels
+    // and about as much again for the mesh.
+    TEST(MarchingTetrahedraTest, DISABLED_traversalBenchmark) {
+        using Normals = MarchingTetrahedra::Normals;
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Method = MarchingTetrahedra::Method;
+        using Traversal = MarchingTetrahedra::Traversal;
+        const std::vector<vec4> colors = {vec4(1.0f)};
+
+        for (size_t size : {128, 256, 512, 1024}) {
+            const size3_t dims(size);
+            auto volume = std::make_shared<Volume>(dims, DataUInt8::get());
+            auto data = static_cast<unsigned char *>(
+                volume->getEditableRepresentation<VolumeRAM>()->getData());
+            util::IndexMapper3D index(dims);
+            size3_t pos;
+            for (pos.z = 0; pos.z < dims.z; ++pos.z) {
+                for (pos.y = 0; pos.y < dims.y; ++pos.y) {
+                    for (pos.x = 0; pos.x < dims.x; ++pos.x) {
+                        const vec3 p = vec3(pos) / vec3(dims - size3_t(1)) * 12.0f;
+                        data[index(pos)] = static_cast<unsigned char>(
+                            127.5f + 127.5f * std::sin(p.x) * std::sin(p.y) * std::sin(p.z));
+                    }
+                }
+            }
+            volume->dataMap_.dataRange = volume->dataMap_.valueRange = dvec2(0.0, 255.0);
+
+            for (auto traversal : {Traversal::Linear, Traversal::Morton}) {
+                const auto start = std::chrono::steady_clock::now();
+                auto mesh = MarchingTetrahedra::extract(volume, {128.0f}, colors, 1, nullptr,
+                                                        Normals::FaceAccumulated,
+                                                        Allocation::CountThenFill,
+                                                        Method::Tetrahedra, traversal);
+                const std::chrono::duration<double, std::milli> time =
+                    std::chrono::steady_clock::now() - start;
+                std::cout << size << "^3 "
+                          << (traversal == Traversal::Linear ? "linear" : "morton") << ": "
+                          << time.count() << " ms, " << mesh->getIndices(0)->getSize() / 3
+                          << " triangles" << std::endl;
+            }
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, meshletMesh) {
+        using Normals = MarchingTetrahedra::Normals;
+        const std::vector<float> isos = {0.3f, 0.8f};
+        const std::vector<vec4> colors = {vec4(1.0f, 0.0f, 0.0f, 1.0f), vec4(0.5f)};
+        const size3_t dims(33, 20, 41);
+        auto volume = createTestVolume(dims);
+        auto mesh = MarchingTetrahedra::extract(volume, isos, colors, 2, nullptr,
+                                                Normals::Gradient);
+        const auto &vertices = mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &normals = mesh->getNormals()->getRAMRepresentation()->getDataContainer();
+
+        for (size_t meshletVertices : {size_t(300), MeshletMesh::maxVertices}) {
+            for (auto grid : {size3_t(0), dims}) {
+                MeshletMesh meshlets(*mesh, grid, meshletVertices);
+                EXPECT_EQ(grid != size3_t(0), meshlets.isQuantized());
+                // less than half the size, unless split into small meshlets sharing vertices
+                if (meshletVertices == MeshletMesh::maxVertices) {
+                    EXPECT_LT(2 * meshlets.getSizeInBytes(), MeshletMesh::getSizeInBytes(*mesh));
+                }
+                ASSERT_EQ(isos.size(), meshlets.getNumberOfLayers());
+                EXPECT_EQ(colors[0], meshlets.getLayerColor(0));
+                EXPECT_EQ(colors[1], meshlets.getLayerColor(1));
+                if (meshletVertices < vertices.size()) {
+                    EXPECT_LT(isos.size(), meshlets.getMeshlets().size());
+                }
+                for (const auto &meshlet : meshlets.getMeshlets()) {
+                    EXPECT_GE(meshletVertices, meshlet.vertexCount);
+                    for (size_t i = 0; i < meshlet.indexCount; ++i) {
+                        EXPECT_GT(meshlet.vertexCount,
+                                  meshlets.getIndices()[meshlet.firstIndex + i]);
+                    }
+                }
+
+                // the same triangles in the same order, exact unless quantized
+                const float tolerance = grid != size3_t(0) ? 1e-5f : 0.0f;
+                auto expanded = meshlets.toBasicMesh();
+                const auto &ev =
+                    expanded->getVertices()->getRAMRepresentation()->getDataContainer();
+                const auto &en =
+                    expanded->getNormals()->getRAMRepresentation()->getDataContainer();
+                ASSERT_EQ(mesh->getNumberOfIndicies(), expanded->getNumberOfIndicies());
+                for (size_t b = 0; b < mesh->getNumberOfIndicies(); ++b) {
+                    const auto &indices =
+                        mesh->getIndices(b)->getRAMRepresentation()->getDataContainer();
+                    const auto &ei =
+                        expanded->getIndices(b)->getRAMRepresentation()->getDataContainer();
+                    ASSERT_EQ(indices.size(), ei.size());
+                    for (size_t i = 0; i < indices.size(); ++i) {
+                        const vec3 diff = glm::abs(vertices[indices[i]] - ev[ei[i]]);
+                        EXPECT_GE(tolerance, std::max(diff.x, std::max(diff.y, diff.z)));
+                        EXPECT_EQ(normals[indices[i]], en[ei[i]]);
+                    }
+                }
+            }
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, temporalMesh) {
+        using Normals = MarchingTetrahedra::Normals;
+        using Method = MarchingTetrahedra::Method;
+        const std::vector<float> isos = {0.3f, 0.8f};
+        const std::vector<vec4> colors = {vec4(1.0f), vec4(0.5f)};
+        const size3_t dims(27, 22, 31);
+        const size_t cells = 26 * 21 * 30;
+
+        // the same triangles as extracting the volume from scratch, normals up to rounding
+        auto expectSameSurface = [&](std::shared_ptr<Volume> volume, const BasicMesh &mesh,
+                                     Normals normals, Method method) {
+            auto expected = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr, normals,
+                                                        MarchingTetrahedra::Allocation::Incremental,
+                                                        method);
+            EXPECT_EQ(expected->getVertices()->getSize(), mesh.getVertices()->getSize());
+            EXPECT_TRUE(sortedTriangles(*expected) == sortedTriangles(mesh));
+
+            std::map<std::array<float, 3>, vec3> expectedNormals;
+            const auto &ev = expected->getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &en = expected->getNormals()->getRAMRepresentation()->getDataContainer();
+            for (size_t i = 0; i < ev.size(); ++i) {
+                expectedNormals[{{ev[i].x, ev[i].y, ev[i].z}}] = en[i];
+            }
+            const auto &rv = mesh.getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &rn = mesh.getNormals()->getRAMRepresentation()->getDataContainer();
+            for (size_t i = 0; i < rv.size(); ++i) {
+                const auto it = expectedNormals.find({{rv[i].x, rv[i].y, rv[i].z}});
+                ASSERT_TRUE(it != expectedNormals.end());
+                EXPECT_GT(1e-4f, glm::length(it->second - rn[i]));
+            }
+        };
+
+        for (auto normals : {Normals::FaceAccumulated, Normals::Gradient}) {
+            for (auto method : {Method::Tetrahedra, Method::Cubes}) {
+                MarchingTetrahedra::TemporalMesh temporal;
+                auto volume = createTestVolume(dims);
+                EXPECT_EQ(cells, temporal.update(volume, isos, colors, normals, method));
+                expectSameSurface(volume, *temporal.getMesh(), normals, method);
+                EXPECT_EQ(0u, temporal.update(volume, isos, colors, normals, method));
+
+                // a small bump on the surface of the larger blob
+                auto changed = createTestVolume(dims);
+                auto data = static_cast<float *>(
+                    changed->getEditableRepresentation<VolumeRAM>()->getData());
+                util::IndexMapper3D index(dims);
+                size3_t pos;
+                for (pos.z = 12; pos.z < 15; ++pos.z) {
+                    for (pos.y = 7; pos.y < 10; ++pos.y) {
+                        for (pos.x = 4; pos.x < 7; ++pos.x) data[index(pos)] *= 1.3f;
+                    }
+                }
+                const size_t extracted = temporal.update(changed, isos, colors, normals, method);
+                EXPECT_LT(0u, extracted);
+                EXPECT_GT(cells / 20, extracted);
+                expectSameSurface(changed, *temporal.getMesh(), normals, method);
+
+                // and back again
+                EXPECT_EQ(extracted, temporal.update(volume, isos, colors, normals, method));
+                expectSameSurface(volume, *temporal.getMesh(), normals, method);
+
+                // other iso values change every cell
+                EXPECT_EQ(cells, temporal.update(volume, {0.5f, 0.8f}, colors, normals, method));
+            }
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, meshCache) {
+        auto volume = createTestVolume(size3_t(21, 18, 25));
+        const std::vector<float> isos = {0.3f, 0.8f};
+        const std::vector<vec4> colors = {vec4(1.0f, 0.0f, 0.0f, 1.0f), vec4(0.5f)};
+        auto mesh = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr,
+                                                MarchingTetrahedra::Normals::Gradient);
+        const TempPath cacheDirectory("marchingtetrahedra-test-cache");
+        const std::string &directory = cacheDirectory.path;
+
+        size_t size = 0;
+        {
+            MeshCache cache(directory, size_t{1} << 30);
+            cache.clear();
+            EXPECT_TRUE(cache.find(42) == nullptr);
+            cache.insert(42, *mesh);
+            auto found = cache.find(42);
+            ASSERT_TRUE(found != nullptr);
+            expectSameMesh(*mesh, *found);
+            EXPECT_EQ(mesh->getModelMatrix(), found->getModelMatrix());
+            EXPECT_EQ(1u, cache.getHits());
+            EXPECT_EQ(1u, cache.getMisses());
+            size = cache.getSizeInBytes();
+            EXPECT_LT(0u, size);
+        }
+
+        // kept between sessions, and the least recently used mesh is evicted first
+        MeshCache cache(directory, 5 * size / 2);
+        ASSERT_EQ(1u, cache.getEntryCount());
+        ASSERT_TRUE(cache.find(42) != nullptr);
+        cache.insert(7, *mesh);
+        ASSERT_TRUE(cache.find(42) != nullptr);
+        cache.insert(9, *mesh);
+        EXPECT_EQ(2u, cache.getEntryCount());
+        EXPECT_TRUE(cache.find(7) == nullptr);
+        EXPECT_TRUE(cache.find(42) != nullptr);
+        EXPECT_TRUE(cache.find(9) != nullptr);
+        EXPECT_EQ(4u, cache.getHits());
+        EXPECT_EQ(1u, cache.getMisses());
+
+        // too large for the cache
+        cache.setMaxBytes(size / 2);
+        EXPECT_EQ(0u, cache.getEntryCount());
+        cache.insert(42, *mesh);
+        EXPECT_TRUE(cache.find(42) == nullptr);
+        cache.clear();
+
+        // a hit only reorders the index in memory, it is written when the cache is destroyed
+        auto firstIndexKey = [&]() {
+            std::ifstream index(directory + "/index");
+            std::uint64_t key = 0;
+            index >> std::hex >> key;
+            return key;
+        };
+        {
+            MeshCache reordered(directory, size_t{1} << 30);
+            reordered.insert(1, *mesh);
+            reordered.insert(2, *mesh);
+            EXPECT_EQ(2u, firstIndexKey());
+            ASSERT_TRUE(reordered.find(1) != nullptr);
+            EXPECT_EQ(2u, firstIndexKey());
+        }
+        EXPECT_EQ(1u, firstIndexKey());
+
+        // a corrupt file is a miss and is dropped
+        auto file = [&](std::uint64_t key) {
+            std::ostringstream name;
+            name << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key
+                 << ".mesh";
+            return name.str();
+        };
+        {
+            MeshCache corrupt(directory, size_t{1} << 30);
+            corrupt.insert(3, *mesh);
+            auto read = [&](std::uint64_t key) {
+                std::ifstream in(file(key), std::ios::binary);
+                return std::vector<char>((std::istreambuf_iterator<char>(in)),
+                                         std::istreambuf_iterator<char>());
+            };
+            // a valid header with an absurd layer count, garbage, and a truncated file
+            auto bytes = read(1);
+            ASSERT_LT(32u, bytes.size());
+            const std::uint64_t layers = std::uint64_t{1} << 62;
+            std::memcpy(bytes.data() + 24, &layers, sizeof(layers));
+            std::ofstream(file(1), std::ios::binary).write(bytes.data(), bytes.size());
+            std::ofstream(file(2), std::ios::binary) << "not a mesh";
+            bytes = read(3);
+            std::ofstream(file(3), std::ios::binary).write(bytes.data(), bytes.size() / 2);
+
+            const size_t misses = corrupt.getMisses();
+            for (std::uint64_t key : {1, 2, 3}) EXPECT_TRUE(corrupt.find(key) == nullptr);
+            EXPECT_EQ(misses + 3, corrupt.getMisses());
+            EXPECT_EQ(0u, corrupt.getEntryCount());
+            EXPECT_EQ(0u, corrupt.getSizeInBytes());
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, skipEmptyBricks) {
+        auto volume = createTestVolume(size3_t(33, 20, 41));
+        MinMaxBricks bricks(*volume->getRepresentation<VolumeRAM>());
+        EXPECT_EQ(size3_t(4, 3, 5), bricks.getDimensions());
+
+        for (float iso : {0.1f, 0.5f, 0.9f}) {
+            EXPECT_LT(0.0f, bricks.getSkippedFraction(iso));
+            EXPECT_GT(1.0f, bricks.getSkippedFraction(iso));
+            for (size_t threads : {1, 3}) {
+                expectSameMesh(*MarchingTetrahedra::extract(volume, iso, threads),
+                               *MarchingTetrahedra::extract(volume, iso, threads, &bricks));
+            }
+        }
+        EXPECT_EQ(1.0f, bricks.getSkippedFraction(2.0f));
+    }
+
+    TEST(MarchingTetrahedraTest, spanSpaceIndex) {
+        auto volume = createTestVolume(size3_t(33, 20, 41));
+        SpanSpaceIndex index(*volume->getRepresentation<VolumeRAM>());
+        EXPECT_EQ(32u * 19u * 40u, index.size());
+
+        for (float iso : {0.0f, 0.1f, 0.5f, 0.9f, 2.0f}) {
+            for (size_t threads : {1, 3}) {
+                expectSameMesh(*MarchingTetrahedra::extract(volume, iso, threads),
+                               *MarchingTetrahedra::extract(volume, iso, index, threads));
+            }
+        }
+        EXPECT_TRUE(index.query(2.0f).empty());
+        EXPECT_LE(index.getSizeInBytes(), SpanSpaceIndex::maxSizeInBytes(volume->getDimensions()));
+
+        // the positions are the same for any traversal
+        const std::vector<float> isos = {0.3f, 0.6f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1)};
+        for (size_t threads : {1, 3}) {
+            EXPECT_EQ(sortedTriangles(*MarchingTetrahedra::extract(volume, isos, colors, index,
+                                                                   threads)),
+                      sortedTriangles(*MarchingTetrahedra::extract(
+                          volume, isos, colors, index, threads,
+                          MarchingTetrahedra::Normals::FaceAccumulated,
+                          MarchingTetrahedra::Allocation::CountThenFill,
+                          MarchingTetrahedra::Method::Tetrahedra,
+                          MarchingTetrahedra::Traversal::Morton)));
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, clipBox) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Method = MarchingTetrahedra::Method;
+        using Normals = MarchingTetrahedra::Normals;
+        using Traversal = MarchingTetrahedra::Traversal;
+
+        auto volume = createTestVolume(size3_t(33, 20, 41));
+        const auto dims = volume->getDimensions();
+        const auto ram = volume->getRepresentation<VolumeRAM>();
+        const std::vector<float> isos = {0.3f, 0.6f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1)};
+        SpanSpaceIndex index(*ram);
+        MinMaxBricks bricks(*ram);
+
+        // the same mesh as extracting the cells of the box one by one
+        const MarchingTetrahedra::CellBox box{size3_t(5, 3, 7), size3_t(27, 16, 30)};
+        util::IndexMapper3D indexMapper(dims);
+        std::vector<std::uint32_t> cells;
+        size3_t pos;
+        for (pos.z = box.begin.z; pos.z < box.end.z; ++pos.z) {
+            for (pos.y = box.begin.y; pos.y < box.end.y; ++pos.y) {
+                for (pos.x = box.begin.x; pos.x < box.end.x; ++pos.x) {
+                    cells.push_back(static_cast<std::uint32_t>(indexMapper(pos)));
+                }
+            }
+        }
+        std::vector<MarchingTetrahedra::MeshHelper> layers;
+        for (const auto &color : colors) {
+            layers.emplace_back(volume, color, Normals::FaceAccumulated);
+        }
+        MarchingTetrahedra::extractCells(*ram, isos, cells.data(), cells.data() + cells.size(),
+                                         layers);
+        auto expected = MarchingTetrahedra::MeshHelper::toBasicMesh(layers);
+        EXPECT_LT(0u, expected->getVertices()->getSize());
+
+        for (auto allocation : {Allocation::Incremental, Allocation::CountThenFill}) {
+            for (size_t threads : {1, 3}) {
+                for (const MinMaxBricks *b : {static_cast<const MinMaxBricks *>(nullptr),
+                                              static_cast<const MinMaxBricks *>(&bricks)}) {
+                    expectSameMesh(*expected,
+                                   *MarchingTetrahedra::extract(
+                                       volume, isos, colors, threads, b, Normals::FaceAccumulated,
+                                       allocation, Method::Tetrahedra, Traversal::Linear, &box));
+                }
+                expectSameMesh(*expected,
+                               *MarchingTetrahedra::extract(volume, isos, colors, index, threads,
+                                                            Normals::FaceAccumulated, allocation,
+                                                            Method::Tetrahedra, Traversal::Linear,
+                                                            &box));
+            }
+        }
+        // the positions are the same for any traversal
+        EXPECT_EQ(sortedTriangles(*expected),
+                  sortedTriangles(*MarchingTetrahedra::extract(
+                      volume, isos, colors, 3, &bricks, Normals::FaceAccumulated,
+                      Allocation::CountThenFill, Method::Tetrahedra, Traversal::Morton, &box)));
+
+        // a box covering the whole volume, or beyond it, clips nothing
+        const MarchingTetrahedra::CellBox whole{size3_t(0), dims + size3_t(4)};
+        for (size_t threads : {1, 3}) {
+            expectSameMesh(*MarchingTetrahedra::extract(volume, isos, colors, threads),
+                           *MarchingTetrahedra::extract(
+                               volume, isos, colors, threads, nullptr, Normals::FaceAccumulated,
+                               Allocation::CountThenFill, Method::Tetrahedra, Traversal::Linear,
+                               &whole));
+        }
+
+        // an empty box gives an empty mesh
+        const MarchingTetrahedra::CellBox empty{size3_t(10), size3_t(10, 10, 20)};
+        auto none = MarchingTetrahedra::extract(volume, isos, colors, 3, nullptr,
+                                                Normals::FaceAccumulated,
+                                                Allocation::CountThenFill, Method::Tetrahedra,
+                                                Traversal::Linear, &empty);
+        EXPECT_EQ(0u, none->getVertices()->getSize());
+    }
+
+    TEST(MarchingTetrahedraTest, progressivePreview) {
+        using Allocation = MarchingTetrahedra::Allocation;
+        using Method = MarchingTetrahedra::Method;
+        using Normals = MarchingTetrahedra::Normals;
+        using Traversal = MarchingTetrahedra::Traversal;
+
+        auto volume = createTestVolume(size3_t(33, 20, 41));
+        const auto ram = volume->getRepresentation<VolumeRAM>();
+        const std::vector<float> isos = {0.3f, 0.6f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1)};
+        SpanSpaceIndex index(*ram);
+        MinMaxBricks bricks(*ram);
+
+        // every second voxel, the last one along y is dropped
+        auto coarse = MarchingTetrahedra::subsample(*volume, 2);
+        EXPECT_EQ(size3_t(17, 10, 21), coarse->getDimensions());
+        const auto fine = static_cast<const float *>(ram->getData());
+        const auto sub =
+            static_cast<const float *>(coarse->getRepresentation<VolumeRAM>()->getData());
+        util::IndexMapper3D fineIndex(volume->getDimensions());
+        util::IndexMapper3D coarseIndex(coarse->getDimensions());
+        EXPECT_EQ(fine[fineIndex(size3_t(6, 4, 10))], sub[coarseIndex(size3_t(3, 2, 5))]);
+        EXPECT_EQ(fine[fineIndex(size3_t(32, 18, 40))], sub[coarseIndex(size3_t(16, 9, 20))]);
+        EXPECT_EQ(glm::scale(volume->getModelMatrix(), vec3(1.0f, 18.0f / 19.0f, 1.0f)),
+                  coarse->getModelMatrix());
+        auto preview = MarchingTetrahedra::extract(coarse, isos, colors, 2);
+        EXPECT_LT(0u, preview->getVertices()->getSize());
+        EXPECT_EQ(size3_t(9, 5, 11), MarchingTetrahedra::subsample(*volume, 4)->getDimensions());
+
+        // extracting a plane at a time to be able to cancel gives the same mesh
+        const std::atomic<bool> running(false);
+        const std::atomic<bool> cancelled(true);
+        for (auto allocation :
+             {Allocation::Incremental, Allocation::CountThenFill, Allocation::Shared}) {
+            for (size_t threads : {1, 3}) {
+                expectSameMesh(
+                    *MarchingTetrahedra::extract(volume, isos, colors, threads, &bricks,
+                                                 Normals::FaceAccumulated, allocation),
+                    *MarchingTetrahedra::extract(volume, isos, colors, threads, &bricks,
+                                                 Normals::FaceAccumulated, allocation,
+                                                 Method::Tetrahedra, Traversal::Linear, nullptr,
+                                                 &running));
+                expectSameMesh(
+                    *MarchingTetrahedra::extract(volume, isos, colors, index, threads,
+                                                 Normals::FaceAccumulated, allocation),
+                    *MarchingTetrahedra::extract(volume, isos, colors, index, threads,
+                                                 Normals::FaceAccumulated, allocation,
+                                                 Method::Tetrahedra, Traversal::Linear, nullptr,
+                                                 &running));
+
+                EXPECT_TRUE(MarchingTetrahedra::extract(volume, isos, colors, threads, nullptr,
+                                                        Normals::FaceAccumulated, allocation,
+                                                        Method::Tetrahedra, Traversal::Linear,
+                                                        nullptr, &cancelled) == nullptr);
+                EXPECT_TRUE(MarchingTetrahedra::extract(volume, isos, colors, index, threads,
+                                                        Normals::FaceAccumulated, allocation,
+                                                        Method::Tetrahedra, Traversal::Linear,
+                                                        nullptr, &cancelled) == nullptr);
+            }
+        }
+    }
+
+    TEST(MarchingTetrahedraTest, isoClassifier) {
+        using InstructionSet = IsoClassifier::InstructionSet;
+        const auto initial = IsoClassifier::getInstructionSet();
+        EXPECT_TRUE(IsoClassifier::isSupported(InstructionSet::Scalar));
+
+        std::mt19937 rand(7);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (size_t count : {1, 7, 63, 64, 65, 200}) {
+            std::vector<float> values(count);
+            for (auto &value : values) value = dist(rand) < 0.1f ? 0.5f : dist(rand);
+
+            for (auto set : {InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX}) {
+                if (!IsoClassifier::isSupported(set)) continue;
+                IsoClassifier::setInstructionSet(set);
+                std::vector<std::uint64_t> below(IsoClassifier::words(count), ~std::uint64_t{0});
+                IsoClassifier::classify(values.data(), count, 0.5f, below.data());
+                for (size_t i = 0; i < 64 * below.size(); ++i) {
+                    const bool expected = i < count && values[i] < 0.5f;
+                    EXPECT_EQ(expected, ((below[i / 64] >> (i % 64)) & 1) != 0);
+                }
+            }
+        }
+
+        // rows longer than a word, which the classification splits up
+        auto volume = createTestVolume(size3_t(150, 9, 7));
+        IsoClassifier::setInstructionSet(InstructionSet::Scalar);
+        auto expected = MarchingTetrahedra::extract(volume, 0.5f, 2);
+        for (auto set : {InstructionSet::SSE2, InstructionSet::AVX}) {
+            if (!IsoClassifier::isSupported(set)) continue;
+            IsoClassifier::setInstructionSet(set);
+            expectSameMesh(*expected, *MarchingTetrahedra::extract(volume, 0.5f, 2));
+        }
+        IsoClassifier::setInstructionSet(initial);
+    }
+
+    TEST(MarchingTetrahedraTest, brickedMesh) {
+        const std::vector<vec4> colors = {vec4(0.7f, 0.7f, 0.7f, 1.0f)};
+        auto volume = createTestVolume(size3_t(40, 35, 30));
+        auto triangleCount = [](const std::vector<MarchingTetrahedra::BrickedMesh::Brick> &bricks) {
+            size_t triangles = 0;
+            for (const auto &brick : bricks) {
+                if (brick.mesh) triangles += brick.mesh->getIndices(0)->getSize() / 3;
+            }
+            return triangles;
+        };
+
+        MarchingTetrahedra::BrickedMesh bricked(16);
+        const size_t extracted = bricked.update(volume, {0.5f}, colors, 3);
+        EXPECT_EQ(3u * 3u * 2u, bricked.getBricks().size());
+        EXPECT_LT(0u, extracted);
+        EXPECT_EQ(bricked.getMeshes()->size(), extracted);
+        EXPECT_EQ(MarchingTetrahedra::extract(volume, 0.5f)->getIndices(0)->getSize() / 3,
+                  triangleCount(bricked.getBricks()));
+        for (const auto &brick : bricked.getBricks()) {
+            if (!brick.mesh) continue;
+            const auto &vertices =
+                brick.mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+            for (const auto &v : vertices) {
+                EXPECT_TRUE(glm::all(glm::greaterThanEqual(v, brick.lower)));
+                EXPECT_TRUE(glm::all(glm::lessThanEqual(v, brick.upper)));
+            }
+        }
+
+        // the vertices on the faces between bricks get the same normal in both
+        std::map<std::array<float, 3>, vec3> normals;
+        size_t shared = 0;
+        for (const auto &brick : bricked.getBricks()) {
+            if (!brick.mesh) continue;
+            const auto &vertices =
+                brick.mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &vertexNormals =
+                brick.mesh->getNormals()->getRAMRepresentation()->getDataContainer();
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                const std::array<float, 3> pos = {vertices[i].x, vertices[i].y, vertices[i].z};
+                const auto inserted = normals.emplace(pos, vertexNormals[i]);
+                if (!inserted.second) {
+                    ++shared;
+                    EXPECT_TRUE(inserted.first->second == vertexNormals[i]);
+                }
+            }
+        }
+        EXPECT_LT(0u, shared);
+
+        // nothing changed
+        EXPECT_EQ(0u, bricked.update(volume, {0.5f}, colors, 3));
+
+        // a voxel on the surface in the first brick only changes that one
+        auto data = static_cast<float *>(volume->getEditableRepresentation<VolumeRAM>()->getData());
+        util::IndexMapper3D index(volume->getDimensions());
+        size3_t voxel(0);
+        for (voxel.x = 1; voxel.x < 15; ++voxel.x) {
+            if (std::abs(data[index(size3_t(voxel.x, 8, 8))] - 0.5f) < 0.1f) break;
+        }
+        ASSERT_GT(15u, voxel.x);
+        data[index(size3_t(voxel.x, 8, 8))] += 0.05f;
+        EXPECT_EQ(1u, bricked.update(volume, {0.5f}, colors, 3));
+
+        // a new iso value only extracts the bricks either surface passes through
+        const size_t changed = bricked.update(volume, {0.55f}, colors, 3);
+        EXPECT_LT(0u, changed);
+        EXPECT_GT(bricked.getBricks().size(), changed);
+        EXPECT_EQ(MarchingTetrahedra::extract(volume, 0.55f)->getIndices(0)->getSize() / 3,
+                  triangleCount(bricked.getBricks()));
+    }
+
+    TEST(MarchingTetrahedraTest, multipleIsoValues) {
+        auto volume = createTestVolume(size3_t(21, 18, 25));
+        const std::vector<float> isos = {0.3f, 0.6f, 0.9f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 1, 0, 1), vec4(0, 0, 1, 1)};
+        SpanSpaceIndex index(*volume->getRepresentation<VolumeRAM>());
+        MinMaxBricks bricks(*volume->getRepresentation<VolumeRAM>());
+
+        auto mesh = MarchingTetrahedra::extract(volume, isos, colors, 3);
+        expectSameMesh(*mesh, *MarchingTetrahedra::extract(volume, isos, colors, index, 2));
+        expectSameMesh(*mesh, *MarchingTetrahedra::extract(volume, isos, colors, 1, &bricks));
+        ASSERT_EQ(isos.size(), mesh->getNumberOfIndicies());
+
+        // each layer is the surface of its iso value on its own
+        const auto &vertices = mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &normals = mesh->getNormals()->getRAMRepresentation()->getDataContainer();
+        const auto &meshColors = mesh->getColors()->getRAMRepresentation()->getDataContainer();
+        size_t offset = 0;
+        for (size_t layer = 0; layer < isos.size(); ++layer) {
+            auto single = MarchingTetrahedra::extract(volume, isos[layer]);
+            const auto &sv = single->getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &sn = single->getNormals()->getRAMRepresentation()->getDataContainer();
+            for (size_t i = 0; i < sv.size(); ++i) {
+                EXPECT_EQ(sv[i], vertices[offset + i]);
+                EXPECT_EQ(sn[i], normals[offset + i]);
+                EXPECT_EQ(colors[layer], meshColors[offset + i]);
+            }
+
+            const auto &si = single->getIndices(0)->getRAMRepresentation()->getDataContainer();
+            const auto &li = mesh->getIndices(layer)->getRAMRepresentation()->getDataContainer();
+            ASSERT_EQ(si.size(), li.size());
+            for (size_t i = 0; i < si.size(); ++i) {
+                EXPECT_EQ(si[i] + offset, li[i]);
+            }
+            offset += sv.size();
+        }
+        EXPECT_EQ(offset, vertices.size());
+    }
+
+    TEST(MarchingTetrahedraTest, streamRawFile) {
+        auto volume = createTestVolume(size3_t(23, 17, 19));
+        const auto dims = volume->getDimensions();
+        const auto ram = volume->getRepresentation<VolumeRAM>();
+        const auto data = static_cast<const float *>(ram->getData());
+        const std::vector<float> isos = {0.3f, 0.6f};
+        const std::vector<vec4> colors = {vec4(1, 0, 0, 1), vec4(0, 0, 1, 1)};
+
+        const TempPath rawFile("marchingtetrahedra-test.raw");
+        const std::string &file = rawFile.path;
+        const size_t header = 64;
+        {
+            std::ofstream out(file, std::ios::binary);
+            out.write(std::string(header, '\0').data(), header);
+            out.write(reinterpret_cast<const char *>(data),
+                      dims.x * dims.y * dims.z * sizeof(float));
+        }
+
+        auto streamed = MarchingTetrahedra::extractRaw(file, dims, DataFormatId::Float32, header,
+                                                       isos, colors, volume->getModelMatrix(),
+                                                       volume->getWorldMatrix());
+        expectSameMesh(*MarchingTetrahedra::extract(volume, isos, colors), *streamed);
+
+        const auto gradient = MarchingTetrahedra::Normals::Gradient;
+        expectSameMesh(
+            *MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr, gradient),
+            *MarchingTetrahedra::extractRaw(file, dims, DataFormatId::Float32, header, isos, colors,
+                                            volume->getModelMatrix(), volume->getWorldMatrix(),
+                                            gradient));
+
+        EXPECT_THROW(MarchingTetrahedra::extractRaw(file, dims + size3_t(0, 0, 1),
+                                                    DataFormatId::Float32, header, isos, colors),
+                     Exception);
+    }
+
+    TEST(MarchingTetrahedraTest, gradientNormals) {
+        auto volume = createTestVolume(size3_t(24, 19, 21));
+        const std::vector<float> isos = {0.9f};
+        const std::vector<vec4> colors = {vec4(1.0f)};
+        const auto gradient = MarchingTetrahedra::Normals::Gradient;
+
+        auto face = MarchingTetrahedra::extract(volume, isos, colors);
+        auto mesh = MarchingTetrahedra::extract(volume, isos, colors, 1, nullptr, gradient);
+        for (size_t threads : {2, 5}) {
+            expectSameMesh(*mesh, *MarchingTetrahedra::extract(volume, isos, colors, threads,
+                                                               nullptr, gradient));
+        }
+
+        // same surface, only the normals differ
+        const auto &fv = face->getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &vertices = mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+        const auto &fn = face->getNormals()->getRAMRepresentation()->getDataContainer();
+        const auto &normals = mesh->getNormals()->getRAMRepresentation()->getDataContainer();
+        ASSERT_EQ(fv.size(), vertices.size());
+        ASSERT_LT(0u, vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            EXPECT_EQ(fv[i], vertices[i]);
+            EXPECT_NEAR(1.0f, glm::length(normals[i]), 1e-5f);
+            EXPECT_LT(0.5f, glm::dot(fn[i], normals[i]));
+            EXPECT_LT(0.0f, glm::dot(normals[i], vertices[i] - vec3(0.35f, 0.4f, 0.45f)));
+        }
+    }
+
+}
@@ -0,0 +1,163 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+
+#include <modules/tnm067lab2/processors/marchingtetrahedra.h>
+#include <modules/tnm067lab2/processors/meshsimplification.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/util/indexmapper.h>
+
+#include <map>
+#include <set>
+
+namespace inviwo {
+
+    // distance to center, the iso-surface at radius is a sphere
+    static std::shared_ptr<Volume> createSphereVolume(size3_t dims, vec3 center) {
+        auto volume = std::make_shared<Volume>(dims, DataFloat32::get());
+        auto data = static_cast<float *>(volume->getEditableRepresentation<VolumeRAM>()->getData());
+        util::IndexMapper3D index(dims);
+        size3_t pos;
+        for (pos.z = 0; pos.z < dims.z; ++pos.z) {
+            for (pos.y = 0; pos.y < dims.y; ++pos.y) {
+                for (pos.x = 0; pos.x < dims.x; ++pos.x) {
+                    const vec3 p = vec3(pos) / vec3(dims - size3_t(1));
+                    data[index(pos)] = glm::length(p - center);
+                }
+            }
+        }
+        volume->dataMap_.dataRange = volume->dataMap_.valueRange = dvec2(0.0, 1.8);
+        return volume;
+    }
+
+    // number of times each directed edge is used
+    static std::map<std::pair<std::uint32_t, std::uint32_t>, size_t> directedEdges(
+        const std::vector<std::uint32_t> &indices) {
+        std::map<std::pair<std::uint32_t, std::uint32_t>, size_t> edges;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (size_t j = 0; j < 3; ++j) {
+                ++edges[std::make_pair(indices[i + j], indices[i + (j + 1) % 3])];
+            }
+        }
+        return edges;
+    }
+
+    TEST(MeshSimplificationTest, closedSurface) {
+        const vec3 center(0.5f, 0.45f, 0.55f);
+        auto mesh = MarchingTetrahedra::extract(createSphereVolume(size3_t(48), center), 0.35f);
+        const size_t triangles = mesh->getIndices(0)->getSize() / 3;
+        const size_t target = triangles / 10;
+
+        for (size_t threads : {1, 4}) {
+            auto result = MeshSimplification::simplify(*mesh, target, threads);
+            const auto &vertices =
+                result->getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &normals =
+                result->getNormals()->getRAMRepresentation()->getDataContainer();
+            const auto &indices =
+                result->getIndices(0)->getRAMRepresentation()->getDataContainer();
+            ASSERT_EQ(1u, result->getNumberOfIndicies());
+            EXPECT_GE(target, indices.size() / 3);
+            EXPECT_LT(target / 2, indices.size() / 3);
+
+            // still closed and manifold, with every edge used once in each direction
+            const auto edges = directedEdges(indices);
+            for (const auto &edge : edges) {
+                EXPECT_EQ(1u, edge.second);
+                EXPECT_EQ(1u, edges.count(std::make_pair(edge.first.second, edge.first.first)));
+            }
+
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                EXPECT_NEAR(0.35f, glm::length(vertices[i] - center), 0.01f);
+                EXPECT_NEAR(1.0f, glm::length(normals[i]), 0.001f);
+                // towards lower values, i.e. the center
+                EXPECT_GT(0.0f, glm::dot(normals[i], vertices[i] - center));
+            }
+        }
+    }
+
+    TEST(MeshSimplificationTest, keepsBoundaryAndLayers) {
+        // spheres around a corner, cut open by the sides of the volume
+        const std::vector<vec4> colors = {vec4(1.0f, 0.0f, 0.0f, 1.0f),
+                                          vec4(0.0f, 0.0f, 1.0f, 1.0f)};
+        auto mesh = MarchingTetrahedra::extract(createSphereVolume(size3_t(40), vec3(0.0f)),
+                                                {0.5f, 0.8f}, colors, 1);
+        const auto &inVertices = mesh->getVertices()->getRAMRepresentation()->getDataContainer();
+
+        for (size_t threads : {1, 3}) {
+            auto result = MeshSimplification::simplify(*mesh, 1000, threads);
+            const auto &vertices =
+                result->getVertices()->getRAMRepresentation()->getDataContainer();
+            const auto &vertexColors =
+                result->getColors()->getRAMRepresentation()->getDataContainer();
+            ASSERT_EQ(2u, result->getNumberOfIndicies());
+
+            size_t triangles = 0;
+            for (size_t layer = 0; layer < 2; ++layer) {
+                const auto &in =
+                    mesh->getIndices(layer)->getRAMRepresentation()->getDataContainer();
+                const auto &out =
+                    result->getIndices(layer)->getRAMRepresentation()->getDataContainer();
+                EXPECT_LT(0u, out.size());
+                triangles += out.size() / 3;
+                for (const auto i : out) {
+                    EXPECT_EQ(colors[layer], vertexColors[i]);
+                }
+
+                // the vertices on the boundary stay where they are
+                std::set<std::pair<float, std::pair<float, float>>> positions;
+                for (const auto i : out) {
+                    positions.emplace(vertices[i].x,
+                                      std::make_pair(vertices[i].y, vertices[i].z));
+                }
+                const auto edges = directedEdges(in);
+                for (const auto &edge : edges) {
+                    if (edges.count(std::make_pair(edge.first.second, edge.first.first))) continue;
+                    const vec3 p = inVertices[edge.first.first];
+                    EXPECT_EQ(1u,
+                              positions.count(std::make_pair(p.x, std::make_pair(p.y, p.z))));
+                }
+            }
+            // the boundary vertices alone take a few hundred triangles
+            EXPECT_GT(2000u, triangles);
+        }
+    }
+
+    TEST(MeshSimplificationTest, belowTarget) {
+        auto mesh = MarchingTetrahedra::extract(createSphereVolume(size3_t(12), vec3(0.5f)), 0.3f);
+        auto result = MeshSimplification::simplify(*mesh, 1000000, 4);
+        EXPECT_EQ(mesh->getIndices(0)->getSize(), result->getIndices(0)->getSize());
+        EXPECT_EQ(mesh->getVertices()->getSize(), result->getVertices()->getSize());
+    }
+}
@@ -30,12 +30,18 @@
 #include <modules/tnm067lab2/tnm067lab2module.h>
 #include <modules/tnm067lab2/processors/hydrogengenerator.h>
 #include <modules/tnm067lab2/processors/marchingtetrahedra.h>
+#include <modules/tnm067lab2/processors/meshletpacking.h>
+#include <modules/tnm067lab2/processors/meshsimplification.h>
+#include <modules/tnm067lab2/utils/meshcacheproperty.h>
 
 namespace inviwo {
 
 TNM067Lab2Module::TNM067Lab2Module(InviwoApplication* app) : InviwoModule(app, "TNM067Lab2") {   
     registerProcessor<HydrogenGenerator>();
     registerProcessor<MarchingTetrahedra>();
+    registerProcessor<MeshletPacking>();
+    registerProcessor<MeshSimplification>();
+    registerProperty<MeshCacheProperty>();
     // Add a directory to the search path of the Shadermanager
     // ShaderManager::getPtr()->addShaderSearchPath(getPath(ModulePath::GLSL));
 
@@ -0,0 +1,87 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+
+#include <modules/tnm067lab2/utils/concurrentedgemap.h>
+
+#include <algorithm>
+
+namespace inviwo {
+
+constexpr std::uint64_t ConcurrentEdgeMap::empty;
+constexpr std::uint32_t ConcurrentEdgeMap::invalid;
+constexpr double ConcurrentEdgeMap::maxLoad;
+
+ConcurrentEdgeMap::ConcurrentEdgeMap(size_t edges)
+    : mask_(0)
+    , capacity_(std::min<size_t>(edges, invalid))
+    , keys_()
+    , indices_()
+    , size_(0) {
+    // a power of two, so the probing wraps around with a mask
+    size_t slots = 16;
+    while (static_cast<double>(slots) * maxLoad < static_cast<double>(capacity_)) slots *= 2;
+    mask_ = slots - 1;
+    // the indices have to stay below invalid, even if a few threads claim past the capacity
+    // before they see that it is full
+    capacity_ = std::min<size_t>(static_cast<size_t>(static_cast<double>(slots) * maxLoad),
+                                 invalid / 2);
+
+    keys_.reset(new std::atomic<std::uint64_t>[slots]);
+    indices_.reset(new std::atomic<std::uint32_t>[slots]);
+    for (size_t i = 0; i < slots; ++i) {
+        keys_[i].store(empty, std::memory_order_relaxed);
+        indices_[i].store(invalid, std::memory_order_relaxed);
+    }
+}
+
+std::uint32_t ConcurrentEdgeMap::find(std::uint64_t key) const {
+    for (size_t slot = hash(key) & mask_, probes = 0; probes <= mask_;
+         slot = (slot + 1) & mask_, ++probes) {
+        const std::uint64_t stored = keys_[slot].load(std::memory_order_acquire);
+        if (stored == empty) return invalid;
+        if (stored == key) {
+            const std::uint32_t index = indices_[slot].load(std::memory_order_acquire);
+            return index < capacity_ ? index : invalid;
+        }
+    }
+    return invalid;
+}
+
+size_t ConcurrentEdgeMap::size() const {
+    return std::min<size_t>(size_.load(std::memory_order_relaxed), capacity_);
+}
+
+size_t ConcurrentEdgeMap::capacity() const { return capacity_; }
+
+size_t ConcurrentEdgeMap::getSizeInBytes() const {
+    return (mask_ + 1) * (sizeof(std::uint64_t) + sizeof(std::uint32_t));
+}
+
+}  // namespace inviwo
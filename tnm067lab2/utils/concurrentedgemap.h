@@ -0,0 +1,152 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+
+#ifndef IVW_CONCURRENTEDGEMAP_H
+#define IVW_CONCURRENTEDGEMAP_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace inviwo {
+
+/**
+ * \class ConcurrentEdgeMap
+ * \brief Edge to vertex index map that any number of threads can fill at the same time
+ *
+ * Open addressing with linear probing in a table of fixed capacity. A thread claims the slot of
+ * a new edge with a compare-and-swap on its key and then gives it the next vertex index, so the
+ * indices are dense and never change. No locks are taken; a thread that finds an edge claimed
+ * an instant earlier only waits for the claiming thread to publish the index. Edges are never
+ * removed, and the table does not grow: once it is filled to maxLoad, findOrInsert reports new
+ * edges as invalid and the caller has to start over with a larger map.
+ */
+class IVW_MODULE_TNM067LAB2_API ConcurrentEdgeMap {
+public:
+    static constexpr std::uint64_t empty = std::numeric_limits<std::uint64_t>::max();
+    static constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+    static constexpr double maxLoad = 0.75;
+
+    /**
+     * A map with room for at least the given number of edges.
+     */
+    explicit ConcurrentEdgeMap(size_t edges);
+
+    /**
+     * Key of the edge between the voxels with 1D-index i and j, in any order. The indices have
+     * to fit in 32 bits.
+     */
+    static std::uint64_t key(size_t i, size_t j);
+
+    /**
+     * Vertex index of the edge, and whether this call inserted it and thus has to create the
+     * vertex. The index is invalid if the edge is new and the map is full. Valid indices are
+     * always below capacity(). The key must not be empty.
+     */
+    std::pair<std::uint32_t, bool> findOrInsert(std::uint64_t key);
+
+    /**
+     * Vertex index of the edge, invalid if it has not been inserted.
+     */
+    std::uint32_t find(std::uint64_t key) const;
+
+    /**
+     * Number of edges inserted, and thereby the next vertex index.
+     */
+    size_t size() const;
+
+    /**
+     * Number of edges the map has room for.
+     */
+    size_t capacity() const;
+
+    /**
+     * Memory used by the table, all of its slots and not only the ones in use.
+     */
+    size_t getSizeInBytes() const;
+
+private:
+    static size_t hash(std::uint64_t key);
+
+    size_t mask_;
+    size_t capacity_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> keys_;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> indices_;
+    std::atomic<std::uint32_t> size_;
+};
+
+inline std::uint64_t ConcurrentEdgeMap::key(size_t i, size_t j) {
+    if (j < i) std::swap(i, j);
+    return (static_cast<std::uint64_t>(i) << 32) | static_cast<std::uint64_t>(j);
+}
+
+inline size_t ConcurrentEdgeMap::hash(std::uint64_t key) {
+    // the finalizer of MurmurHash3, neighbouring edges differ in only a few low bits
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+}
+
+inline std::pair<std::uint32_t, bool> ConcurrentEdgeMap::findOrInsert(std::uint64_t key) {
+    for (size_t slot = hash(key) & mask_, probes = 0; probes <= mask_;
+         slot = (slot + 1) & mask_, ++probes) {
+        std::uint64_t stored = keys_[slot].load(std::memory_order_acquire);
+        if (stored == empty) {
+            if (size_.load(std::memory_order_relaxed) >= capacity_) return {invalid, false};
+            if (keys_[slot].compare_exchange_strong(stored, key, std::memory_order_acq_rel)) {
+                const std::uint32_t index = size_.fetch_add(1, std::memory_order_relaxed);
+                indices_[slot].store(index, std::memory_order_release);
+                // other threads passed the check above at the same time and took the last ones
+                if (index >= capacity_) return {invalid, false};
+                return {index, true};
+            }
+            // another thread claimed the slot first, stored is the key it wrote
+        }
+        if (stored == key) {
+            std::uint32_t index;
+            while ((index = indices_[slot].load(std::memory_order_acquire)) == invalid) {
+            }
+            if (index >= capacity_) return {invalid, false};
+            return {index, false};
+        }
+    }
+    return {invalid, false};
+}
+
+}  // namespace inviwo
+
+#endif  // IVW_CONCURRENTEDGEMAP_H
@@ -0,0 +1,104 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/edgeindexcache.h>
+
+namespace inviwo {
+
+constexpr std::uint32_t EdgeIndexCache::invalid;
+constexpr size_t EdgeIndexCache::edgeTypes;
+constexpr size_t EdgeIndexCache::cellEdgeCount;
+
+const size_t EdgeIndexCache::cellEdges[cellEdgeCount][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7},  // x
+    {0, 2}, {1, 3}, {4, 6}, {5, 7},  // y
+    {0, 4}, {1, 5}, {2, 6}, {3, 7},  // z
+    {1, 2}, {5, 6},                  // xy-diagonals
+    {0, 5}, {2, 7},                  // xz-diagonals
+    {2, 4}, {3, 5},                  // yz-diagonals
+    {2, 5}                           // cell diagonal
+};
+
+size_t EdgeIndexCache::cellEdge(size_t a, size_t b) {
+    static const size_t edges[8][8] = {{19, 0, 4, 19, 8, 14, 19, 19},
+                                       {0, 19, 12, 5, 19, 9, 19, 19},
+                                       {4, 12, 19, 1, 16, 18, 10, 15},
+                                       {19, 5, 1, 19, 19, 17, 19, 11},
+                                       {8, 19, 16, 19, 19, 2, 6, 19},
+                                       {14, 9, 18, 17, 2, 19, 13, 7},
+                                       {19, 19, 10, 19, 6, 13, 19, 3},
+                                       {19, 19, 15, 11, 19, 7, 3, 19}};
+    return edges[a][b];
+}
+
+EdgeIndexCache::EdgeIndexCache(size3_t dims)
+    : dims_(dims)
+    , planeSize_(dims.x * dims.y * edgeTypes)
+    , planes_{std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max()}
+    , indices_(2 * planeSize_, invalid) {}
+
+bool EdgeIndexCache::key(size_t i, size_t j, Key& key) const {
+    // Offsets from the lower voxel for each of the edge types
+    static const ivec3 directions[edgeTypes] = {{1, 0, 0},  {0, 1, 0}, {0, 0, 1}, {-1, 1, 0},
+                                                {1, 0, 1},  {0, -1, 1}, {1, -1, 1}};
+
+    const size_t size = dims_.x * dims_.y * dims_.z;
+    if (i >= size || j >= size) return false;
+
+    auto toPos = [&](size_t index) {
+        return ivec3(index % dims_.x, (index / dims_.x) % dims_.y, index / (dims_.x * dims_.y));
+    };
+    const ivec3 a = toPos(i);
+    const ivec3 d = toPos(j) - a;
+    for (size_t type = 0; type < edgeTypes; ++type) {
+        if (d == directions[type]) {
+            key = {i / (dims_.x * dims_.y), (i % (dims_.x * dims_.y)) * edgeTypes + type};
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint32_t EdgeIndexCache::find(const Key& key) const {
+    const size_t half = key.plane & 1;
+    if (planes_[half] != key.plane) return invalid;
+    return indices_[half * planeSize_ + key.slot];
+}
+
+void EdgeIndexCache::remap(const std::vector<std::uint32_t>& map) {
+    for (auto& index : indices_) {
+        if (index != invalid) index = map[index];
+    }
+}
+
+size_t EdgeIndexCache::getSizeInBytes() const {
+    return indices_.capacity() * sizeof(std::uint32_t);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,167 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_EDGEINDEXCACHE_H
+#define IVW_EDGEINDEXCACHE_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace inviwo {
+
+/**
+ * \class EdgeIndexCache
+ * \brief Flat vertex index storage for the edges of the tetrahedral cell decomposition
+ *
+ * Each of the 19 edges used by the six tetrahedra of a cell is stored at its lower voxel as one
+ * of seven edge directions. Edges are always owned by a voxel in the lower of the z-planes they
+ * touch, so a cell only needs the planes z and z+1. Only the two most recently requested planes
+ * are kept, requesting a third one evicts the older of them. Traversing the cells with z
+ * increasing therefore sees every edge that was stored before.
+ */
+class IVW_MODULE_TNM067LAB2_API EdgeIndexCache {
+public:
+    static constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+    static constexpr size_t edgeTypes = 7;
+    static constexpr size_t cellEdgeCount = 19;
+
+    /**
+     * The edges of a cell as pairs of cell corners (corner index = x + 2y + 4z), the lower
+     * corner first.
+     */
+    static const size_t cellEdges[cellEdgeCount][2];
+
+    /**
+     * Returns the cell edge between the cell corners a and b, or cellEdgeCount if the
+     * tetrahedra do not have such an edge.
+     */
+    static size_t cellEdge(size_t a, size_t b);
+
+    struct Key {
+        size_t plane;
+        size_t slot;
+    };
+
+    explicit EdgeIndexCache(size3_t dims = size3_t(0));
+
+    /**
+     * Number of edges a cache for a volume of dims voxels has room for, two planes of them.
+     */
+    static size_t capacity(size3_t dims);
+
+    /**
+     * Key of the given edge (0-18) of the cell with its first corner at cell.
+     */
+    Key key(const size3_t& cell, size_t edge) const;
+
+    /**
+     * Key of the given edge (0-18) of the cell with its first corner at cell, in a volume of
+     * dims voxels, for when no cache is needed.
+     */
+    static Key key(const size3_t& dims, const size3_t& cell, size_t edge);
+
+    /**
+     * Whether the edge of the key lies within its z-plane. The other edges lead up to the next
+     * plane, so cells below the plane of the key do not have them.
+     */
+    static bool inPlane(const Key& key);
+
+    /**
+     * Key of the edge between the voxels with 1D-index i and j, where i < j. Returns false if
+     * the voxels do not span one of the edges of the cell decomposition.
+     */
+    bool key(size_t i, size_t j, Key& key) const;
+
+    /**
+     * Vertex index stored for the key, invalid if none has been stored. The plane of the key is
+     * made available first, evicting the older cached plane if needed.
+     */
+    std::uint32_t& operator[](const Key& key);
+
+    /**
+     * Vertex index stored for the key without evicting anything, invalid if the plane of the
+     * key is not cached.
+     */
+    std::uint32_t find(const Key& key) const;
+
+    /**
+     * Replaces every stored index i with map[i].
+     */
+    void remap(const std::vector<std::uint32_t>& map);
+
+    /**
+     * Memory used by the cached planes.
+     */
+    size_t getSizeInBytes() const;
+
+private:
+    size3_t dims_;
+    size_t planeSize_;
+    size_t planes_[2];
+    std::vector<std::uint32_t> indices_;
+};
+
+inline EdgeIndexCache::Key EdgeIndexCache::key(const size3_t& cell, size_t edge) const {
+    return key(dims_, cell, edge);
+}
+
+inline EdgeIndexCache::Key EdgeIndexCache::key(const size3_t& dims, const size3_t& cell,
+                                               size_t edge) {
+    static const size_t types[cellEdgeCount] = {0, 0, 0, 0, 1, 1, 1, 1, 2, 2,
+                                                2, 2, 3, 3, 4, 4, 5, 5, 6};
+    const size_t corner = cellEdges[edge][0];
+    const size_t x = cell.x + (corner & 1);
+    const size_t y = cell.y + ((corner >> 1) & 1);
+    return {cell.z + (corner >> 2), (x + y * dims.x) * edgeTypes + types[edge]};
+}
+
+inline size_t EdgeIndexCache::capacity(size3_t dims) { return 2 * dims.x * dims.y * edgeTypes; }
+
+inline bool EdgeIndexCache::inPlane(const Key& key) {
+    // the x-, y- and xy-diagonal edge types
+    const size_t type = key.slot % edgeTypes;
+    return type < 2 || type == 3;
+}
+
+inline std::uint32_t& EdgeIndexCache::operator[](const Key& key) {
+    const size_t half = key.plane & 1;
+    if (planes_[half] != key.plane) {
+        std::fill(indices_.begin() + half * planeSize_, indices_.begin() + (half + 1) * planeSize_,
+                  invalid);
+        planes_[half] = key.plane;
+    }
+    return indices_[half * planeSize_ + key.slot];
+}
+
+}  // namespace inviwo
+
+#endif  // IVW_EDGEINDEXCACHE_H
@@ -0,0 +1,144 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+
+#include <modules/tnm067lab2/utils/extractionstats.h>
+
+#include <sstream>
+
+namespace inviwo {
+
+constexpr size_t ExtractionStats::phaseCount;
+
+ExtractionStats::ScopedTimer::ScopedTimer(ExtractionStats* stats, Phase phase)
+    : stats_(stats), phase_(phase), start_(stats ? Clock::now() : Clock::time_point()) {}
+
+ExtractionStats::ScopedTimer::~ScopedTimer() {
+    if (stats_) stats_->addTime(phase_, Clock::now() - start_);
+}
+
+ExtractionStats::ExtractionStats() { reset(); }
+
+void ExtractionStats::reset() {
+    for (auto& time : nanoseconds_) time = 0;
+    cellsVisited_ = 0;
+    activeCells_ = 0;
+    vertexLookups_ = 0;
+    dedupHits_ = 0;
+    peakEdgeMapSize_ = 0;
+    bytesAllocated_ = 0;
+}
+
+void ExtractionStats::addTime(Phase phase, Clock::duration time) {
+    nanoseconds_[static_cast<size_t>(phase)].fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(),
+        std::memory_order_relaxed);
+}
+
+void ExtractionStats::addCells(size_t visited, size_t active) {
+    cellsVisited_.fetch_add(visited, std::memory_order_relaxed);
+    activeCells_.fetch_add(active, std::memory_order_relaxed);
+}
+
+void ExtractionStats::addVertexLookups(size_t lookups, size_t hits) {
+    vertexLookups_.fetch_add(lookups, std::memory_order_relaxed);
+    dedupHits_.fetch_add(hits, std::memory_order_relaxed);
+}
+
+void ExtractionStats::updateEdgeMapSize(size_t slots) {
+    size_t peak = peakEdgeMapSize_.load(std::memory_order_relaxed);
+    while (slots > peak &&
+           !peakEdgeMapSize_.compare_exchange_weak(peak, slots, std::memory_order_relaxed)) {
+    }
+}
+
+void ExtractionStats::addBytesAllocated(size_t bytes) {
+    bytesAllocated_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+double ExtractionStats::getSeconds(Phase phase) const {
+    return static_cast<double>(nanoseconds_[static_cast<size_t>(phase)].load()) * 1e-9;
+}
+
+size_t ExtractionStats::getCellsVisited() const { return cellsVisited_; }
+
+size_t ExtractionStats::getActiveCells() const { return activeCells_; }
+
+size_t ExtractionStats::getVertexLookups() const { return vertexLookups_; }
+
+size_t ExtractionStats::getDedupHits() const { return dedupHits_; }
+
+double ExtractionStats::getDedupHitRate() const {
+    const size_t lookups = vertexLookups_;
+    return lookups == 0 ? 0.0
+                        : static_cast<double>(dedupHits_) / static_cast<double>(lookups);
+}
+
+size_t ExtractionStats::getPeakEdgeMapSize() const { return peakEdgeMapSize_; }
+
+size_t ExtractionStats::getBytesAllocated() const { return bytesAllocated_; }
+
+const char* ExtractionStats::getName(Phase phase) {
+    switch (phase) {
+        case Phase::CellSetup:
+            return "cellSetup";
+        case Phase::Classification:
+            return "classification";
+        case Phase::Interpolation:
+            return "interpolation";
+        case Phase::VertexDedup:
+            return "vertexDedup";
+        case Phase::NormalFinalize:
+            return "normalFinalize";
+        case Phase::MeshCopy:
+            return "meshCopy";
+    }
+    return "";
+}
+
+std::string ExtractionStats::toJSON() const {
+    std::ostringstream json;
+    json << "{\n    \"seconds\": {";
+    for (size_t i = 0; i < phaseCount; ++i) {
+        const auto phase = static_cast<Phase>(i);
+        json << (i == 0 ? "\n" : ",\n") << "        \"" << getName(phase)
+             << "\": " << getSeconds(phase);
+    }
+    json << "\n    },\n"
+         << "    \"cellsVisited\": " << getCellsVisited() << ",\n"
+         << "    \"activeCells\": " << getActiveCells() << ",\n"
+         << "    \"vertexLookups\": " << getVertexLookups() << ",\n"
+         << "    \"dedupHits\": " << getDedupHits() << ",\n"
+         << "    \"dedupHitRate\": " << getDedupHitRate() << ",\n"
+         << "    \"peakEdgeMapSize\": " << getPeakEdgeMapSize() << ",\n"
+         << "    \"bytesAllocated\": " << getBytesAllocated() << "\n}\n";
+    return json.str();
+}
+
+}  // namespace inviwo
@@ -0,0 +1,143 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+
+#ifndef IVW_EXTRACTIONSTATS_H
+#define IVW_EXTRACTIONSTATS_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace inviwo {
+
+/**
+ * \class ExtractionStats
+ * \brief Where the time of iso-surface extractions goes, and how much work they did
+ *
+ * Filled in by the extractions it is passed to, from all of their threads at once. The times of
+ * the phases are summed over the threads, so with more than one thread they can add up to more
+ * than the time the extraction took. The counters and times keep adding up over extractions
+ * until reset is called.
+ */
+class IVW_MODULE_TNM067LAB2_API ExtractionStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase {
+        CellSetup,       // loading the corners of the cells and looking up their cases
+        Classification,  // finding the cells the surfaces pass through
+        Interpolation,   // computing new vertices
+        VertexDedup,     // looking up the vertices already created on an edge
+        NormalFinalize,  // accumulating and normalizing the vertex normals
+        MeshCopy         // building the BasicMesh out of the extracted vertices and triangles
+    };
+    static constexpr size_t phaseCount = 6;
+
+    /**
+     * Adds the time from construction to destruction to a phase, does nothing without stats.
+     */
+    class IVW_MODULE_TNM067LAB2_API ScopedTimer {
+    public:
+        ScopedTimer(ExtractionStats* stats, Phase phase);
+        ~ScopedTimer();
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        ExtractionStats* stats_;
+        Phase phase_;
+        Clock::time_point start_;
+    };
+
+    ExtractionStats();
+
+    void reset();
+
+    void addTime(Phase phase, Clock::duration time);
+
+    /**
+     * Cells visited and the cells among them that at least one surface passes through.
+     */
+    void addCells(size_t visited, size_t active);
+
+    /**
+     * Lookups of vertices on cell edges, hits being those where the edge already had one.
+     */
+    void addVertexLookups(size_t lookups, size_t hits);
+
+    /**
+     * Slots of the structures sharing vertices between cells that were in use at the same time,
+     * only the largest number reported is kept.
+     */
+    void updateEdgeMapSize(size_t slots);
+
+    void addBytesAllocated(size_t bytes);
+
+    double getSeconds(Phase phase) const;
+    size_t getCellsVisited() const;
+    size_t getActiveCells() const;
+    size_t getVertexLookups() const;
+    size_t getDedupHits() const;
+
+    /**
+     * Fraction of the vertex lookups that found an existing vertex, 0 without lookups.
+     */
+    double getDedupHitRate() const;
+    size_t getPeakEdgeMapSize() const;
+    size_t getBytesAllocated() const;
+
+    /**
+     * Name of the phase as used in toJSON, such as "cellSetup".
+     */
+    static const char* getName(Phase phase);
+
+    /**
+     * The times in seconds and the counters as a JSON object.
+     */
+    std::string toJSON() const;
+
+private:
+    std::array<std::atomic<std::int64_t>, phaseCount> nanoseconds_;
+    std::atomic<size_t> cellsVisited_;
+    std::atomic<size_t> activeCells_;
+    std::atomic<size_t> vertexLookups_;
+    std::atomic<size_t> dedupHits_;
+    std::atomic<size_t> peakEdgeMapSize_;
+    std::atomic<size_t> bytesAllocated_;
+};
+
+}  // namespace inviwo
+
+#endif  // IVW_EXTRACTIONSTATS_H
@@ -0,0 +1,183 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/isoclassifier.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define IVW_ISOCLASSIFIER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only generate SSE2 and AVX instructions in functions marked for them, unless
+// the whole build targets them, which 32-bit x86 builds do not by default. MSVC always does.
+#if defined(__GNUC__)
+#define IVW_TARGET_SSE2 __attribute__((target("sse2")))
+#define IVW_TARGET_AVX __attribute__((target("avx")))
+#else
+#define IVW_TARGET_SSE2
+#define IVW_TARGET_AVX
+#endif
+
+namespace inviwo {
+
+namespace {
+
+void classifyScalar(const float* values, size_t count, float iso, std::uint64_t* below) {
+    for (size_t word = 0; word < IsoClassifier::words(count); ++word) {
+        std::uint64_t bits = 0;
+        const size_t end = std::min(count - 64 * word, size_t{64});
+        for (size_t i = 0; i < end; ++i) {
+            if (values[64 * word + i] < iso) bits |= std::uint64_t{1} << i;
+        }
+        below[word] = bits;
+    }
+}
+
+#ifdef IVW_ISOCLASSIFIER_X86
+
+IVW_TARGET_SSE2 void classifySSE2(const float* values, size_t count, float iso,
+                                  std::uint64_t* below) {
+    const __m128 isos = _mm_set1_ps(iso);
+    const size_t full = count / 64;
+    for (size_t word = 0; word < full; ++word) {
+        std::uint64_t bits = 0;
+        const float* v = values + 64 * word;
+        for (size_t i = 0; i < 64; i += 4) {
+            const auto mask = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(v + i), isos));
+            bits |= static_cast<std::uint64_t>(mask) << i;
+        }
+        below[word] = bits;
+    }
+    if (full * 64 < count) classifyScalar(values + 64 * full, count - 64 * full, iso, below + full);
+}
+
+IVW_TARGET_AVX void classifyAVX(const float* values, size_t count, float iso,
+                                std::uint64_t* below) {
+    const __m256 isos = _mm256_set1_ps(iso);
+    const size_t full = count / 64;
+    for (size_t word = 0; word < full; ++word) {
+        std::uint64_t bits = 0;
+        const float* v = values + 64 * word;
+        for (size_t i = 0; i < 64; i += 8) {
+            // ordered and non-signalling, so NaN is never below as with operator<
+            const auto less = _mm256_cmp_ps(_mm256_loadu_ps(v + i), isos, _CMP_LT_OQ);
+            bits |= static_cast<std::uint64_t>(_mm256_movemask_ps(less)) << i;
+        }
+        below[word] = bits;
+    }
+    if (full * 64 < count) classifyScalar(values + 64 * full, count - 64 * full, iso, below + full);
+}
+
+#endif
+
+bool detect(IsoClassifier::InstructionSet set) {
+    using InstructionSet = IsoClassifier::InstructionSet;
+    switch (set) {
+        case InstructionSet::Scalar:
+            return true;
+#ifdef IVW_ISOCLASSIFIER_X86
+#if defined(_MSC_VER)
+        case InstructionSet::SSE2:
+        case InstructionSet::AVX: {
+            int info[4];
+            __cpuid(info, 1);
+            if (set == InstructionSet::SSE2) return (info[3] & (1 << 26)) != 0;
+            // the OS also has to save the AVX registers
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            return avx && osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        }
+#else
+        case InstructionSet::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case InstructionSet::AVX:
+            return __builtin_cpu_supports("avx");
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
+IsoClassifier::InstructionSet best() {
+    using InstructionSet = IsoClassifier::InstructionSet;
+    for (auto set : {InstructionSet::AVX, InstructionSet::SSE2}) {
+        if (detect(set)) return set;
+    }
+    return InstructionSet::Scalar;
+}
+
+std::atomic<IsoClassifier::InstructionSet>& current() {
+    static std::atomic<IsoClassifier::InstructionSet> set(best());
+    return set;
+}
+
+}  // namespace
+
+bool IsoClassifier::isSupported(InstructionSet set) {
+    static const bool supported[3] = {detect(InstructionSet::Scalar),
+                                      detect(InstructionSet::SSE2), detect(InstructionSet::AVX)};
+    return supported[static_cast<size_t>(set)];
+}
+
+IsoClassifier::InstructionSet IsoClassifier::getInstructionSet() { return current(); }
+
+void IsoClassifier::setInstructionSet(InstructionSet set) {
+    if (!isSupported(set)) {
+        throw Exception("The instruction set is not supported by this CPU",
+                        IVW_CONTEXT_CUSTOM("IsoClassifier"));
+    }
+    current() = set;
+}
+
+void IsoClassifier::classify(const float* values, size_t count, float iso,
+                             std::uint64_t* below) {
+    switch (current().load(std::memory_order_relaxed)) {
+#ifdef IVW_ISOCLASSIFIER_X86
+        case InstructionSet::AVX:
+            classifyAVX(values, count, iso, below);
+            break;
+        case InstructionSet::SSE2:
+            classifySSE2(values, count, iso, below);
+            break;
+#endif
+        default:
+            classifyScalar(values, count, iso, below);
+            break;
+    }
+}
+
+}  // namespace inviwo
@@ -0,0 +1,80 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_ISOCLASSIFIER_H
+#define IVW_ISOCLASSIFIER_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+#include <cstdint>
+
+namespace inviwo {
+
+/**
+ * \class IsoClassifier
+ * \brief Compares rows of voxel values against an iso value with SIMD instructions
+ *
+ * The instruction set is picked at runtime, the best one the CPU supports is used unless another
+ * one is set, so the same binary runs on any x86 CPU and falls back to plain C++ elsewhere.
+ */
+class IVW_MODULE_TNM067LAB2_API IsoClassifier {
+public:
+    enum class InstructionSet { Scalar, SSE2, AVX };
+
+    static bool isSupported(InstructionSet set);
+
+    /**
+     * The instruction set used by classify.
+     */
+    static InstructionSet getInstructionSet();
+
+    /**
+     * Uses the given instruction set from now on, throws an Exception if it is not supported.
+     */
+    static void setInstructionSet(InstructionSet set);
+
+    /**
+     * Sets bit i of below, packed into 64-bit words from the lowest bit on, if values[i] < iso
+     * for i in [0, count), using the same comparison as the case classification. The remaining
+     * bits of the last word are cleared.
+     */
+    static void classify(const float* values, size_t count, float iso, std::uint64_t* below);
+
+    /**
+     * Number of 64-bit words for count bits.
+     */
+    static size_t words(size_t count);
+};
+
+inline size_t IsoClassifier::words(size_t count) { return (count + 63) / 64; }
+
+}  // namespace inviwo
+
+#endif  // IVW_ISOCLASSIFIER_H
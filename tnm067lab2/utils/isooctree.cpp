@@ -0,0 +1,301 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/isooctree.h>
+#include <modules/tnm067lab2/utils/minmaxbricks.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+#include <inviwo/core/util/indexmapper.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+namespace inviwo {
+
+constexpr std::uint32_t IsoOctree::none;
+
+IsoOctree::IsoOctree(const VolumeRAM& volume, float iso, float tolerance,
+                     const MinMaxBricks* bricks)
+    : dims_(volume.getDimensions())
+    , cells_(0)
+    , iso_(iso)
+    , tolerance_(tolerance)
+    , nodes_() {
+    size_t size = 1;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        cells_[axis] = dims_[axis] > 1 ? dims_[axis] - 1 : 0;
+        while (size < cells_[axis]) size *= 2;
+    }
+    nodes_.push_back({size3_t(0), size, none});
+
+    std::unique_ptr<MinMaxBricks> ownBricks;
+    if (!bricks) {
+        ownBricks = std::make_unique<MinMaxBricks>(volume);
+        bricks = ownBricks.get();
+    }
+    volume.dispatch<void, dispatching::filter::Scalars>(
+        [&](auto vrprecision) { build(vrprecision->getDataTyped(), *bricks, 0); });
+}
+
+size_t IsoOctree::size() const { return nodes_.size(); }
+
+size_t IsoOctree::getLeafCount() const {
+    return std::count_if(nodes_.begin(), nodes_.end(),
+                         [&](const Node& node) { return isLeaf(node) && isInside(node); });
+}
+
+/*
+ * Returns whether the node ended up as a leaf that its parent can be merged over, i.e. one that
+ * is inside of the volume.
+ */
+template <typename T>
+bool IsoOctree::build(const T* data, const MinMaxBricks& bricks, std::uint32_t index) {
+    const Node node = nodes_[index];
+    if (node.origin.x >= cells_.x || node.origin.y >= cells_.y || node.origin.z >= cells_.z) {
+        return false;
+    }
+    const bool inside = isInside(node);
+    if (inside) {
+        // Checked before splitting to not build large subtrees away from the surface
+        const vec2 range = getRange(data, bricks, node);
+        if (node.size == 1 || !(range.x < iso_ && !(range.y < iso_))) return true;
+    }
+
+    const std::uint32_t firstChild = static_cast<std::uint32_t>(nodes_.size());
+    const size_t size = node.size / 2;
+    for (size_t corner = 0; corner < 8; ++corner) {
+        const size3_t offset((corner & 1), (corner >> 1) & 1, (corner >> 2) & 1);
+        nodes_.push_back({node.origin + offset * size, size, none});
+    }
+    bool leaves = true;
+    for (size_t corner = 0; corner < 8; ++corner) {
+        leaves = build(data, bricks, firstChild + static_cast<std::uint32_t>(corner)) && leaves;
+    }
+
+    if (inside && leaves && isNearlyLinear(data, node)) {
+        nodes_.resize(firstChild);
+        return true;
+    }
+    nodes_[index].firstChild = firstChild;
+    return false;
+}
+
+template <typename T>
+vec2 IsoOctree::getRange(const T* data, const MinMaxBricks& bricks, const Node& node) const {
+    vec2 range(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+    if (node.size >= MinMaxBricks::brickSize) {
+        // Nodes this large are aligned to the bricks
+        const size3_t begin = node.origin / MinMaxBricks::brickSize;
+        const size3_t end = begin + size3_t(node.size / MinMaxBricks::brickSize);
+        size3_t brick;
+        for (brick.z = begin.z; brick.z < end.z; ++brick.z) {
+            for (brick.y = begin.y; brick.y < end.y; ++brick.y) {
+                for (brick.x = begin.x; brick.x < end.x; ++brick.x) {
+                    const vec2& brickRange = bricks.getRange(brick);
+                    range.x = std::min(range.x, brickRange.x);
+                    range.y = std::max(range.y, brickRange.y);
+                }
+            }
+        }
+        return range;
+    }
+
+    util::IndexMapper3D indexMapper(dims_);
+    const size3_t end = node.origin + size3_t(node.size + 1);
+    size3_t pos;
+    for (pos.z = node.origin.z; pos.z < end.z; ++pos.z) {
+        for (pos.y = node.origin.y; pos.y < end.y; ++pos.y) {
+            const size_t row = indexMapper(size3_t(0, pos.y, pos.z));
+            for (pos.x = node.origin.x; pos.x < end.x; ++pos.x) {
+                const float value = static_cast<float>(data[row + pos.x]);
+                range.x = std::min(range.x, value);
+                range.y = std::max(range.y, value);
+            }
+        }
+    }
+    return range;
+}
+
+/*
+ * Whether all voxels of the node are within tolerance of the trilinear interpolation of its
+ * corners, i.e. whether the node can replace its children without moving the surface more
+ * than that.
+ */
+template <typename T>
+bool IsoOctree::isNearlyLinear(const T* data, const Node& node) const {
+    util::IndexMapper3D indexMapper(dims_);
+    float corners[8];
+    for (size_t corner = 0; corner < 8; ++corner) {
+        const size3_t offset((corner & 1), (corner >> 1) & 1, (corner >> 2) & 1);
+        corners[corner] = static_cast<float>(data[indexMapper(node.origin + offset * node.size)]);
+    }
+
+    const float scale = 1.0f / static_cast<float>(node.size);
+    for (size_t z = 0; z <= node.size; ++z) {
+        const float tz = static_cast<float>(z) * scale;
+        for (size_t y = 0; y <= node.size; ++y) {
+            const float ty = static_cast<float>(y) * scale;
+            const size_t row = indexMapper(size3_t(0, node.origin.y + y, node.origin.z + z));
+            for (size_t x = 0; x <= node.size; ++x) {
+                const float tx = static_cast<float>(x) * scale;
+                float v[4];
+                for (size_t i = 0; i < 4; ++i) {
+                    v[i] = corners[2 * i] + tx * (corners[2 * i + 1] - corners[2 * i]);
+                }
+                const float v0 = v[0] + ty * (v[1] - v[0]);
+                const float v1 = v[2] + ty * (v[3] - v[2]);
+                const float trilinear = v0 + tz * (v1 - v0);
+                if (std::abs(static_cast<float>(data[row + node.origin.x + x]) - trilinear) >
+                    tolerance_) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void IsoOctree::forEachEdge(const EdgeCallback& edge) const { cellProc(0, edge); }
+
+/*
+ * The child at corner, or the node itself if it is a leaf.
+ */
+std::uint32_t IsoOctree::child(std::uint32_t index, size_t corner) const {
+    const Node& node = nodes_[index];
+    return isLeaf(node) ? index : node.firstChild + static_cast<std::uint32_t>(corner);
+}
+
+namespace {
+
+// The two axes other than axis, in increasing order
+std::pair<size_t, size_t> otherAxes(size_t axis) {
+    return {axis == 0 ? 1 : 0, axis == 2 ? 1 : 2};
+}
+
+}  // namespace
+
+void IsoOctree::cellProc(std::uint32_t index, const EdgeCallback& edge) const {
+    if (isLeaf(nodes_[index])) return;
+
+    for (size_t corner = 0; corner < 8; ++corner) cellProc(child(index, corner), edge);
+
+    // The twelve faces between the children
+    for (size_t axis = 0; axis < 3; ++axis) {
+        const size_t bit = size_t{1} << axis;
+        for (size_t corner = 0; corner < 8; ++corner) {
+            if (corner & bit) continue;
+            faceProc(child(index, corner), child(index, corner | bit), axis, edge);
+        }
+    }
+
+    // The six edges between the children, two along each axis through the center
+    for (size_t axis = 0; axis < 3; ++axis) {
+        const auto uv = otherAxes(axis);
+        for (size_t half = 0; half < 2; ++half) {
+            std::uint32_t around[4];
+            for (size_t j = 0; j < 4; ++j) {
+                around[j] = child(index, (half << axis) | ((j & 1) << uv.first) |
+                                             ((j >> 1) << uv.second));
+            }
+            edgeProc(around, axis, edge);
+        }
+    }
+}
+
+/*
+ * The face between lower and upper, which are neighbours along axis.
+ */
+void IsoOctree::faceProc(std::uint32_t lower, std::uint32_t upper, size_t axis,
+                         const EdgeCallback& edge) const {
+    if (isLeaf(nodes_[lower]) && isLeaf(nodes_[upper])) return;
+
+    const size_t bit = size_t{1} << axis;
+    const auto bc = otherAxes(axis);
+    for (size_t j = 0; j < 4; ++j) {
+        const size_t corner = ((j & 1) << bc.first) | ((j >> 1) << bc.second);
+        faceProc(child(lower, corner | bit), child(upper, corner), axis, edge);
+    }
+
+    // The four edges in the face, two along each of the other axes through its center
+    for (const size_t along : {bc.first, bc.second}) {
+        const size_t across = along == bc.first ? bc.second : bc.first;
+        const auto uv = otherAxes(along);
+        for (size_t half = 0; half < 2; ++half) {
+            std::uint32_t around[4];
+            for (size_t j = 0; j < 4; ++j) {
+                size_t sides[3] = {0, 0, 0};
+                sides[uv.first] = j & 1;
+                sides[uv.second] = j >> 1;
+                const size_t corner =
+                    (half << along) | ((1 - sides[axis]) << axis) | (sides[across] << across);
+                around[j] = child(sides[axis] ? upper : lower, corner);
+            }
+            edgeProc(around, along, edge);
+        }
+    }
+}
+
+/*
+ * The edge along axis between the four nodes, ordered as in EdgeCallback.
+ */
+void IsoOctree::edgeProc(const std::uint32_t (&nodes)[4], size_t axis,
+                         const EdgeCallback& edge) const {
+    const auto uv = otherAxes(axis);
+    if (std::all_of(std::begin(nodes), std::end(nodes),
+                    [&](std::uint32_t index) { return isLeaf(nodes_[index]); })) {
+        if (!std::all_of(std::begin(nodes), std::end(nodes),
+                         [&](std::uint32_t index) { return isInside(nodes_[index]); })) {
+            return;
+        }
+        size_t smallest = 0;
+        for (size_t j = 1; j < 4; ++j) {
+            if (nodes_[nodes[j]].size < nodes_[nodes[smallest]].size) smallest = j;
+        }
+        const Node& node = nodes_[nodes[smallest]];
+        size3_t from = node.origin;
+        from[uv.first] += (1 - (smallest & 1)) * node.size;
+        from[uv.second] += (1 - (smallest >> 1)) * node.size;
+        edge(nodes, axis, from, node.size);
+        return;
+    }
+
+    for (size_t half = 0; half < 2; ++half) {
+        std::uint32_t around[4];
+        for (size_t j = 0; j < 4; ++j) {
+            around[j] = child(nodes[j], (half << axis) | ((1 - (j & 1)) << uv.first) |
+                                            ((1 - (j >> 1)) << uv.second));
+        }
+        edgeProc(around, axis, edge);
+    }
+}
+
+}  // namespace inviwo
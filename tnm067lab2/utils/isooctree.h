@@ -0,0 +1,132 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_ISOOCTREE_H
+#define IVW_ISOOCTREE_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+namespace inviwo {
+
+class VolumeRAM;
+class MinMaxBricks;
+
+/**
+ * \class IsoOctree
+ * \brief Adaptive octree over the cells of a volume for one iso value
+ *
+ * The leaves are as large as possible while they either contain no part of the iso-surface, all
+ * their voxels being on the same side of iso, or all their voxels are within tolerance of the
+ * trilinear interpolation of their corners. Nodes that are partly outside of the volume are
+ * always split, so each leaf is completely inside or outside of it. The root is the smallest
+ * power of two cells that covers the volume.
+ */
+class IVW_MODULE_TNM067LAB2_API IsoOctree {
+public:
+    static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+    struct Node {
+        size3_t origin;            // first cell of the node
+        size_t size;               // number of cells along each axis
+        std::uint32_t firstChild;  // the eight children follow from here, none for leaves
+    };
+
+    /**
+     * Called for each edge of the octree that is an edge of all the leaves around it, i.e. a
+     * minimal edge. leaves are the four leaves around the edge, leaves[u + 2v] being on the
+     * upper side of the edge along the first of the other two axes if u is 1 and along the
+     * second one if v is 1. A leaf can be in two of them. The edge goes from the voxel from
+     * along axis for length voxels and is the edge of the smallest of the leaves.
+     */
+    using EdgeCallback = std::function<void(const std::uint32_t (&leaves)[4], size_t axis,
+                                            const size3_t& from, size_t length)>;
+
+    /**
+     * Builds the octree, bricks are used for the value ranges of the larger nodes and are
+     * computed if not given.
+     */
+    IsoOctree(const VolumeRAM& volume, float iso, float tolerance,
+              const MinMaxBricks* bricks = nullptr);
+
+    const Node& getNode(std::uint32_t index) const;
+    size_t size() const;
+    bool isLeaf(const Node& node) const;
+    bool isInside(const Node& node) const;
+
+    /**
+     * Number of leaves inside of the volume.
+     */
+    size_t getLeafCount() const;
+
+    /**
+     * Calls edge for every minimal edge that only has leaves inside of the volume around it, by
+     * the dual traversal of Ju et al., Dual Contouring of Hermite Data, 2002.
+     */
+    void forEachEdge(const EdgeCallback& edge) const;
+
+private:
+    template <typename T>
+    bool build(const T* data, const MinMaxBricks& bricks, std::uint32_t index);
+    template <typename T>
+    vec2 getRange(const T* data, const MinMaxBricks& bricks, const Node& node) const;
+    template <typename T>
+    bool isNearlyLinear(const T* data, const Node& node) const;
+
+    std::uint32_t child(std::uint32_t index, size_t corner) const;
+    void cellProc(std::uint32_t index, const EdgeCallback& edge) const;
+    void faceProc(std::uint32_t lower, std::uint32_t upper, size_t axis,
+                  const EdgeCallback& edge) const;
+    void edgeProc(const std::uint32_t (&nodes)[4], size_t axis, const EdgeCallback& edge) const;
+
+    size3_t dims_;
+    size3_t cells_;
+    float iso_;
+    float tolerance_;
+    std::vector<Node> nodes_;
+};
+
+inline const IsoOctree::Node& IsoOctree::getNode(std::uint32_t index) const {
+    return nodes_[index];
+}
+
+inline bool IsoOctree::isLeaf(const Node& node) const { return node.firstChild == none; }
+
+inline bool IsoOctree::isInside(const Node& node) const {
+    return node.origin.x + node.size <= cells_.x && node.origin.y + node.size <= cells_.y &&
+           node.origin.z + node.size <= cells_.z;
+}
+
+}  // namespace inviwo
+
+#endif  // IVW_ISOOCTREE_H
@@ -0,0 +1,148 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/mappedfile.h>
+#include <inviwo/core/util/exception.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace inviwo {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+    : path_(path), file_(nullptr), mapping_(nullptr), size_(0), view_(nullptr), viewSize_(0) {
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size)) {
+        throw FileException("Could not open file: " + path, IVW_CONTEXT_CUSTOM("MappedFile"));
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ > 0) {
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) {
+            CloseHandle(file_);
+            throw FileException("Could not map file: " + path, IVW_CONTEXT_CUSTOM("MappedFile"));
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+    if (mapping_) CloseHandle(mapping_);
+    CloseHandle(file_);
+}
+
+const unsigned char* MappedFile::map(size_t offset, size_t size) {
+    unmap();
+    if (offset + size > size_) {
+        throw FileException("Mapping beyond the end of file: " + path_,
+                            IVW_CONTEXT_CUSTOM("MappedFile"));
+    }
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const size_t begin = offset - offset % info.dwAllocationGranularity;
+    viewSize_ = offset + size - begin;
+    view_ = MapViewOfFile(mapping_, FILE_MAP_READ, static_cast<DWORD>(std::uint64_t(begin) >> 32),
+                          static_cast<DWORD>(begin & 0xFFFFFFFF), viewSize_);
+    if (!view_) {
+        throw FileException("Could not map file: " + path_, IVW_CONTEXT_CUSTOM("MappedFile"));
+    }
+    return static_cast<const unsigned char*>(view_) + (offset - begin);
+}
+
+void MappedFile::unmap() {
+    if (view_) UnmapViewOfFile(view_);
+    view_ = nullptr;
+    viewSize_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+    : path_(path), file_(-1), size_(0), view_(nullptr), viewSize_(0) {
+    file_ = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (file_ < 0 || fstat(file_, &info) != 0) {
+        if (file_ >= 0) close(file_);
+        throw FileException("Could not open file: " + path, IVW_CONTEXT_CUSTOM("MappedFile"));
+    }
+    size_ = static_cast<size_t>(info.st_size);
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+    close(file_);
+}
+
+const unsigned char* MappedFile::map(size_t offset, size_t size) {
+    unmap();
+    if (offset + size > size_) {
+        throw FileException("Mapping beyond the end of file: " + path_,
+                            IVW_CONTEXT_CUSTOM("MappedFile"));
+    }
+
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = offset - offset % pageSize;
+    viewSize_ = offset + size - begin;
+    view_ = mmap(nullptr, viewSize_, PROT_READ, MAP_SHARED, file_, static_cast<off_t>(begin));
+    if (view_ == MAP_FAILED) {
+        view_ = nullptr;
+        viewSize_ = 0;
+        throw FileException("Could not map file: " + path_, IVW_CONTEXT_CUSTOM("MappedFile"));
+    }
+    return static_cast<const unsigned char*>(view_) + (offset - begin);
+}
+
+void MappedFile::unmap() {
+    if (view_) munmap(view_, viewSize_);
+    view_ = nullptr;
+    viewSize_ = 0;
+}
+
+#endif
+
+size_t MappedFile::size() const { return size_; }
+
+}  // namespace inviwo
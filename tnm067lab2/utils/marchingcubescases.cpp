@@ -0,0 +1,208 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/marchingcubescases.h>
+#include <modules/tnm067lab2/utils/edgeindexcache.h>
+#include <inviwo/core/util/assertion.h>
+
+#include <algorithm>
+
+namespace inviwo {
+
+constexpr size_t MarchingCubesCases::maxTriangles;
+constexpr size_t MarchingCubesCases::center;
+
+// x-faces ordered by (y, z), y-faces by (x, z) and z-faces by (x, y), going around each face
+const size_t MarchingCubesCases::faces[6][4] = {{0, 2, 6, 4}, {1, 3, 7, 5}, {0, 1, 5, 4},
+                                                {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 5, 7, 6}};
+
+const MarchingCubesCases& MarchingCubesCases::get() {
+    static const MarchingCubesCases cases;
+    return cases;
+}
+
+MarchingCubesCases::MarchingCubesCases() : entries_(), cases_() {
+    for (size_t caseId = 0; caseId < 256; ++caseId) {
+        Entry& entry = entries_[caseId];
+        entry.first = cases_.size();
+        entry.ambiguousCount = 0;
+        for (size_t f = 0; f < 6; ++f) {
+            const auto& face = faces[f];
+            auto below = [&](size_t k) { return ((caseId >> face[k]) & 1) != 0; };
+            if (below(0) == below(2) && below(1) == below(3) && below(0) != below(1)) {
+                entry.ambiguous[entry.ambiguousCount++] = f;
+            }
+        }
+
+        for (size_t variant = 0; variant < (size_t{1} << entry.ambiguousCount); ++variant) {
+            size_t joinedFaces = 0;
+            for (size_t i = 0; i < entry.ambiguousCount; ++i) {
+                if ((variant >> i) & 1) joinedFaces |= size_t{1} << entry.ambiguous[i];
+            }
+            cases_.push_back(triangulate(caseId, joinedFaces));
+        }
+    }
+}
+
+const std::vector<MarchingCubesCases::Case>& MarchingCubesCases::getCases() const {
+    return cases_;
+}
+
+MarchingCubesCases::Case MarchingCubesCases::triangulate(size_t caseId,
+                                                         size_t joinedFaces) const {
+    auto below = [&](size_t corner) { return ((caseId >> corner) & 1) != 0; };
+    auto position = [](size_t corner) {
+        return vec3(corner & 1, (corner >> 1) & 1, corner >> 2);
+    };
+    auto midpoint = [&](size_t edge) {
+        return 0.5f * (position(EdgeIndexCache::cellEdges[edge][0]) +
+                       position(EdgeIndexCache::cellEdges[edge][1]));
+    };
+
+    // Contour segments on the faces, next[a] = b for a segment from edge a to edge b. Seen from
+    // outside of the cell, the below corners are to the left of each segment, so the segments
+    // form closed loops around the below corners.
+    int next[12];
+    std::fill(std::begin(next), std::end(next), -1);
+    for (size_t f = 0; f < 6; ++f) {
+        const auto& face = faces[f];
+        vec3 normal(0.0f);
+        normal[f / 2] = f % 2 ? 1.0f : -1.0f;
+
+        auto addSegment = [&](size_t a, size_t b, size_t corner) {
+            const vec3 pa = midpoint(a);
+            const bool left =
+                glm::dot(glm::cross(midpoint(b) - pa, position(corner) - pa), normal) > 0.0f;
+            if (left != below(corner)) std::swap(a, b);
+            ivwAssert(next[a] == -1, "each edge should start a single segment");
+            next[a] = static_cast<int>(b);
+        };
+
+        // edges[k] goes from corner k to corner k + 1 of the face
+        size_t edges[4];
+        size_t crossings[4];
+        size_t crossingCount = 0;
+        for (size_t k = 0; k < 4; ++k) {
+            edges[k] = EdgeIndexCache::cellEdge(face[k], face[(k + 1) % 4]);
+            if (below(face[k]) != below(face[(k + 1) % 4])) crossings[crossingCount++] = k;
+        }
+
+        if (crossingCount == 2) {
+            addSegment(edges[crossings[0]], edges[crossings[1]], face[crossings[0] + 1]);
+        } else if (crossingCount == 4) {
+            // cut off the corners that are not joined across the face
+            const bool cutBelow = ((joinedFaces >> f) & 1) == 0;
+            for (size_t k = 0; k < 4; ++k) {
+                if (below(face[k]) == cutBelow) {
+                    addSegment(edges[(k + 3) % 4], edges[k], face[k]);
+                }
+            }
+        }
+    }
+
+    // Follow the loops and triangulate each of them
+    Case result{};
+    bool visited[12] = {};
+    for (size_t start = 0; start < 12; ++start) {
+        if (next[start] == -1 || visited[start]) continue;
+        std::vector<size_t> loop;
+        for (size_t edge = start; !visited[edge]; edge = static_cast<size_t>(next[edge])) {
+            ivwAssert(next[edge] != -1, "the segments should form closed loops");
+            visited[edge] = true;
+            loop.push_back(edge);
+        }
+        triangulateLoop(loop, result);
+    }
+    return result;
+}
+
+void MarchingCubesCases::triangulateLoop(const std::vector<size_t>& loop, Case& result) {
+    // A diagonal between two vertices on the same face lies in that face, where the cell on the
+    // other side might use it as well. Such pairs only occur on ambiguous faces. Loops that
+    // cannot be triangulated without them are triangulated around a vertex in the cell.
+    auto sharesFace = [](size_t a, size_t b) {
+        for (const auto& face : faces) {
+            bool hasA = false;
+            bool hasB = false;
+            for (size_t k = 0; k < 4; ++k) {
+                const size_t edge = EdgeIndexCache::cellEdge(face[k], face[(k + 1) % 4]);
+                hasA |= edge == a;
+                hasB |= edge == b;
+            }
+            if (hasA && hasB) return true;
+        }
+        return false;
+    };
+    auto addTriangle = [&](size_t a, size_t b, size_t c) {
+        ivwAssert(result.triangleCount < maxTriangles, "too many triangles");
+        auto& triangle = result.triangles[result.triangleCount++];
+        triangle[0] = static_cast<std::uint8_t>(a);
+        triangle[1] = static_cast<std::uint8_t>(b);
+        triangle[2] = static_cast<std::uint8_t>(c);
+    };
+
+    // split[i][j] is the apex of the triangle on (i, j) in a triangulation of the polygon
+    // i, ..., j, or n if it has none
+    const size_t n = loop.size();
+    size_t split[12][12];
+    auto allowed = [&](size_t i, size_t j) { return j == i + 1 || !sharesFace(loop[i], loop[j]); };
+    for (size_t length = 1; length < n; ++length) {
+        for (size_t i = 0; i + length < n; ++i) {
+            const size_t j = i + length;
+            split[i][j] = length == 1 ? 0 : n;
+            for (size_t k = i + 1; k < j && split[i][j] == n; ++k) {
+                if (allowed(i, k) && allowed(k, j) && (k == i + 1 || split[i][k] != n) &&
+                    (k + 1 == j || split[k][j] != n)) {
+                    split[i][j] = k;
+                }
+            }
+        }
+    }
+    if (split[0][n - 1] == n) {
+        ivwAssert(result.centerLoop == 0, "a cell should have a single loop around its center");
+        for (size_t i = 0; i < n; ++i) {
+            result.centerLoop |= static_cast<std::uint16_t>(1 << loop[i]);
+            addTriangle(center, loop[i], loop[(i + 1) % n]);
+        }
+        return;
+    }
+
+    std::vector<std::pair<size_t, size_t>> stack{{0, n - 1}};
+    while (!stack.empty()) {
+        const auto range = stack.back();
+        stack.pop_back();
+        if (range.second - range.first < 2) continue;
+        const size_t k = split[range.first][range.second];
+        addTriangle(loop[range.first], loop[k], loop[range.second]);
+        stack.emplace_back(k, range.second);
+        stack.emplace_back(range.first, k);
+    }
+}
+
+}  // namespace inviwo
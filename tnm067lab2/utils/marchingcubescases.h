@@ -0,0 +1,129 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_MARCHINGCUBESCASES_H
+#define IVW_MARCHINGCUBESCASES_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+namespace inviwo {
+
+/**
+ * \class MarchingCubesCases
+ * \brief Triangles of the marching cubes cases with the face ambiguities resolved
+ *
+ * A case sets bit k if corner k (corner index = x + 2y + 4z) is below the iso value, as for the
+ * tetrahedra. A face with its two below corners on one diagonal is ambiguous, it can either join
+ * the below or the above corners. Such faces are resolved with the asymptotic decider, i.e. as
+ * the bilinear interpolant of the face values. It only uses the values of the face, so the two
+ * cells sharing it always agree and the surface has no cracks. Ambiguities inside the cell are
+ * not resolved.
+ *
+ * The triangles are generated at startup for every case and every resolution of its ambiguous
+ * faces, by joining the contour segments on the faces into loops. The loops are triangulated
+ * without diagonals across the faces, which the next cell might use as well, and are wound so
+ * that their face normals point towards lower values.
+ */
+class IVW_MODULE_TNM067LAB2_API MarchingCubesCases {
+public:
+    static constexpr size_t maxTriangles = 12;
+
+    /**
+     * Stands for the vertex in the middle of the cell in the triangles of a case.
+     */
+    static constexpr size_t center = 12;
+
+    /**
+     * The triangles of a case, as triples of cube edges. The cube edges are the edges 0-11 of
+     * EdgeIndexCache::cellEdges. A few cases have a loop that can only be triangulated around a
+     * vertex in the cell, at the centroid of the vertices on the edges set in centerLoop.
+     */
+    struct Case {
+        size_t triangleCount;
+        std::uint8_t triangles[maxTriangles][3];
+        std::uint16_t centerLoop;
+    };
+
+    /**
+     * The corners of each face, in the same order for the faces shared by two cells.
+     */
+    static const size_t faces[6][4];
+
+    static const MarchingCubesCases& get();
+
+    /**
+     * The triangles of the case, value(corner) is the value of each corner of the cell. Only
+     * the values of ambiguous faces are looked at.
+     */
+    template <typename Value>
+    const Case& getCase(size_t caseId, float iso, Value value) const;
+
+    /**
+     * The triangles of every case for every resolution of its ambiguous faces.
+     */
+    const std::vector<Case>& getCases() const;
+
+private:
+    MarchingCubesCases();
+    Case triangulate(size_t caseId, size_t joinedFaces) const;
+    static void triangulateLoop(const std::vector<size_t>& loop, Case& result);
+
+    struct Entry {
+        size_t first;
+        size_t ambiguousCount;
+        size_t ambiguous[6];
+    };
+    // the resolutions of the ambiguous faces of a case start at first
+    Entry entries_[256];
+    std::vector<Case> cases_;
+};
+
+template <typename Value>
+const MarchingCubesCases::Case& MarchingCubesCases::getCase(size_t caseId, float iso,
+                                                            Value value) const {
+    const Entry& entry = entries_[caseId];
+    size_t variant = 0;
+    for (size_t i = 0; i < entry.ambiguousCount; ++i) {
+        const auto& face = faces[entry.ambiguous[i]];
+        const float a = value(face[0]) - iso;
+        const float b = value(face[1]) - iso;
+        const float c = value(face[2]) - iso;
+        const float d = value(face[3]) - iso;
+        // the below corners are joined if the saddle of the bilinear interpolant is below iso,
+        // i.e. if their product is larger than the one of the above corners
+        const bool joined = (caseId >> face[0]) & 1 ? a * c > b * d : b * d > a * c;
+        if (joined) variant |= size_t{1} << i;
+    }
+    return cases_[entry.first + variant];
+}
+
+}  // namespace inviwo
+
+#endif  // IVW_MARCHINGCUBESCASES_H
@@ -0,0 +1,308 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/meshcache.h>
+#include <modules/tnm067lab2/utils/mappedfile.h>
+#include <inviwo/core/util/exception.h>
+#include <inviwo/core/util/filesystem.h>
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+namespace inviwo {
+
+namespace {
+
+constexpr char magic[4] = {'T', 'N', 'M', 'C'};
+constexpr std::uint32_t version = 1;
+
+/**
+ * Fixed part at the start of each file, followed by the color and index count of each layer,
+ * the positions, the normals and the indices of each layer.
+ */
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t key;
+    std::uint64_t vertexCount;
+    std::uint64_t layerCount;
+    mat4 modelMatrix;
+    mat4 worldMatrix;
+};
+
+struct LayerHeader {
+    vec4 color;
+    std::uint64_t indexCount;
+};
+
+/**
+ * Reads the mesh of a file, nullptr if the file is not a complete mesh stored under key.
+ */
+std::shared_ptr<BasicMesh> readMesh(const unsigned char* data, size_t size, std::uint64_t key) {
+    size_t offset = 0;
+    auto read = [&](void* dst, size_t bytes) {
+        if (offset + bytes > size) return false;
+        std::memcpy(dst, data + offset, bytes);
+        offset += bytes;
+        return true;
+    };
+
+    FileHeader header;
+    if (!read(&header, sizeof(header)) || std::memcmp(header.magic, magic, 4) != 0 ||
+        header.version != version || header.key != key) {
+        return nullptr;
+    }
+    // the counts are bounded by the file size before anything is allocated for them
+    if (header.layerCount > size / sizeof(LayerHeader)) return nullptr;
+    std::vector<LayerHeader> layers(static_cast<size_t>(header.layerCount));
+    if (!read(layers.data(), layers.size() * sizeof(LayerHeader))) return nullptr;
+
+    if (header.vertexCount > size / (2 * sizeof(vec3))) return nullptr;
+    const auto vertexCount = static_cast<size_t>(header.vertexCount);
+    auto mesh = std::make_shared<BasicMesh>();
+    mesh->setModelMatrix(header.modelMatrix);
+    mesh->setWorldMatrix(header.worldMatrix);
+    auto& positions =
+        mesh->getEditableVertices()->getEditableRAMRepresentation()->getDataContainer();
+    auto& normals = mesh->getEditableNormals()->getEditableRAMRepresentation()->getDataContainer();
+    auto& texCoords =
+        mesh->getEditableTexCoords()->getEditableRAMRepresentation()->getDataContainer();
+    auto& colors = mesh->getEditableColors()->getEditableRAMRepresentation()->getDataContainer();
+    positions.resize(vertexCount);
+    normals.resize(vertexCount);
+    if (!read(positions.data(), vertexCount * sizeof(vec3)) ||
+        !read(normals.data(), vertexCount * sizeof(vec3))) {
+        return nullptr;
+    }
+    texCoords = positions;
+    colors.assign(vertexCount, layers.empty() ? vec4(0.7f, 0.7f, 0.7f, 1.0f) : layers[0].color);
+
+    for (const auto& layer : layers) {
+        auto& indices =
+            mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)->getDataContainer();
+        if (layer.indexCount > size / sizeof(std::uint32_t)) return nullptr;
+        const auto indexCount = static_cast<size_t>(layer.indexCount);
+        indices.resize(indexCount);
+        if (!read(indices.data(), indexCount * sizeof(std::uint32_t))) return nullptr;
+        for (auto i : indices) {
+            if (i >= vertexCount) return nullptr;
+            colors[i] = layer.color;
+        }
+    }
+    return offset == size ? mesh : nullptr;
+}
+
+}  // namespace
+
+constexpr std::uint64_t MeshCache::hashSeed;
+
+std::uint64_t MeshCache::hash(const void* data, size_t bytes, std::uint64_t hash) {
+    auto add = [&hash](std::uint64_t word) { hash = (hash ^ word) * 1099511628211ull; };
+    const auto begin = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, begin + i, 8);
+        add(word);
+    }
+    for (; i < bytes; ++i) add(begin[i]);
+    return hash;
+}
+
+MeshCache::MeshCache(const std::string& directory, size_t maxBytes)
+    : directory_(directory)
+    , maxBytes_(maxBytes)
+    , entries_()
+    , lookup_()
+    , bytes_(0)
+    , hits_(0)
+    , misses_(0) {
+    filesystem::createDirectoryRecursively(directory_);
+
+    // the index lists the keys most recently used first, entries without a file are dropped
+    std::ifstream index(directory_ + "/index");
+    std::string line;
+    while (std::getline(index, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        if (!(fields >> std::hex >> entry.key >> std::dec >> entry.bytes)) continue;
+        if (lookup_.count(entry.key) || !filesystem::fileExists(path(entry.key))) continue;
+        lookup_[entry.key] = entries_.insert(entries_.end(), entry);
+        bytes_ += entry.bytes;
+    }
+    evict();
+    saveIndex();
+}
+
+MeshCache::~MeshCache() { saveIndex(); }
+
+std::shared_ptr<BasicMesh> MeshCache::find(std::uint64_t key) {
+    const auto it = lookup_.find(key);
+    if (it == lookup_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+
+    std::shared_ptr<BasicMesh> mesh;
+    try {
+        MappedFile file(path(key));
+        if (file.size() >= sizeof(FileHeader)) {
+            mesh = readMesh(file.map(0, file.size()), file.size(), key);
+        }
+    } catch (const std::exception&) {
+        mesh = nullptr;
+    }
+
+    // a file that can not be read or is not a valid mesh is a miss and is dropped
+    if (!mesh) {
+        erase(it->second);
+        saveIndex();
+        ++misses_;
+        return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    ++hits_;
+    return mesh;
+}
+
+void MeshCache::insert(std::uint64_t key, const BasicMesh& mesh) {
+    const auto& positions = mesh.getVertices()->getRAMRepresentation()->getDataContainer();
+    const auto& normals = mesh.getNormals()->getRAMRepresentation()->getDataContainer();
+    const auto& colors = mesh.getColors()->getRAMRepresentation()->getDataContainer();
+
+    FileHeader header;
+    std::memcpy(header.magic, magic, 4);
+    header.version = version;
+    header.key = key;
+    header.vertexCount = positions.size();
+    header.layerCount = mesh.getNumberOfIndicies();
+    header.modelMatrix = mesh.getModelMatrix();
+    header.worldMatrix = mesh.getWorldMatrix();
+
+    std::vector<LayerHeader> layers;
+    size_t bytes = sizeof(FileHeader) + 2 * positions.size() * sizeof(vec3);
+    for (size_t i = 0; i < mesh.getNumberOfIndicies(); ++i) {
+        const auto& indices = mesh.getIndices(i)->getRAMRepresentation()->getDataContainer();
+        layers.push_back({indices.empty() ? vec4(0.7f, 0.7f, 0.7f, 1.0f) : colors[indices.front()],
+                          indices.size()});
+        bytes += sizeof(LayerHeader) + indices.size() * sizeof(std::uint32_t);
+    }
+    if (bytes > maxBytes_) return;
+
+    const auto it = lookup_.find(key);
+    if (it != lookup_.end()) erase(it->second);
+
+    // written next to the entry and then renamed, so that a file is either complete or missing
+    const std::string file = path(key);
+    const std::string partial = file + ".partial";
+    {
+        std::ofstream out(partial, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(layers.data()),
+                  layers.size() * sizeof(LayerHeader));
+        out.write(reinterpret_cast<const char*>(positions.data()),
+                  positions.size() * sizeof(vec3));
+        out.write(reinterpret_cast<const char*>(normals.data()), normals.size() * sizeof(vec3));
+        for (size_t i = 0; i < mesh.getNumberOfIndicies(); ++i) {
+            const auto& indices = mesh.getIndices(i)->getRAMRepresentation()->getDataContainer();
+            out.write(reinterpret_cast<const char*>(indices.data()),
+                      indices.size() * sizeof(std::uint32_t));
+        }
+        if (!out) {
+            out.close();
+            std::remove(partial.c_str());
+            return;
+        }
+    }
+    std::remove(file.c_str());
+    if (std::rename(partial.c_str(), file.c_str()) != 0) {
+        std::remove(partial.c_str());
+        return;
+    }
+
+    lookup_[key] = entries_.insert(entries_.begin(), Entry{key, bytes});
+    bytes_ += bytes;
+    evict();
+    saveIndex();
+}
+
+void MeshCache::clear() {
+    while (!entries_.empty()) erase(entries_.begin());
+    saveIndex();
+}
+
+void MeshCache::setMaxBytes(size_t maxBytes) {
+    maxBytes_ = maxBytes;
+    evict();
+    saveIndex();
+}
+
+size_t MeshCache::getMaxBytes() const { return maxBytes_; }
+
+size_t MeshCache::getSizeInBytes() const { return bytes_; }
+
+size_t MeshCache::getEntryCount() const { return entries_.size(); }
+
+size_t MeshCache::getHits() const { return hits_; }
+
+size_t MeshCache::getMisses() const { return misses_; }
+
+const std::string& MeshCache::getDirectory() const { return directory_; }
+
+std::string MeshCache::path(std::uint64_t key) const {
+    std::ostringstream name;
+    name << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << key
+         << ".mesh";
+    return name.str();
+}
+
+void MeshCache::erase(std::list<Entry>::iterator entry) {
+    std::remove(path(entry->key).c_str());
+    bytes_ -= entry->bytes;
+    lookup_.erase(entry->key);
+    entries_.erase(entry);
+}
+
+void MeshCache::evict() {
+    while (bytes_ > maxBytes_ && !entries_.empty()) erase(std::prev(entries_.end()));
+}
+
+void MeshCache::saveIndex() const {
+    std::ofstream index(directory_ + "/index");
+    for (const auto& entry : entries_) {
+        index << std::hex << entry.key << " " << std::dec << entry.bytes << "\n";
+    }
+}
+
+}  // namespace inviwo
@@ -0,0 +1,124 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_MESHCACHE_H
+#define IVW_MESHCACHE_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+#include <inviwo/core/datastructures/geometry/basicmesh.h>
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace inviwo {
+
+/**
+ * \class MeshCache
+ * \brief Content addressed cache of extracted meshes in a directory on disk
+ *
+ * Each mesh is stored under a 64-bit key, the hash of everything that went into extracting it,
+ * as a compact binary file that is memory mapped when it is read back. When the files together
+ * grow past the size limit the least recently used ones are deleted. The order of use is kept in
+ * an index file in the directory, so it carries over between sessions. The index is written when
+ * meshes are added or removed and when the cache is destroyed, not on every hit. A directory
+ * should only be used by one cache at a time.
+ */
+class IVW_MODULE_TNM067LAB2_API MeshCache {
+public:
+    static constexpr std::uint64_t hashSeed = 14695981039346656037ull;
+
+    /**
+     * FNV-1a hash of the bytes, continuing from hash so that several inputs can be combined.
+     */
+    static std::uint64_t hash(const void* data, size_t bytes, std::uint64_t hash = hashSeed);
+
+    /**
+     * Opens the cache in directory, creating the directory if needed. The files of the cache
+     * are kept below maxBytes in total.
+     */
+    MeshCache(const std::string& directory, size_t maxBytes);
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    /**
+     * Writes the order the meshes were last used in to the index.
+     */
+    ~MeshCache();
+
+    /**
+     * The mesh stored under key, nullptr if there is none. Counts as a hit or a miss.
+     */
+    std::shared_ptr<BasicMesh> find(std::uint64_t key);
+
+    /**
+     * Stores the mesh under key and evicts the least recently used meshes that no longer fit.
+     * Meshes larger than the whole cache are not stored. The texture coordinates are not
+     * stored, they are the positions in extracted meshes, and the color is stored once per
+     * index buffer, taken from its first vertex.
+     */
+    void insert(std::uint64_t key, const BasicMesh& mesh);
+
+    /**
+     * Deletes all the files of the cache.
+     */
+    void clear();
+
+    void setMaxBytes(size_t maxBytes);
+    size_t getMaxBytes() const;
+    size_t getSizeInBytes() const;
+    size_t getEntryCount() const;
+    size_t getHits() const;
+    size_t getMisses() const;
+    const std::string& getDirectory() const;
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        size_t bytes;
+    };
+
+    std::string path(std::uint64_t key) const;
+    void erase(std::list<Entry>::iterator entry);
+    void evict();
+    void saveIndex() const;
+
+    std::string directory_;
+    size_t maxBytes_;
+    std::list<Entry> entries_;  // most recently used first
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> lookup_;
+    size_t bytes_;
+    size_t hits_;
+    size_t misses_;
+};
+
+}  // namespace inviwo
+
+#endif  // IVW_MESHCACHE_H
@@ -0,0 +1,105 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/meshcacheproperty.h>
+#include <inviwo/core/util/filesystem.h>
+
+#include <limits>
+
+namespace inviwo {
+
+const std::string MeshCacheProperty::classIdentifier = "org.inviwo.MeshCacheProperty";
+std::string MeshCacheProperty::getClassIdentifier() const { return classIdentifier; }
+
+MeshCacheProperty::MeshCacheProperty(const std::string& identifier,
+                                     const std::string& displayName)
+    : BoolCompositeProperty(identifier, displayName, false)
+    , directory_("cacheDirectory", "Directory",
+                 filesystem::getInviwoUserSettingsPath() + "/tnm067lab2-meshcache")
+    , size_("cacheSize", "Size Limit (MB)", 1024, 1, 1 << 20)
+    , hits_("cacheHits", "Hits", 0, 0, std::numeric_limits<size_t>::max(), 1,
+            InvalidationLevel::Valid)
+    , misses_("cacheMisses", "Misses", 0, 0, std::numeric_limits<size_t>::max(), 1,
+              InvalidationLevel::Valid)
+    , cache_() {
+    initialize();
+}
+
+MeshCacheProperty::MeshCacheProperty(const MeshCacheProperty& rhs)
+    : BoolCompositeProperty(rhs)
+    , directory_(rhs.directory_)
+    , size_(rhs.size_)
+    , hits_(rhs.hits_)
+    , misses_(rhs.misses_)
+    , cache_() {
+    initialize();
+}
+
+MeshCacheProperty* MeshCacheProperty::clone() const { return new MeshCacheProperty(*this); }
+
+std::shared_ptr<BasicMesh> MeshCacheProperty::find(std::uint64_t key) {
+    if (!isChecked()) return nullptr;
+    auto& cache = getCache();
+    auto mesh = cache.find(key);
+    hits_.set(cache.getHits());
+    misses_.set(cache.getMisses());
+    return mesh;
+}
+
+void MeshCacheProperty::insert(std::uint64_t key, const BasicMesh& mesh) {
+    if (!isChecked()) return;
+    getCache().insert(key, mesh);
+}
+
+MeshCache& MeshCacheProperty::getCache() {
+    if (!cache_) {
+        cache_ = std::make_unique<MeshCache>(directory_.get(), size_.get() << 20);
+    }
+    return *cache_;
+}
+
+void MeshCacheProperty::initialize() {
+    addProperty(directory_);
+    addProperty(size_);
+    addProperty(hits_);
+    addProperty(misses_);
+
+    hits_.setReadOnly(true);
+    hits_.setSerializationMode(PropertySerializationMode::None);
+    misses_.setReadOnly(true);
+    misses_.setSerializationMode(PropertySerializationMode::None);
+
+    // another directory is another cache, the size limit applies to the open one at once
+    directory_.onChange([&]() { cache_.reset(); });
+    size_.onChange([&]() {
+        if (cache_) cache_->setMaxBytes(size_.get() << 20);
+    });
+}
+
+}  // namespace inviwo
@@ -0,0 +1,87 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_MESHCACHEPROPERTY_H
+#define IVW_MESHCACHEPROPERTY_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+#include <inviwo/core/properties/boolcompositeproperty.h>
+#include <inviwo/core/properties/directoryproperty.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <modules/tnm067lab2/utils/meshcache.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace inviwo {
+
+/**
+ * \class MeshCacheProperty
+ * \brief Checkable group of the options and counters of a MeshCache
+ *
+ * Holds the directory and size limit of the cache, shows its hits and misses, and opens the
+ * cache on first use. A processor builds the key of what it would extract, looks it up with find
+ * and stores the extracted mesh with insert, neither does anything while the group is unchecked.
+ */
+class IVW_MODULE_TNM067LAB2_API MeshCacheProperty : public BoolCompositeProperty {
+public:
+    virtual std::string getClassIdentifier() const override;
+    static const std::string classIdentifier;
+
+    MeshCacheProperty(const std::string& identifier, const std::string& displayName);
+    MeshCacheProperty(const MeshCacheProperty& rhs);
+    virtual MeshCacheProperty* clone() const override;
+    virtual ~MeshCacheProperty() = default;
+
+    /**
+     * The mesh stored under key, nullptr if there is none or the cache is not checked.
+     */
+    std::shared_ptr<BasicMesh> find(std::uint64_t key);
+
+    /**
+     * Stores the mesh under key, if the cache is checked.
+     */
+    void insert(std::uint64_t key, const BasicMesh& mesh);
+
+private:
+    MeshCache& getCache();
+    void initialize();
+
+    DirectoryProperty directory_;
+    IntSizeTProperty size_;  // in MB
+    IntSizeTProperty hits_;
+    IntSizeTProperty misses_;
+
+    std::unique_ptr<MeshCache> cache_;  // opened on first use
+};
+
+}  // namespace inviwo
+
+#endif  // IVW_MESHCACHEPROPERTY_H
@@ -0,0 +1,178 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/meshletmesh.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace inviwo {
+
+constexpr size_t MeshletMesh::maxVertices;
+
+MeshletMesh::MeshletMesh(const BasicMesh& mesh, size3_t grid, size_t meshletVertices)
+    : meshlets_()
+    , quantized_(false)
+    , positions_()
+    , quantizedPositions_()
+    , quantizationScale_(1.0f)
+    , normals_()
+    , indices_()
+    , layerColors_()
+    , modelMatrix_(mesh.getModelMatrix())
+    , worldMatrix_(mesh.getWorldMatrix()) {
+    const auto& positions = mesh.getVertices()->getRAMRepresentation()->getDataContainer();
+    const auto& normals = mesh.getNormals()->getRAMRepresentation()->getDataContainer();
+    const auto& colors = mesh.getColors()->getRAMRepresentation()->getDataContainer();
+
+    // as many steps between two voxels as fit in 16 bits for the whole grid
+    quantized_ = grid != size3_t(0) && glm::all(glm::lessThanEqual(grid, size3_t(65536)));
+    vec3 steps(1.0f);
+    if (quantized_) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const size_t cells = std::max<size_t>(grid[axis], 2) - 1;
+            steps[axis] = static_cast<float>(cells * (65535 / cells));
+            quantizationScale_[axis] = 1.0f / steps[axis];
+        }
+    }
+    auto addVertex = [&](std::uint32_t vertex) {
+        const vec3 pos = positions[vertex];
+        if (quantized_) {
+            quantizedPositions_.emplace_back(
+                glm::clamp(glm::round(pos * steps), vec3(0.0f), vec3(65535.0f)));
+        } else {
+            positions_.push_back(pos);
+        }
+        normals_.push_back(normals[vertex]);
+    };
+
+    // local index of each vertex of the mesh in the current meshlet, valid if the vertex is in
+    // the vertices of the meshlet
+    std::vector<std::uint16_t> local(positions.size(), 0);
+    meshletVertices = glm::clamp<size_t>(meshletVertices, 3, maxVertices);
+    std::vector<std::uint32_t> vertices;
+    vertices.reserve(meshletVertices);
+    auto isInMeshlet = [&](std::uint32_t vertex) {
+        return local[vertex] < vertices.size() && vertices[local[vertex]] == vertex;
+    };
+
+    for (size_t layer = 0; layer < mesh.getNumberOfIndicies(); ++layer) {
+        const auto& indices = mesh.getIndices(layer)->getRAMRepresentation()->getDataContainer();
+        layerColors_.push_back(indices.empty() ? vec4(0.7f, 0.7f, 0.7f, 1.0f)
+                                               : colors[indices.front()]);
+
+        auto beginMeshlet = [&]() {
+            vertices.clear();
+            meshlets_.push_back({static_cast<std::uint32_t>(normals_.size()), 0,
+                                 static_cast<std::uint32_t>(indices_.size()), 0,
+                                 static_cast<std::uint32_t>(layer)});
+        };
+        if (!indices.empty()) beginMeshlet();
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            size_t added = 0;
+            for (size_t j = 0; j < 3; ++j) {
+                const auto vertex = indices[i + j];
+                if (!isInMeshlet(vertex) &&
+                    std::find(&indices[i], &indices[i + j], vertex) == &indices[i + j]) {
+                    ++added;
+                }
+            }
+            if (vertices.size() + added > meshletVertices) beginMeshlet();
+
+            auto& meshlet = meshlets_.back();
+            for (size_t j = 0; j < 3; ++j) {
+                const auto vertex = indices[i + j];
+                if (!isInMeshlet(vertex)) {
+                    local[vertex] = static_cast<std::uint16_t>(vertices.size());
+                    vertices.push_back(vertex);
+                    addVertex(vertex);
+                }
+                indices_.push_back(local[vertex]);
+            }
+            meshlet.vertexCount = static_cast<std::uint32_t>(vertices.size());
+            meshlet.indexCount += 3;
+        }
+    }
+}
+
+size_t MeshletMesh::getSizeInBytes() const {
+    return positions_.size() * sizeof(vec3) + quantizedPositions_.size() * sizeof(glm::u16vec3) +
+           normals_.size() * sizeof(vec3) + indices_.size() * sizeof(std::uint16_t) +
+           meshlets_.size() * sizeof(Meshlet) + layerColors_.size() * sizeof(vec4);
+}
+
+size_t MeshletMesh::getSizeInBytes(const BasicMesh& mesh) {
+    size_t size = mesh.getVertices()->getSize() * sizeof(vec3) +
+                  mesh.getNormals()->getSize() * sizeof(vec3) +
+                  mesh.getTexCoords()->getSize() * sizeof(vec3) +
+                  mesh.getColors()->getSize() * sizeof(vec4);
+    for (size_t i = 0; i < mesh.getNumberOfIndicies(); ++i) {
+        size += mesh.getIndices(i)->getSize() * sizeof(std::uint32_t);
+    }
+    return size;
+}
+
+std::shared_ptr<BasicMesh> MeshletMesh::toBasicMesh() const {
+    auto mesh = std::make_shared<BasicMesh>();
+    mesh->setModelMatrix(modelMatrix_);
+    mesh->setWorldMatrix(worldMatrix_);
+    auto& positions =
+        mesh->getEditableVertices()->getEditableRAMRepresentation()->getDataContainer();
+    auto& normals = mesh->getEditableNormals()->getEditableRAMRepresentation()->getDataContainer();
+    auto& texCoords =
+        mesh->getEditableTexCoords()->getEditableRAMRepresentation()->getDataContainer();
+    auto& colors = mesh->getEditableColors()->getEditableRAMRepresentation()->getDataContainer();
+    positions.reserve(getVertexCount());
+    normals.reserve(getVertexCount());
+    texCoords.reserve(getVertexCount());
+    colors.reserve(getVertexCount());
+
+    std::vector<std::vector<std::uint32_t>*> indexBuffers;
+    for (size_t layer = 0; layer < getNumberOfLayers(); ++layer) {
+        indexBuffers.push_back(
+            &mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)->getDataContainer());
+    }
+    for (const auto& meshlet : meshlets_) {
+        for (size_t i = 0; i < meshlet.vertexCount; ++i) {
+            const size_t vertex = meshlet.firstVertex + i;
+            positions.push_back(getPosition(vertex));
+            normals.push_back(normals_[vertex]);
+            texCoords.push_back(positions.back());
+            colors.push_back(layerColors_[meshlet.layer]);
+        }
+        auto& indices = *indexBuffers[meshlet.layer];
+        for (size_t i = 0; i < meshlet.indexCount; ++i) {
+            indices.push_back(meshlet.firstVertex + indices_[meshlet.firstIndex + i]);
+        }
+    }
+    return mesh;
+}
+
+}  // namespace inviwo
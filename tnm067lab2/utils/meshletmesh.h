@@ -0,0 +1,138 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_MESHLETMESH_H
+#define IVW_MESHLETMESH_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+#include <inviwo/core/datastructures/geometry/basicmesh.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * \class MeshletMesh
+ * \brief Compact copy of an extracted mesh as meshlets with 16-bit local indices
+ *
+ * The triangles of each index buffer are split, in order, into meshlets of at most maxVertices
+ * vertices each, or fewer if asked for, with indices relative to the first vertex of the
+ * meshlet. Vertices used by several meshlets are stored once for each of them. Only positions
+ * and normals are kept per vertex, the texture coordinates of the extracted meshes are the
+ * positions and the color is constant for each index buffer. Positions can be quantized to 16
+ * bits per axis on the voxel grid they were extracted from, with as many steps between two
+ * voxels as fits.
+ */
+class IVW_MODULE_TNM067LAB2_API MeshletMesh {
+public:
+    static constexpr size_t maxVertices = 65536;
+
+    struct Meshlet {
+        std::uint32_t firstVertex;
+        std::uint32_t vertexCount;
+        std::uint32_t firstIndex;
+        std::uint32_t indexCount;
+        std::uint32_t layer;  // index buffer of the mesh the triangles came from
+    };
+
+    /**
+     * Packs the mesh. If grid is not zero the positions, in [0, 1] over a volume of grid voxels,
+     * are quantized to it, as long as it has at most 65536 voxels along each axis. Meshlets get
+     * at most meshletVertices vertices, which is limited to maxVertices.
+     */
+    explicit MeshletMesh(const BasicMesh& mesh, size3_t grid = size3_t(0),
+                         size_t meshletVertices = maxVertices);
+
+    const std::vector<Meshlet>& getMeshlets() const;
+    size_t getNumberOfLayers() const;
+    vec4 getLayerColor(size_t layer) const;
+    size_t getVertexCount() const;
+    bool isQuantized() const;
+
+    /**
+     * Position of the vertex, decoded if quantized.
+     */
+    vec3 getPosition(size_t vertex) const;
+    const std::vector<vec3>& getNormals() const;
+    const std::vector<std::uint16_t>& getIndices() const;
+
+    /**
+     * Memory used by the vertices, indices and meshlets.
+     */
+    size_t getSizeInBytes() const;
+
+    /**
+     * Memory used by the buffers of a mesh, for comparing with getSizeInBytes.
+     */
+    static size_t getSizeInBytes(const BasicMesh& mesh);
+
+    /**
+     * Expands the meshlets into a BasicMesh again, with one index buffer per layer.
+     */
+    std::shared_ptr<BasicMesh> toBasicMesh() const;
+
+private:
+    std::vector<Meshlet> meshlets_;
+    bool quantized_;
+    std::vector<vec3> positions_;  // one of the two, depending on quantized_
+    std::vector<glm::u16vec3> quantizedPositions_;
+    vec3 quantizationScale_;  // from quantized positions to [0, 1]
+    std::vector<vec3> normals_;
+    std::vector<std::uint16_t> indices_;
+    std::vector<vec4> layerColors_;
+    mat4 modelMatrix_;
+    mat4 worldMatrix_;
+};
+
+inline const std::vector<MeshletMesh::Meshlet>& MeshletMesh::getMeshlets() const {
+    return meshlets_;
+}
+
+inline size_t MeshletMesh::getNumberOfLayers() const { return layerColors_.size(); }
+
+inline vec4 MeshletMesh::getLayerColor(size_t layer) const { return layerColors_[layer]; }
+
+inline size_t MeshletMesh::getVertexCount() const { return normals_.size(); }
+
+inline bool MeshletMesh::isQuantized() const { return quantized_; }
+
+inline vec3 MeshletMesh::getPosition(size_t vertex) const {
+    return quantized_ ? vec3(quantizedPositions_[vertex]) * quantizationScale_
+                      : positions_[vertex];
+}
+
+inline const std::vector<vec3>& MeshletMesh::getNormals() const { return normals_; }
+
+inline const std::vector<std::uint16_t>& MeshletMesh::getIndices() const { return indices_; }
+
+}  // namespace inviwo
+
+#endif  // IVW_MESHLETMESH_H
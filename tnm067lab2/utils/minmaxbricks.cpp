@@ -0,0 +1,102 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/minmaxbricks.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+#include <inviwo/core/util/indexmapper.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace inviwo {
+
+constexpr size_t MinMaxBricks::brickSize;
+
+MinMaxBricks::MinMaxBricks(const VolumeRAM& volume) : dims_(0), ranges_() {
+    const size3_t dims = volume.getDimensions();
+    for (size_t axis = 0; axis < 3; ++axis) {
+        const size_t cells = dims[axis] > 1 ? dims[axis] - 1 : 0;
+        dims_[axis] = (cells + brickSize - 1) / brickSize;
+    }
+    ranges_.resize(dims_.x * dims_.y * dims_.z,
+                   vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()));
+
+    volume.dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+        const auto data = vrprecision->getDataTyped();
+        util::IndexMapper3D indexMapper(dims);
+
+        size3_t brick;
+        for (brick.z = 0; brick.z < dims_.z; ++brick.z) {
+            for (brick.y = 0; brick.y < dims_.y; ++brick.y) {
+                for (brick.x = 0; brick.x < dims_.x; ++brick.x) {
+                    const size3_t begin = brick * brickSize;
+                    const size3_t end = glm::min(begin + size3_t(brickSize + 1), dims);
+                    vec2& range = ranges_[brick.x + dims_.x * (brick.y + dims_.y * brick.z)];
+
+                    size3_t pos;
+                    for (pos.z = begin.z; pos.z < end.z; ++pos.z) {
+                        for (pos.y = begin.y; pos.y < end.y; ++pos.y) {
+                            const size_t row = indexMapper(size3_t(0, pos.y, pos.z));
+                            for (pos.x = begin.x; pos.x < end.x; ++pos.x) {
+                                const float value = static_cast<float>(data[row + pos.x]);
+                                range.x = std::min(range.x, value);
+                                range.y = std::max(range.y, value);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+const size3_t& MinMaxBricks::getDimensions() const { return dims_; }
+
+float MinMaxBricks::getSkippedFraction(float iso) const {
+    return getSkippedFraction(std::vector<float>{iso});
+}
+
+float MinMaxBricks::getSkippedFraction(const std::vector<float>& isos) const {
+    if (ranges_.empty()) return 0.0f;
+
+    size_t skipped = 0;
+    size3_t brick;
+    for (brick.z = 0; brick.z < dims_.z; ++brick.z) {
+        for (brick.y = 0; brick.y < dims_.y; ++brick.y) {
+            for (brick.x = 0; brick.x < dims_.x; ++brick.x) {
+                if (!isActive(brick, isos)) ++skipped;
+            }
+        }
+    }
+    return static_cast<float>(skipped) / static_cast<float>(ranges_.size());
+}
+
+}  // namespace inviwo
@@ -0,0 +1,108 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_MINMAXBRICKS_H
+#define IVW_MINMAXBRICKS_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+namespace inviwo {
+
+class VolumeRAM;
+
+/**
+ * \class MinMaxBricks
+ * \brief Value range of each brick of brickSize^3 cells of a volume
+ *
+ * The range of a brick includes the voxels on its far faces, which it shares with the next
+ * bricks, so it covers every corner of its cells. A brick whose range does not straddle an iso
+ * value has all its corners on the same side of it and contains no part of that iso-surface.
+ */
+class IVW_MODULE_TNM067LAB2_API MinMaxBricks {
+public:
+    static constexpr size_t brickSize = 8;
+
+    explicit MinMaxBricks(const VolumeRAM& volume);
+
+    /**
+     * Number of bricks along each axis.
+     */
+    const size3_t& getDimensions() const;
+
+    /**
+     * Min and max value of the voxels of the brick.
+     */
+    const vec2& getRange(const size3_t& brick) const;
+
+    /**
+     * Whether the brick might contain a part of the iso-surface, i.e. has corners both below
+     * and not below iso. Uses the same comparison as the case classification.
+     */
+    bool isActive(const size3_t& brick, float iso) const;
+
+    /**
+     * Whether the brick is active for any of the iso values.
+     */
+    bool isActive(const size3_t& brick, const std::vector<float>& isos) const;
+
+    /**
+     * Fraction of the bricks that are not active for iso.
+     */
+    float getSkippedFraction(float iso) const;
+
+    /**
+     * Fraction of the bricks that are not active for any of the iso values.
+     */
+    float getSkippedFraction(const std::vector<float>& isos) const;
+
+private:
+    size3_t dims_;
+    std::vector<vec2> ranges_;
+};
+
+inline const vec2& MinMaxBricks::getRange(const size3_t& brick) const {
+    return ranges_[brick.x + dims_.x * (brick.y + dims_.y * brick.z)];
+}
+
+inline bool MinMaxBricks::isActive(const size3_t& brick, float iso) const {
+    const vec2& range = getRange(brick);
+    return range.x < iso && !(range.y < iso);
+}
+
+inline bool MinMaxBricks::isActive(const size3_t& brick, const std::vector<float>& isos) const {
+    for (auto iso : isos) {
+        if (isActive(brick, iso)) return true;
+    }
+    return false;
+}
+
+}  // namespace inviwo
+
+#endif  // IVW_MINMAXBRICKS_H
@@ -0,0 +1,362 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/quadricsimplifier.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+namespace inviwo {
+
+constexpr std::uint32_t QuadricSimplifier::invalid;
+
+namespace {
+
+// Collapses may not turn a triangle by more than about 80 degrees
+constexpr float minCosine = 0.2f;
+
+bool contains(const QuadricSimplifier::Triangle& triangle, std::uint32_t vertex) {
+    return triangle.v[0] == vertex || triangle.v[1] == vertex || triangle.v[2] == vertex;
+}
+
+}  // namespace
+
+QuadricSimplifier::Quadric& QuadricSimplifier::Quadric::operator+=(const Quadric& q) {
+    a += q.a;
+    b += q.b;
+    c += q.c;
+    return *this;
+}
+
+double QuadricSimplifier::Quadric::error(const dvec3& p) const {
+    return glm::dot(p, a * p) + 2.0 * glm::dot(b, p) + c;
+}
+
+std::vector<bool> QuadricSimplifier::findBoundary(size_t vertexCount,
+                                                  const std::vector<Triangle>& triangles) {
+    std::vector<std::uint64_t> edges;
+    edges.reserve(3 * triangles.size());
+    for (const auto& triangle : triangles) {
+        for (size_t i = 0; i < 3; ++i) {
+            const std::uint64_t a = triangle.v[i];
+            const std::uint64_t b = triangle.v[(i + 1) % 3];
+            edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<bool> boundary(vertexCount, false);
+    for (auto it = edges.begin(); it != edges.end();) {
+        const auto next = std::upper_bound(it, edges.end(), *it);
+        if (next - it == 1) {
+            boundary[*it >> 32] = true;
+            boundary[*it & 0xffffffff] = true;
+        }
+        it = next;
+    }
+    return boundary;
+}
+
+QuadricSimplifier::QuadricSimplifier(std::vector<BasicMesh::Vertex> vertices,
+                                     std::vector<Triangle> triangles, std::vector<bool> locked)
+    : vertices_(std::move(vertices))
+    , triangles_(std::move(triangles))
+    , locked_(std::move(locked))
+    , quadrics_(vertices_.size())
+    , vertexTriangles_(vertices_.size())
+    , versions_(vertices_.size(), 0)
+    , heap_()
+    , triangleCount_(triangles_.size()) {
+
+    for (size_t t = 0; t < triangles_.size(); ++t) {
+        const auto& v = triangles_[t].v;
+        const dvec3 p0(std::get<0>(vertices_[v[0]]));
+        const dvec3 p1(std::get<0>(vertices_[v[1]]));
+        const dvec3 p2(std::get<0>(vertices_[v[2]]));
+        for (size_t i = 0; i < 3; ++i) {
+            vertexTriangles_[v[i]].push_back(static_cast<std::uint32_t>(t));
+        }
+
+        dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(n);
+        if (length == 0.0) continue;
+        n /= length;
+        const double area = 0.5 * length;
+        const double d = -glm::dot(n, p0);
+
+        Quadric plane;
+        plane.a = area * glm::outerProduct(n, n);
+        plane.b = area * d * n;
+        plane.c = area * d * d;
+        for (size_t i = 0; i < 3; ++i) {
+            quadrics_[v[i]] += plane;
+        }
+    }
+
+    for (const auto& triangle : triangles_) {
+        for (size_t i = 0; i < 3; ++i) {
+            const auto a = triangle.v[i];
+            const auto b = triangle.v[(i + 1) % 3];
+            Collapse collapse;
+            // Edges shared by two consistently wound triangles are only pushed once
+            if (a < b && findCollapse(a, b, collapse)) heap_.push_back(collapse);
+        }
+    }
+    std::make_heap(heap_.begin(), heap_.end());
+}
+
+size_t QuadricSimplifier::simplify(size_t targetTriangles) {
+    while (triangleCount_ > targetTriangles && !heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end());
+        const Collapse next = heap_.back();
+        heap_.pop_back();
+
+        // Stale if either vertex changed since the collapse was computed
+        if (versions_[next.keep] != next.keepVersion ||
+            versions_[next.remove] != next.removeVersion) {
+            continue;
+        }
+        if (canCollapse(next)) collapse(next);
+    }
+    return triangleCount_;
+}
+
+size_t QuadricSimplifier::getTriangleCount() const { return triangleCount_; }
+
+std::vector<std::uint32_t> QuadricSimplifier::compact() {
+    std::vector<std::uint32_t> remap(vertices_.size(), invalid);
+    for (const auto& triangle : triangles_) {
+        if (triangle.layer == invalid) continue;
+        for (const auto v : triangle.v) remap[v] = 0;
+    }
+
+    std::vector<BasicMesh::Vertex> vertices;
+    for (size_t i = 0; i < vertices_.size(); ++i) {
+        if (remap[i] == invalid) continue;
+        remap[i] = static_cast<std::uint32_t>(vertices.size());
+        vertices.push_back(vertices_[i]);
+    }
+
+    std::vector<Triangle> triangles;
+    triangles.reserve(triangleCount_);
+    for (const auto& triangle : triangles_) {
+        if (triangle.layer == invalid) continue;
+        triangles.push_back(
+            {{remap[triangle.v[0]], remap[triangle.v[1]], remap[triangle.v[2]]}, triangle.layer});
+    }
+
+    std::vector<bool> locked(vertices.size());
+    for (size_t i = 0; i < remap.size(); ++i) {
+        if (remap[i] != invalid) locked[remap[i]] = locked_[i];
+    }
+
+    vertices_ = std::move(vertices);
+    triangles_ = std::move(triangles);
+    locked_ = std::move(locked);
+    quadrics_.clear();
+    vertexTriangles_.clear();
+    versions_.clear();
+    heap_.clear();
+    return remap;
+}
+
+const std::vector<BasicMesh::Vertex>& QuadricSimplifier::getVertices() const {
+    return vertices_;
+}
+
+const std::vector<QuadricSimplifier::Triangle>& QuadricSimplifier::getTriangles() const {
+    return triangles_;
+}
+
+bool QuadricSimplifier::isRemoved(std::uint32_t triangle) const {
+    return triangles_[triangle].layer == invalid;
+}
+
+/*
+ * The collapse of the edge between a and b into the position with the least error, or into the
+ * locked one of them. Returns false if both are locked.
+ */
+bool QuadricSimplifier::findCollapse(std::uint32_t a, std::uint32_t b,
+                                     Collapse& collapse) const {
+    if (locked_[a] && locked_[b]) return false;
+    if (locked_[b]) std::swap(a, b);
+
+    Quadric q = quadrics_[a];
+    q += quadrics_[b];
+    const dvec3 pa(std::get<0>(vertices_[a]));
+    const dvec3 pb(std::get<0>(vertices_[b]));
+
+    dvec3 pos = pa;
+    if (!locked_[a]) {
+        const dvec3 mid = 0.5 * (pa + pb);
+        const double trace = q.a[0][0] + q.a[1][1] + q.a[2][2];
+        const double det = glm::determinant(q.a);
+        bool solved = false;
+        // The minimum is only well defined if the planes are not close to parallel, and it is
+        // only used if it stays near the edge
+        if (trace > 0.0 && std::abs(det) > 1e-9 * std::pow(trace / 3.0, 3.0)) {
+            const dvec3 optimum = -(glm::inverse(q.a) * q.b);
+            if (glm::distance(optimum, mid) <= glm::distance(pa, pb)) {
+                pos = optimum;
+                solved = true;
+            }
+        }
+        if (!solved) {
+            for (const auto& candidate : {pb, mid}) {
+                if (q.error(candidate) < q.error(pos)) pos = candidate;
+            }
+        }
+    }
+
+    collapse.error = std::max(0.0, q.error(pos));
+    collapse.keep = a;
+    collapse.remove = b;
+    collapse.keepVersion = versions_[a];
+    collapse.removeVersion = versions_[b];
+    collapse.pos = vec3(pos);
+    return true;
+}
+
+/*
+ * A collapse has to keep the mesh manifold, i.e. the vertices around both ends may only have
+ * the ones of the triangles of the edge in common, and may not flip any remaining triangle.
+ */
+bool QuadricSimplifier::canCollapse(const Collapse& c) const {
+    std::vector<std::uint32_t> around[2];
+    size_t edgeTriangles = 0;
+    for (size_t end = 0; end < 2; ++end) {
+        const auto vertex = end == 0 ? c.keep : c.remove;
+        for (const auto t : vertexTriangles_[vertex]) {
+            if (isRemoved(t)) continue;
+            const auto& triangle = triangles_[t];
+            if (end == 0 && contains(triangle, c.remove)) ++edgeTriangles;
+            for (const auto v : triangle.v) {
+                if (v != c.keep && v != c.remove) around[end].push_back(v);
+            }
+        }
+        std::sort(around[end].begin(), around[end].end());
+        around[end].erase(std::unique(around[end].begin(), around[end].end()), around[end].end());
+    }
+    std::vector<std::uint32_t> shared;
+    std::set_intersection(around[0].begin(), around[0].end(), around[1].begin(), around[1].end(),
+                          std::back_inserter(shared));
+    if (shared.size() != edgeTriangles) return false;
+    // A tetrahedron would fold into two triangles back to back
+    if (around[0].size() == edgeTriangles && around[1].size() == edgeTriangles) return false;
+
+    for (const auto vertex : {c.keep, c.remove}) {
+        for (const auto t : vertexTriangles_[vertex]) {
+            if (isRemoved(t)) continue;
+            const auto& triangle = triangles_[t];
+            if (contains(triangle, c.keep) && contains(triangle, c.remove)) continue;
+
+            vec3 before[3];
+            vec3 after[3];
+            for (size_t i = 0; i < 3; ++i) {
+                before[i] = std::get<0>(vertices_[triangle.v[i]]);
+                after[i] = triangle.v[i] == vertex ? c.pos : before[i];
+            }
+            const vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+            const float length = glm::length(n0);
+            if (length > 0.0f && glm::dot(n0, n1) <= minCosine * length * glm::length(n1)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void QuadricSimplifier::collapse(const Collapse& c) {
+    auto& keep = vertices_[c.keep];
+    const auto& remove = vertices_[c.remove];
+
+    // The attributes are interpolated at the projection of the new position onto the edge
+    const vec3 edge = std::get<0>(remove) - std::get<0>(keep);
+    const float length2 = glm::dot(edge, edge);
+    const float t =
+        length2 > 0.0f
+            ? glm::clamp(glm::dot(c.pos - std::get<0>(keep), edge) / length2, 0.0f, 1.0f)
+            : 0.0f;
+    const vec3 normal = glm::mix(std::get<1>(keep), std::get<1>(remove), t);
+    std::get<0>(keep) = c.pos;
+    if (glm::length(normal) > 0.0f) std::get<1>(keep) = glm::normalize(normal);
+    std::get<2>(keep) = glm::mix(std::get<2>(keep), std::get<2>(remove), t);
+    std::get<3>(keep) = glm::mix(std::get<3>(keep), std::get<3>(remove), t);
+    quadrics_[c.keep] += quadrics_[c.remove];
+
+    auto& keepTriangles = vertexTriangles_[c.keep];
+    for (const auto t : vertexTriangles_[c.remove]) {
+        if (isRemoved(t)) continue;
+        auto& triangle = triangles_[t];
+        if (contains(triangle, c.keep)) {
+            triangle.layer = invalid;
+            --triangleCount_;
+            for (const auto v : triangle.v) {
+                if (v == c.keep || v == c.remove) continue;
+                auto& other = vertexTriangles_[v];
+                other.erase(std::remove(other.begin(), other.end(), t), other.end());
+            }
+        } else {
+            std::replace(std::begin(triangle.v), std::end(triangle.v), c.remove, c.keep);
+            keepTriangles.push_back(t);
+        }
+    }
+    keepTriangles.erase(std::remove_if(keepTriangles.begin(), keepTriangles.end(),
+                                       [&](std::uint32_t t) { return isRemoved(t); }),
+                        keepTriangles.end());
+    std::vector<std::uint32_t>().swap(vertexTriangles_[c.remove]);
+
+    versions_[c.remove] = invalid;
+    ++versions_[c.keep];
+    pushCollapses(c.keep);
+}
+
+void QuadricSimplifier::pushCollapses(std::uint32_t vertex) {
+    std::vector<std::uint32_t> around;
+    for (const auto t : vertexTriangles_[vertex]) {
+        for (const auto v : triangles_[t].v) {
+            if (v != vertex) around.push_back(v);
+        }
+    }
+    std::sort(around.begin(), around.end());
+    around.erase(std::unique(around.begin(), around.end()), around.end());
+
+    for (const auto v : around) {
+        Collapse collapse;
+        if (findCollapse(vertex, v, collapse)) {
+            heap_.push_back(collapse);
+            std::push_heap(heap_.begin(), heap_.end());
+        }
+    }
+}
+
+}  // namespace inviwo
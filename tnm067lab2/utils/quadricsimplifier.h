@@ -0,0 +1,136 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_QUADRICSIMPLIFIER_H
+#define IVW_QUADRICSIMPLIFIER_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+#include <inviwo/core/datastructures/geometry/basicmesh.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * \class QuadricSimplifier
+ * \brief Edge collapse simplification of a triangle mesh by the quadric error metric
+ *
+ * Every vertex gets the sum of the area weighted quadrics of the planes of its triangles, as in
+ * Garland and Heckbert, Surface Simplification Using Quadric Error Metrics, 1997. Edges are
+ * collapsed in order of increasing error into the position that minimizes the summed quadric of
+ * their vertices, as long as the collapse keeps the mesh manifold and flips no triangle. The
+ * other vertex attributes are interpolated along the edge. Locked vertices are never moved or
+ * removed, edges to them collapse into them.
+ */
+class IVW_MODULE_TNM067LAB2_API QuadricSimplifier {
+public:
+    static constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+
+    struct Triangle {
+        std::uint32_t v[3];
+        std::uint32_t layer;  // index buffer the triangle belongs to, invalid once collapsed
+    };
+
+    /**
+     * Whether each vertex is on an edge that only one triangle has, i.e. on the boundary of the
+     * mesh.
+     */
+    static std::vector<bool> findBoundary(size_t vertexCount,
+                                          const std::vector<Triangle>& triangles);
+
+    /**
+     * locked has one entry per vertex.
+     */
+    QuadricSimplifier(std::vector<BasicMesh::Vertex> vertices, std::vector<Triangle> triangles,
+                      std::vector<bool> locked);
+
+    /**
+     * Collapses edges until at most targetTriangles triangles are left or no edge can be
+     * collapsed anymore. Returns the number of triangles left.
+     */
+    size_t simplify(size_t targetTriangles);
+
+    size_t getTriangleCount() const;
+
+    /**
+     * Removes the collapsed vertices and triangles, keeping the order of the others, and ends
+     * the simplification. Returns the new index of each of the previous vertices, invalid for
+     * removed ones.
+     */
+    std::vector<std::uint32_t> compact();
+
+    const std::vector<BasicMesh::Vertex>& getVertices() const;
+    const std::vector<Triangle>& getTriangles() const;
+
+private:
+    /**
+     * Symmetric 4x4 quadric, error(p) = p^T A p + 2 b^T p + c.
+     */
+    struct Quadric {
+        dmat3 a = dmat3(0.0);
+        dvec3 b = dvec3(0.0);
+        double c = 0.0;
+
+        Quadric& operator+=(const Quadric& q);
+        double error(const dvec3& p) const;
+    };
+
+    struct Collapse {
+        double error;
+        std::uint32_t keep;
+        std::uint32_t remove;
+        std::uint32_t keepVersion;
+        std::uint32_t removeVersion;
+        vec3 pos;
+
+        bool operator<(const Collapse& rhs) const { return error > rhs.error; }
+    };
+
+    bool isRemoved(std::uint32_t triangle) const;
+    bool findCollapse(std::uint32_t a, std::uint32_t b, Collapse& collapse) const;
+    bool canCollapse(const Collapse& collapse) const;
+    void collapse(const Collapse& collapse);
+    void pushCollapses(std::uint32_t vertex);
+
+    std::vector<BasicMesh::Vertex> vertices_;
+    std::vector<Triangle> triangles_;
+    std::vector<bool> locked_;
+    std::vector<Quadric> quadrics_;
+    std::vector<std::vector<std::uint32_t>> vertexTriangles_;  // triangles around each vertex
+    std::vector<std::uint32_t> versions_;  // bumped when a vertex changes, invalid if removed
+    std::vector<Collapse> heap_;
+    size_t triangleCount_;
+};
+
+}  // namespace inviwo
+
+#endif  // IVW_QUADRICSIMPLIFIER_H
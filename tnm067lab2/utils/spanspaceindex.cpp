@@ -0,0 +1,163 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#include <modules/tnm067lab2/utils/spanspaceindex.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+
+namespace inviwo {
+
+constexpr size_t SpanSpaceIndex::none;
+
+SpanSpaceIndex::SpanSpaceIndex(const VolumeRAM& volume) : nodes_(), byMin_(), byMax_() {
+    const size3_t dims = volume.getDimensions();
+    if (!canIndex(dims)) {
+        throw Exception("Volume has too many voxels for a span space index",
+                        IVW_CONTEXT_CUSTOM("SpanSpaceIndex"));
+    }
+
+    std::vector<Interval> intervals;
+    volume.dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+        const auto data = vrprecision->getDataTyped();
+        const size_t strideY = dims.x;
+        const size_t strideZ = dims.x * dims.y;
+        const size_t offsets[8] = {0,       1,           strideY,           strideY + 1,
+                                   strideZ, strideZ + 1, strideZ + strideY, strideZ + strideY + 1};
+
+        size3_t pos;
+        for (pos.z = 0; pos.z + 1 < dims.z; ++pos.z) {
+            for (pos.y = 0; pos.y + 1 < dims.y; ++pos.y) {
+                for (pos.x = 0; pos.x + 1 < dims.x; ++pos.x) {
+                    const size_t index = pos.x + strideY * pos.y + strideZ * pos.z;
+                    float min = static_cast<float>(data[index]);
+                    float max = min;
+                    for (size_t corner = 1; corner < 8; ++corner) {
+                        const float value = static_cast<float>(data[index + offsets[corner]]);
+                        min = std::min(min, value);
+                        max = std::max(max, value);
+                    }
+                    if (min < max) {
+                        intervals.push_back({min, max, static_cast<std::uint32_t>(index)});
+                    }
+                }
+            }
+        }
+    });
+
+    byMin_.resize(intervals.size());
+    byMax_.resize(intervals.size());
+    build(intervals.begin(), intervals.end());
+}
+
+bool SpanSpaceIndex::canIndex(const size3_t& dims) {
+    return dims.x * dims.y * dims.z <= std::numeric_limits<std::uint32_t>::max();
+}
+
+size_t SpanSpaceIndex::maxSizeInBytes(const size3_t& dims) {
+    const size3_t cells = glm::max(dims, size3_t(1)) - size3_t(1);
+    return cells.x * cells.y * cells.z * (sizeof(Interval) + 2 * sizeof(Entry));
+}
+
+size_t SpanSpaceIndex::size() const { return byMin_.size(); }
+
+size_t SpanSpaceIndex::getSizeInBytes() const {
+    return nodes_.size() * sizeof(Node) + (byMin_.size() + byMax_.size()) * sizeof(Entry);
+}
+
+size_t SpanSpaceIndex::build(std::vector<Interval>::iterator begin,
+                             std::vector<Interval>::iterator end) {
+    if (begin == end) return none;
+
+    // splitting at the median center leaves at most half of the intervals to each child
+    auto center = [](const Interval& i) { return 0.5f * (i.min + i.max); };
+    auto median = begin + (end - begin) / 2;
+    std::nth_element(begin, median, end, [&](const Interval& a, const Interval& b) {
+        return center(a) < center(b);
+    });
+    const float split = center(*median);
+
+    auto leftEnd = std::partition(begin, end, [&](const Interval& i) { return i.max < split; });
+    auto rightBegin =
+        std::partition(leftEnd, end, [&](const Interval& i) { return !(split < i.min); });
+
+    // the intervals of the node go to the same place in both lists, after those of the nodes
+    // built so far
+    const size_t nodeBegin = nodes_.empty() ? 0 : nodes_.back().end;
+    const size_t nodeEnd = nodeBegin + static_cast<size_t>(rightBegin - leftEnd);
+    const size_t node = nodes_.size();
+    nodes_.push_back({split, nodeBegin, nodeEnd, none, none});
+
+    auto minIt = byMin_.begin() + nodeBegin;
+    auto maxIt = byMax_.begin() + nodeBegin;
+    for (auto it = leftEnd; it != rightBegin; ++it, ++minIt, ++maxIt) {
+        *minIt = {it->min, it->cell};
+        *maxIt = {it->max, it->cell};
+    }
+    std::sort(byMin_.begin() + nodeBegin, byMin_.begin() + nodeEnd,
+              [](const Entry& a, const Entry& b) { return a.value < b.value; });
+    std::sort(byMax_.begin() + nodeBegin, byMax_.begin() + nodeEnd,
+              [](const Entry& a, const Entry& b) { return b.value < a.value; });
+
+    const size_t left = build(begin, leftEnd);
+    const size_t right = build(rightBegin, end);
+    nodes_[node].left = left;
+    nodes_[node].right = right;
+    return node;
+}
+
+std::vector<std::uint32_t> SpanSpaceIndex::query(float iso) const {
+    std::vector<std::uint32_t> cells;
+
+    // a cell is intersected if min < iso <= max. The intervals of a node all contain its
+    // center, so below the center only min has to be checked and otherwise only max.
+    size_t node = nodes_.empty() ? none : 0;
+    while (node != none) {
+        const Node& n = nodes_[node];
+        if (!(n.center < iso)) {
+            for (size_t i = n.begin; i < n.end && byMin_[i].value < iso; ++i) {
+                cells.push_back(byMin_[i].cell);
+            }
+            node = n.left;
+        } else {
+            for (size_t i = n.begin; i < n.end && !(byMax_[i].value < iso); ++i) {
+                cells.push_back(byMax_[i].cell);
+            }
+            node = n.right;
+        }
+    }
+
+    std::sort(cells.begin(), cells.end());
+    return cells;
+}
+
+}  // namespace inviwo
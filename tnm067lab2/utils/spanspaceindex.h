@@ -0,0 +1,112 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+#ifndef IVW_SPANSPACEINDEX_H
+#define IVW_SPANSPACEINDEX_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+#include <limits>
+
+namespace inviwo {
+
+class VolumeRAM;
+
+/**
+ * \class SpanSpaceIndex
+ * \brief Interval tree over the value ranges of the cells of a volume
+ *
+ * Every cell is stored with the range spanned by its eight corners in the node of the tree whose
+ * center lies in that range, once sorted by minimum and once by maximum. A query walks a single
+ * path down the tree and stops scanning each node's list at the first cell that does not
+ * intersect the iso value, so it costs O(log n + k) for k intersected cells. Cells whose corners
+ * are all equal can not be intersected by any iso value and are left out.
+ */
+class IVW_MODULE_TNM067LAB2_API SpanSpaceIndex {
+public:
+    explicit SpanSpaceIndex(const VolumeRAM& volume);
+
+    /**
+     * Cells are identified by the 1D-index of their first voxel, so the volume can have at most
+     * 2^32 voxels.
+     */
+    static bool canIndex(const size3_t& dims);
+
+    /**
+     * Memory needed at most to build the index of a volume with dims voxels, which is reached
+     * if none of its cells are flat. The intervals used while building are included.
+     */
+    static size_t maxSizeInBytes(const size3_t& dims);
+
+    /**
+     * Number of cells in the index.
+     */
+    size_t size() const;
+
+    /**
+     * Memory used by the index.
+     */
+    size_t getSizeInBytes() const;
+
+    /**
+     * The cells intersected by iso, i.e. with corners both below and not below iso, as the
+     * 1D-index of their first voxel in increasing order.
+     */
+    std::vector<std::uint32_t> query(float iso) const;
+
+private:
+    struct Interval {
+        float min;
+        float max;
+        std::uint32_t cell;
+    };
+    struct Entry {
+        float value;
+        std::uint32_t cell;
+    };
+    struct Node {
+        float center;
+        size_t begin;  // range of the node in byMin_ and byMax_
+        size_t end;
+        size_t left;  // index of the child node, or none
+        size_t right;
+    };
+    static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+    size_t build(std::vector<Interval>::iterator begin, std::vector<Interval>::iterator end);
+
+    std::vector<Node> nodes_;
+    std::vector<Entry> byMin_;  // increasing minimum within each node
+    std::vector<Entry> byMax_;  // decreasing maximum within each node
+};
+
+}  // namespace inviwo
+
+#endif  // IVW_SPANSPACEINDEX_H
@@ -0,0 +1,154 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+
+#include <modules/tnm067lab2/utils/sparsevolume.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+#include <algorithm>
+
+namespace inviwo {
+
+constexpr size_t SparseVolume::blockSize;
+constexpr size_t SparseVolume::blockVoxels;
+constexpr std::uint32_t SparseVolume::unallocated;
+
+SparseVolume::SparseVolume(size3_t dims, float background)
+    : dims_(dims)
+    , blockDims_((dims + size3_t(blockSize - 1)) / blockSize)
+    , background_(background)
+    , index_(blockDims_.x * blockDims_.y * blockDims_.z, unallocated)
+    , voxels_()
+    , modelMatrix_(1.0f)
+    , worldMatrix_(1.0f) {}
+
+SparseVolume::SparseVolume(const VolumeRAM& volume, float background)
+    : SparseVolume(volume.getDimensions(), background) {
+    volume.dispatch<void, dispatching::filter::Scalars>([&](auto vrprecision) {
+        const auto data = vrprecision->getDataTyped();
+
+        size3_t block;
+        for (block.z = 0; block.z < blockDims_.z; ++block.z) {
+            for (block.y = 0; block.y < blockDims_.y; ++block.y) {
+                for (block.x = 0; block.x < blockDims_.x; ++block.x) {
+                    const size3_t begin = block * blockSize;
+                    const size3_t end = glm::min(begin + size3_t(blockSize), dims_);
+                    float* voxels = nullptr;
+                    size3_t voxel;
+                    for (voxel.z = begin.z; voxel.z < end.z; ++voxel.z) {
+                        for (voxel.y = begin.y; voxel.y < end.y; ++voxel.y) {
+                            for (voxel.x = begin.x; voxel.x < end.x; ++voxel.x) {
+                                const float value = static_cast<float>(
+                                    data[voxel.x + dims_.x * (voxel.y + dims_.y * voxel.z)]);
+                                if (!voxels && value == background_) continue;
+                                if (!voxels) voxels = allocateBlock(block);
+                                const size3_t local = voxel - begin;
+                                voxels[local.x + blockSize * (local.y + blockSize * local.z)] =
+                                    value;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+void SparseVolume::setValue(const size3_t& voxel, float value) {
+    const size3_t block = voxel / blockSize;
+    if (!getBlock(block) && value == background_) return;
+    const size3_t local = voxel % blockSize;
+    allocateBlock(block)[local.x + blockSize * (local.y + blockSize * local.z)] = value;
+}
+
+float* SparseVolume::allocateBlock(const size3_t& block) {
+    auto& slot = index_[blockIndex(block)];
+    if (slot == unallocated) {
+        slot = static_cast<std::uint32_t>(voxels_.size() / blockVoxels);
+        voxels_.resize(voxels_.size() + blockVoxels, background_);
+    }
+    return voxels_.data() + slot * blockVoxels;
+}
+
+size_t SparseVolume::getAllocatedBlockCount() const { return voxels_.size() / blockVoxels; }
+
+void SparseVolume::copyBox(const size3_t& origin, const size3_t& boxDims, float* dest) const {
+    // block by block, a row of voxels at a time
+    const size3_t end = origin + boxDims;
+    const size3_t firstBlock = origin / blockSize;
+    const size3_t lastBlock = (end - size3_t(1)) / blockSize;
+    size3_t block;
+    for (block.z = firstBlock.z; block.z <= lastBlock.z; ++block.z) {
+        for (block.y = firstBlock.y; block.y <= lastBlock.y; ++block.y) {
+            for (block.x = firstBlock.x; block.x <= lastBlock.x; ++block.x) {
+                const float* voxels = getBlock(block);
+                const size3_t begin = glm::max(origin, block * blockSize);
+                const size3_t stop = glm::min(end, (block + size3_t(1)) * blockSize);
+                for (size_t z = begin.z; z < stop.z; ++z) {
+                    for (size_t y = begin.y; y < stop.y; ++y) {
+                        float* row = dest + (begin.x - origin.x) +
+                                     boxDims.x * (y - origin.y + boxDims.y * (z - origin.z));
+                        if (!voxels) {
+                            std::fill(row, row + (stop.x - begin.x), background_);
+                            continue;
+                        }
+                        const float* source =
+                            voxels + begin.x % blockSize +
+                            blockSize * (y % blockSize + blockSize * (z % blockSize));
+                        std::copy(source, source + (stop.x - begin.x), row);
+                    }
+                }
+            }
+        }
+    }
+}
+
+vec2 SparseVolume::getValueRange() const {
+    vec2 range(background_);
+    for (const auto value : voxels_) {
+        range = vec2(std::min(range.x, value), std::max(range.y, value));
+    }
+    return range;
+}
+
+size_t SparseVolume::getSizeInBytes() const {
+    return index_.size() * sizeof(std::uint32_t) + voxels_.size() * sizeof(float);
+}
+
+const mat4& SparseVolume::getModelMatrix() const { return modelMatrix_; }
+
+void SparseVolume::setModelMatrix(const mat4& modelMatrix) { modelMatrix_ = modelMatrix; }
+
+const mat4& SparseVolume::getWorldMatrix() const { return worldMatrix_; }
+
+void SparseVolume::setWorldMatrix(const mat4& worldMatrix) { worldMatrix_ = worldMatrix; }
+
+}  // namespace inviwo
@@ -0,0 +1,153 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2019 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *********************************************************************************/
+
+
+#ifndef IVW_SPARSEVOLUME_H
+#define IVW_SPARSEVOLUME_H
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/common/inviwo.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace inviwo {
+
+class VolumeRAM;
+
+/**
+ * \class SparseVolume
+ * \brief Scalar volume storing only the blocks of blockSize^3 voxels that differ from a
+ * background value
+ *
+ * A dense index over the blocks gives the slot of each allocated block. Every voxel of a block
+ * that is not allocated has the background value, as outside of the narrow band of a level
+ * set. Blocks on the far borders of the volume are stored at full size, with the voxels past
+ * the border set to the background value.
+ */
+class IVW_MODULE_TNM067LAB2_API SparseVolume {
+public:
+    static constexpr size_t blockSize = 8;
+    static constexpr size_t blockVoxels = blockSize * blockSize * blockSize;
+    static constexpr std::uint32_t unallocated = std::numeric_limits<std::uint32_t>::max();
+
+    SparseVolume(size3_t dims, float background);
+
+    /**
+     * Copy of a dense volume, only allocating the blocks with a voxel other than background.
+     */
+    SparseVolume(const VolumeRAM& volume, float background);
+
+    const size3_t& getDimensions() const;
+
+    /**
+     * Number of blocks along each axis.
+     */
+    const size3_t& getBlockDimensions() const;
+    float getBackground() const;
+
+    float getValue(const size3_t& voxel) const;
+
+    /**
+     * Sets the voxel, allocating its block unless value is the background value.
+     */
+    void setValue(const size3_t& voxel, float value);
+
+    /**
+     * Voxels of the block with x running fastest, null if it is not allocated.
+     */
+    const float* getBlock(const size3_t& block) const;
+
+    /**
+     * Voxels of the block, allocated and set to the background value first if needed. The
+     * pointer is valid until the next block is allocated.
+     */
+    float* allocateBlock(const size3_t& block);
+
+    size_t getAllocatedBlockCount() const;
+
+    /**
+     * Copies the box of boxDims voxels starting at voxel origin into dest, x running fastest.
+     * The box has to be within the volume.
+     */
+    void copyBox(const size3_t& origin, const size3_t& boxDims, float* dest) const;
+
+    /**
+     * Min and max of the background value and the allocated voxels.
+     */
+    vec2 getValueRange() const;
+
+    /**
+     * Memory used by the index and the allocated blocks.
+     */
+    size_t getSizeInBytes() const;
+
+    const mat4& getModelMatrix() const;
+    void setModelMatrix(const mat4& modelMatrix);
+    const mat4& getWorldMatrix() const;
+    void setWorldMatrix(const mat4& worldMatrix);
+
+private:
+    size_t blockIndex(const size3_t& block) const;
+
+    size3_t dims_;
+    size3_t blockDims_;
+    float background_;
+    std::vector<std::uint32_t> index_;  // slot of each block in voxels_, or unallocated
+    std::vector<float> voxels_;         // blockVoxels per allocated block
+    mat4 modelMatrix_;
+    mat4 worldMatrix_;
+};
+
+inline const size3_t& SparseVolume::getDimensions() const { return dims_; }
+
+inline const size3_t& SparseVolume::getBlockDimensions() const { return blockDims_; }
+
+inline float SparseVolume::getBackground() const { return background_; }
+
+inline size_t SparseVolume::blockIndex(const size3_t& block) const {
+    return block.x + blockDims_.x * (block.y + blockDims_.y * block.z);
+}
+
+inline const float* SparseVolume::getBlock(const size3_t& block) const {
+    const auto slot = index_[blockIndex(block)];
+    return slot == unallocated ? nullptr : voxels_.data() + slot * blockVoxels;
+}
+
+inline float SparseVolume::getValue(const size3_t& voxel) const {
+    const float* block = getBlock(voxel / blockSize);
+    if (!block) return background_;
+    const size3_t local = voxel % blockSize;
+    return block[local.x + blockSize * (local.y + blockSize * local.z)];
+}
+
+}  // namespace inviwo
+
+#endif  // IVW_SPARSEVOLUME_H